@@ -0,0 +1,57 @@
+#  Module.mk - Makefile for a Linux module for reading sensor data.
+#  Copyright (C) 2026  The lm-sensors developers
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+#  MA 02110-1301 USA.
+
+# The board database is compiled from all the configuration files in
+# this directory. This is done with a copy of sensors-conf-compile built
+# for the build machine with HOSTCC, so that cross-compiling works. The
+# database is in the byte order of the machine which compiles it, so if
+# the target has the other byte order, run "sensors-conf-compile -b" on
+# the target instead.
+MODULE_DIR := configs
+CONFIGS_DIR := $(MODULE_DIR)
+
+CONFIGSDATADIR := $(DATADIR)/lm-sensors
+CONFIGSTARGETS := $(MODULE_DIR)/boards.bin
+CONFIGSSOURCES := $(wildcard $(MODULE_DIR)/*/*.conf)
+
+CONFIGSHOSTTOOL := $(MODULE_DIR)/sensors-conf-compile-host
+CONFIGSHOSTSOURCES := $(LIBCSOURCES) $(LIBOTHEROBJECTS:.o=.c) \
+                      $(PROGCONFCOMPILESOURCES)
+
+$(CONFIGSHOSTTOOL): $(CONFIGSHOSTSOURCES) lib/conf-parse.h
+	$(HOSTCC) $(HOSTCFLAGS) -I. -DETCDIR="\"$(ETCDIR)\"" \
+		-DDATADIR="\"$(DATADIR)\"" -o $@ $(CONFIGSHOSTSOURCES) \
+		-lm -lpthread
+
+$(CONFIGSTARGETS): $(CONFIGSSOURCES) $(CONFIGSHOSTTOOL)
+	$(CONFIGSHOSTTOOL) -b $(CONFIGS_DIR) -o $@
+
+all-configs: $(CONFIGSTARGETS)
+user :: all-configs
+
+install-configs: all-configs
+	$(MKDIR) $(DESTDIR)$(CONFIGSDATADIR)
+	$(INSTALL) -m 644 $(CONFIGSTARGETS) $(DESTDIR)$(CONFIGSDATADIR)
+user_install :: install-configs
+
+user_uninstall::
+	$(RM) $(DESTDIR)$(CONFIGSDATADIR)/boards.bin
+
+clean-configs:
+	$(RM) $(CONFIGSTARGETS) $(CONFIGSHOSTTOOL)
+clean :: clean-configs
@@ -33,7 +33,7 @@ LIBMAN5FILES := $(MODULE_DIR)/sensors.conf.5
 # changed in a backward incompatible way.  The interface is defined by
 # the public header files - in this case they are error.h and sensors.h.
 LIBMAINVER := 5
-LIBMINORVER := 0.0
+LIBMINORVER := 1.0
 LIBVER := $(LIBMAINVER).$(LIBMINORVER)
 
 # The static lib name, the shared lib name, and the internal ('so') name of
@@ -51,7 +51,13 @@ endif
 
 LIBCSOURCES := $(MODULE_DIR)/data.c $(MODULE_DIR)/general.c \
                $(MODULE_DIR)/error.c $(MODULE_DIR)/access.c \
-               $(MODULE_DIR)/init.c $(MODULE_DIR)/sysfs.c
+               $(MODULE_DIR)/init.c $(MODULE_DIR)/sysfs.c \
+               $(MODULE_DIR)/batch.c $(MODULE_DIR)/fault.c \
+               $(MODULE_DIR)/watch.c $(MODULE_DIR)/subscribe.c \
+               $(MODULE_DIR)/memory.c $(MODULE_DIR)/trace.c \
+               $(MODULE_DIR)/stats.c $(MODULE_DIR)/budget.c \
+               $(MODULE_DIR)/image.c $(MODULE_DIR)/boards.c \
+               $(MODULE_DIR)/virtual.c $(MODULE_DIR)/energy.c
 
 LIBOTHEROBJECTS := $(MODULE_DIR)/conf-parse.o $(MODULE_DIR)/conf-lex.o
 LIBSHOBJECTS := $(LIBCSOURCES:.c=.lo) $(LIBOTHEROBJECTS:.o=.lo)
@@ -63,7 +69,7 @@ LIBHEADERFILES := $(MODULE_DIR)/error.h $(MODULE_DIR)/sensors.h
 
 # How to create the shared library
 $(MODULE_DIR)/$(LIBSHLIBNAME): $(LIBSHOBJECTS) $(LIB_DIR)/libsensors.map
-	$(CC) -shared $(LDFLAGS) -Wl,--version-script=$(LIB_DIR)/libsensors.map -Wl,-soname,$(LIBSHSONAME) -o $@ $(LIBSHOBJECTS) -lc -lm
+	$(CC) -shared $(LDFLAGS) -Wl,--version-script=$(LIB_DIR)/libsensors.map -Wl,-soname,$(LIBSHSONAME) -o $@ $(LIBSHOBJECTS) -lc -lm -lpthread
 
 $(MODULE_DIR)/$(LIBSHSONAME): $(MODULE_DIR)/$(LIBSHLIBNAME)
 	$(RM) $@
@@ -80,9 +86,10 @@ $(MODULE_DIR)/$(LIBSTLIBNAME): $(LIBSTOBJECTS)
 
 # Depencies for non-C sources
 $(MODULE_DIR)/conf-lex.c: $(MODULE_DIR)/conf-lex.l $(MODULE_DIR)/general.h \
-                          $(MODULE_DIR)/data.h $(MODULE_DIR)/conf-parse.h
+                          $(MODULE_DIR)/data.h $(MODULE_DIR)/conf.h \
+                          $(MODULE_DIR)/conf-parse.h
 $(MODULE_DIR)/conf-parse.c: $(MODULE_DIR)/conf-parse.y $(MODULE_DIR)/general.h \
-                            $(MODULE_DIR)/data.h
+                            $(MODULE_DIR)/data.h $(MODULE_DIR)/conf.h
 $(MODULE_DIR)/conf-parse.h: $(MODULE_DIR)/conf-parse.c
 
 # Include all dependency files
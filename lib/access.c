@@ -22,19 +22,44 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <fnmatch.h>
 #include "access.h"
 #include "sensors.h"
 #include "data.h"
 #include "error.h"
 #include "sysfs.h"
+#include "backend.h"
+#include "fault.h"
+#include "stats.h"
+#include "budget.h"
+#include "probes.h"
+#include "energy.h"
 
 /* We watch the recursion depth for variables only, as an easy way to
    detect cycles. */
 #define DEPTH_MAX	8
 
+/* Number of values sensors_compute_values() evaluates an expression for
+   at once */
+#define EVAL_CHUNK	32
+
 static int sensors_eval_expr(const sensors_chip_features *chip_features,
 			     const sensors_expr *expr,
 			     double val, int depth, double *result);
+static int __sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
+			       int depth, double *result);
+
+struct sensors_cycle_value {
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	int err;
+	double value;
+};
+
+/* The outermost read cycle in progress in this thread, if any. Each
+   thread has its own, as the cycle lives on the stack of the thread
+   which started it. */
+static __thread sensors_read_cycle *sensors_cycle;
 
 /* Compare two chips name descriptions, to see whether they could match.
    Return 0 if it does not match, return 1 if it does match. */
@@ -78,6 +103,8 @@ sensors_for_all_config_chips(const sensors_chip_name *name,
 	int nr, i;
 	sensors_chip_name_list chips;
 
+	if (!last)
+		sensors_stats_add(sensors_stats_total.config_lookups, 1);
 	for (nr = last ? last - sensors_config_chips - 1 :
 			 sensors_config_chips_count - 1; nr >= 0; nr--) {
 
@@ -90,10 +117,7 @@ sensors_for_all_config_chips(const sensors_chip_name *name,
 	return NULL;
 }
 
-/* Look up a chip in the intern chip list, and return a pointer to it.
-   Do not modify the struct the return value points to! Returns NULL if
-   not found.*/
-static const sensors_chip_features *
+const sensors_chip_features *
 sensors_lookup_chip(const sensors_chip_name *name)
 {
 	int i;
@@ -101,6 +125,9 @@ sensors_lookup_chip(const sensors_chip_name *name)
 	for (i = 0; i < sensors_proc_chips_count; i++)
 		if (sensors_match_chip(&sensors_proc_chips[i].chip, name))
 			return &sensors_proc_chips[i];
+	for (i = 0; i < sensors_virtual_chips_count; i++)
+		if (sensors_match_chip(&sensors_virtual_chips[i].chip, name))
+			return &sensors_virtual_chips[i];
 
 	return NULL;
 }
@@ -169,7 +196,6 @@ char *sensors_get_label(const sensors_chip_name *name,
 	char *label;
 	const sensors_chip *chip;
 	char buf[PATH_MAX];
-	FILE *f;
 	int i;
 
 	if (sensors_chip_name_has_wildcards(name))
@@ -182,19 +208,11 @@ char *sensors_get_label(const sensors_chip_name *name,
 				goto sensors_get_label_exit;
 			}
 
-	/* No user specified label, check for a _label sysfs file */
-	snprintf(buf, PATH_MAX, "%s/%s_label", name->path, feature->name);
-	
-	if ((f = fopen(buf, "r"))) {
-		i = fread(buf, 1, sizeof(buf), f);
-		fclose(f);
-		if (i > 0) {
-			/* i - 1 to strip the '\n' at the end */
-			buf[i - 1] = 0;
-			label = buf;
-			goto sensors_get_label_exit;
-		}
-	}
+	/* No user specified label, check for a _label attribute */
+	snprintf(buf, PATH_MAX, "%s_label", feature->name);
+	if (!sensors_chip_is_virtual(sensors_lookup_chip(name)) &&
+	    (label = sensors_current_backend->read_text(name->path, buf)))
+		return label;
 
 	/* No label, return the feature name instead */
 	label = feature->name;
@@ -221,6 +239,250 @@ static int sensors_get_ignored(const sensors_chip_name *name,
 	return 0;
 }
 
+/* Look up the compute statement which applies to a subfeature, if any, and
+   return its from_proc (to_proc = 0) or to_proc (to_proc = 1) expression.
+   Returns NULL if no compute statement applies. */
+static const sensors_expr *
+sensors_lookup_compute(const sensors_chip_features *chip_features,
+		       const sensors_subfeature *subfeature, int to_proc)
+{
+	const sensors_feature *feature;
+	const sensors_chip *chip;
+	int i;
+
+	if (!(subfeature->flags & SENSORS_COMPUTE_MAPPING))
+		return NULL;
+
+	feature = sensors_lookup_feature_nr(chip_features, subfeature->mapping);
+
+	for (chip = NULL;
+	     (chip = sensors_for_all_config_chips(&chip_features->chip, chip));)
+		for (i = 0; i < chip->computes_count; i++)
+			if (!strcmp(feature->name, chip->computes[i].name))
+				return to_proc ? chip->computes[i].to_proc :
+						 chip->computes[i].from_proc;
+	return NULL;
+}
+
+/* Look up the define statement of a subfeature of a virtual chip, and
+   return its expression. Returns NULL if there is none. */
+static const sensors_expr *
+sensors_lookup_define(const sensors_chip_features *chip_features,
+		      const sensors_subfeature *subfeature)
+{
+	const sensors_chip *chip;
+	int i;
+
+	for (chip = NULL;
+	     (chip = sensors_for_all_config_chips(&chip_features->chip, chip));)
+		for (i = 0; i < chip->defines_count; i++)
+			if (!strcmp(subfeature->name, chip->defines[i].name))
+				return chip->defines[i].value;
+	return NULL;
+}
+
+/* Look up a readable subfeature of a certain chip. Note that chip should not
+   contain wildcard values! Returns 0 on success, and <0 on failure. */
+int sensors_lookup_readable(const sensors_chip_name *name, int subfeat_nr,
+			    const sensors_chip_features **chip_features,
+			    const sensors_subfeature **subfeature)
+{
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(*chip_features = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+	if (!(*subfeature = sensors_lookup_subfeature_nr(*chip_features,
+							 subfeat_nr)))
+		return -SENSORS_ERR_NO_ENTRY;
+	if (!((*subfeature)->flags & SENSORS_MODE_R))
+		return -SENSORS_ERR_ACCESS_R;
+	return 0;
+}
+
+int sensors_is_computed(const sensors_chip_features *chip_features,
+			const sensors_subfeature *subfeature)
+{
+	return sensors_chip_is_virtual(chip_features) ||
+	       (sensors_energy_counter(chip_features, subfeature) &&
+		sensors_energy_sampled(chip_features, subfeature));
+}
+
+/* Evaluate a compute or set expression, as opposed to a subexpression */
+static int sensors_eval(const sensors_chip_features *chip_features,
+			const sensors_expr *expr, double val, int depth,
+			double *result)
+{
+	int res;
+
+	sensors_stats_eval(chip_features);
+	SENSORS_PROBE1(eval__start, chip_features->chip.path);
+	res = sensors_eval_expr(chip_features, expr, val, depth, result);
+	SENSORS_PROBE2(eval__end, chip_features->chip.path, res);
+
+	return res;
+}
+
+/* Compute the value of a subfeature of a virtual chip */
+static int sensors_eval_define(const sensors_chip_features *chip_features,
+			       const sensors_subfeature *subfeature,
+			       int depth, double *result)
+{
+	const sensors_expr *expr;
+
+	expr = sensors_lookup_define(chip_features, subfeature);
+	if (!expr)
+		return -SENSORS_ERR_NO_ENTRY;
+	return sensors_eval(chip_features, expr, 0, depth, result);
+}
+
+static int __sensors_apply_compute(const sensors_chip_features *chip_features,
+				   const sensors_subfeature *subfeature,
+				   double val, int depth, double *result)
+{
+	const sensors_expr *expr;
+
+	expr = sensors_lookup_compute(chip_features, subfeature, 0);
+	if (!expr) {
+		*result = val;
+		return 0;
+	}
+	return sensors_eval(chip_features, expr, val, depth, result);
+}
+
+/* Apply the compute statement of a subfeature, if any, to a value which
+   was just read from the kernel. Returns 0 on success, and <0 on failure. */
+int sensors_apply_compute(const sensors_chip_features *chip_features,
+			  const sensors_subfeature *subfeature,
+			  double val, double *result)
+{
+	return __sensors_apply_compute(chip_features, subfeature, val, 0,
+				       result);
+}
+
+/* Check whether an expression is of the form a * @ + b, where a and b are
+   constants. Returns 1 if it is, 0 if not. */
+static int sensors_expr_affine(const sensors_expr *expr, double *a, double *b)
+{
+	double a1, b1, a2 = 0, b2 = 0;
+
+	switch (expr->kind) {
+	case sensors_kind_val:
+		*a = 0;
+		*b = expr->data.val;
+		return 1;
+	case sensors_kind_source:
+		*a = 1;
+		*b = 0;
+		return 1;
+	case sensors_kind_var:
+		return 0;
+	case sensors_kind_sub:
+		break;
+	}
+
+	if (!sensors_expr_affine(expr->data.subexpr.sub1, &a1, &b1))
+		return 0;
+	if (expr->data.subexpr.sub2 &&
+	    !sensors_expr_affine(expr->data.subexpr.sub2, &a2, &b2))
+		return 0;
+
+	switch (expr->data.subexpr.op) {
+	case sensors_add:
+		*a = a1 + a2;
+		*b = b1 + b2;
+		return 1;
+	case sensors_sub:
+		*a = a1 - a2;
+		*b = b1 - b2;
+		return 1;
+	case sensors_multiply:
+		if (a1 != 0 && a2 != 0)
+			return 0;
+		*a = a1 * b2 + a2 * b1;
+		*b = b1 * b2;
+		return 1;
+	case sensors_divide:
+		if (a2 != 0 || b2 == 0)
+			return 0;
+		*a = a1 / b2;
+		*b = b1 / b2;
+		return 1;
+	case sensors_negate:
+		*a = -a1;
+		*b = -b1;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static int is_integral(double x)
+{
+	return fabs(x) < RAW_MAX &&
+	       fabs(x - llround(x)) <= 1e-9 * (fabs(x) > 1 ? fabs(x) : 1);
+}
+
+/* Compute a * raw + b in fixed point, if a and b have few enough
+   decimals. Returns 0 on success, and -1 if it can't be done exactly. */
+static int sensors_affine_raw(double a, double b, long long raw,
+			      sensors_raw_value *result)
+{
+	double scale_a = 1, scale_b;
+	int i, k;
+
+	/* b is in units, while raw is in units * 10^exponent */
+	for (scale_b = 1, i = result->exponent; i < 0; i++)
+		scale_b *= 10;
+
+	for (k = 0; k <= 6; k++, scale_a *= 10, scale_b *= 10) {
+		if (!is_integral(a * scale_a) || !is_integral(b * scale_b))
+			continue;
+		if (fabs(a * scale_a) * fabs((double)raw) +
+		    fabs(b * scale_b) >= RAW_MAX)
+			return -1;
+		result->value = llround(a * scale_a) * raw +
+				llround(b * scale_b);
+		result->exponent -= k;
+		return 0;
+	}
+	return -1;
+}
+
+/* Apply the compute statement of a subfeature, if any, to a raw value
+   which was just read from the kernel, in fixed point if possible.
+   Returns 0 on success, and <0 on failure. */
+int sensors_apply_compute_raw(const sensors_chip_features *chip_features,
+			      const sensors_subfeature *subfeature,
+			      long long raw, sensors_raw_value *result)
+{
+	const sensors_expr *expr;
+	double a, b, val, scaling;
+	int i, res;
+
+	result->value = raw;
+	result->exponent = sensors_get_type_exponent(subfeature->type);
+	result->unit = sensors_get_type_unit(subfeature->type);
+
+	expr = sensors_lookup_compute(chip_features, subfeature, 0);
+	if (!expr)
+		return 0;
+	if (sensors_expr_affine(expr, &a, &b) &&
+	    !sensors_affine_raw(a, b, raw, result)) {
+		sensors_stats_eval(chip_features);
+		return 0;
+	}
+
+	/* Fall back to floating point */
+	for (scaling = 1, i = result->exponent; i < 0; i++)
+		scaling *= 10;
+	if ((res = sensors_eval(chip_features, expr, raw / scaling, 0, &val)))
+		return res;
+	if (fabs(val * scaling) >= RAW_MAX)
+		return -SENSORS_ERR_ACCESS_R;
+	result->value = llround(val * scaling);
+	return 0;
+}
+
 /* Read the value of a subfeature of a certain chip. Note that chip should not
    contain wildcard values! This function will return 0 on success, and <0
    on failure. */
@@ -229,57 +491,107 @@ static int __sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
 {
 	const sensors_chip_features *chip_features;
 	const sensors_subfeature *subfeature;
-	const sensors_expr *expr = NULL;
+	sensors_subfeature_state *state;
+	sensors_timestamp ts;
 	double val;
-	int res, i;
+	int res, derived;
 
 	if (depth >= DEPTH_MAX)
 		return -SENSORS_ERR_RECURSION;
-	if (sensors_chip_name_has_wildcards(name))
-		return -SENSORS_ERR_WILDCARDS;
-	if (!(chip_features = sensors_lookup_chip(name)))
-		return -SENSORS_ERR_NO_ENTRY;
-	if (!(subfeature = sensors_lookup_subfeature_nr(chip_features,
-							subfeat_nr)))
-		return -SENSORS_ERR_NO_ENTRY;
-	if (!(subfeature->flags & SENSORS_MODE_R))
-		return -SENSORS_ERR_ACCESS_R;
-
-	/* Apply compute statement if it exists */
-	if (subfeature->flags & SENSORS_COMPUTE_MAPPING) {
-		const sensors_feature *feature;
-		const sensors_chip *chip;
-
-		feature = sensors_lookup_feature_nr(chip_features,
-					subfeature->mapping);
-
-		chip = NULL;
-		while (!expr &&
-		       (chip = sensors_for_all_config_chips(name, chip)))
-			for (i = 0; i < chip->computes_count; i++) {
-				if (!strcmp(feature->name,
-					    chip->computes[i].name)) {
-					expr = chip->computes[i].from_proc;
-					break;
-				}
-			}
-	}
-
-	res = sensors_read_sysfs_attr(name, subfeature, &val);
-	if (res)
+	if ((res = sensors_lookup_readable(name, subfeat_nr, &chip_features,
+					   &subfeature)))
 		return res;
-	if (!expr)
-		*result = val;
-	else if ((res = sensors_eval_expr(chip_features, expr, val, depth,
-					  result)))
+	if ((res = sensors_fault_check(chip_features, subfeature)))
 		return res;
-	return 0;
+
+	state = &chip_features->state[subfeature->number];
+	derived = sensors_energy_counter(chip_features, subfeature) != NULL;
+
+	ts.start = sensors_stats_now();
+	if (sensors_chip_is_virtual(chip_features))
+		res = sensors_eval_define(chip_features, subfeature, depth,
+					  &val);
+	else if (derived)
+		res = sensors_energy_read(chip_features, subfeature);
+	else
+		res = sensors_read_sysfs_attr(name, subfeature, state, &val);
+	ts.end = sensors_stats_now();
+	sensors_stats_read(chip_features, res, ts.end - ts.start);
+	sensors_fault_record(chip_features, subfeature, res);
+	if (!res && derived)
+		res = sensors_energy_power(chip_features, subfeature, &val);
+	if (!res)
+		res = __sensors_apply_compute(chip_features, subfeature, val,
+					      depth, result);
+	sensors_budget_record(chip_features, subfeature, res ? NULL : result,
+			      &ts);
+	return res;
 }
 
 int sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
 		      double *result)
 {
-	return __sensors_get_value(name, subfeat_nr, 0, result);
+	const sensors_chip_features *chip_features;
+	const sensors_subfeature *subfeature;
+	sensors_read_cycle cycle;
+	int res;
+
+	/* Chips with a deadline are read from a worker thread */
+	if (!sensors_lookup_readable(name, subfeat_nr, &chip_features,
+				     &subfeature) && chip_features->timeout_ms &&
+	    !sensors_is_computed(chip_features, subfeature))
+		return sensors_get_value_timeout(name, subfeat_nr, 0, result);
+
+	sensors_cycle_begin(&cycle);
+	res = __sensors_get_value(name, subfeat_nr, 0, result);
+	sensors_cycle_end(&cycle);
+	return res;
+}
+
+int sensors_set_chip_timeout(const sensors_chip_name *name, int timeout_ms)
+{
+	int i, found = 0;
+
+	if (timeout_ms < 0)
+		timeout_ms = 0;
+
+	for (i = 0; i < sensors_proc_chips_count; i++)
+		if (sensors_match_chip(&sensors_proc_chips[i].chip, name)) {
+			sensors_proc_chips[i].timeout_ms = timeout_ms;
+			found = 1;
+		}
+
+	return found ? 0 : -SENSORS_ERR_NO_ENTRY;
+}
+
+/* Set the value of a subfeature of an already looked up chip. This
+   function will return 0 on success, and <0 on failure. */
+static int __sensors_set_value(const sensors_chip_features *chip_features,
+			       int subfeat_nr, double value,
+			       unsigned int flags)
+{
+	const sensors_subfeature *subfeature;
+	const sensors_expr *expr;
+	int res;
+	double to_write;
+
+	if (!(subfeature = sensors_lookup_subfeature_nr(chip_features,
+							subfeat_nr)))
+		return -SENSORS_ERR_NO_ENTRY;
+	if (!(subfeature->flags & SENSORS_MODE_W))
+		return -SENSORS_ERR_ACCESS_W;
+	sensors_stats_write(chip_features);
+
+	/* Apply compute statement if it exists */
+	to_write = value;
+	expr = sensors_lookup_compute(chip_features, subfeature, 1);
+	if (expr)
+		if ((res = sensors_eval(chip_features, expr,
+					value, 0, &to_write)))
+			return res;
+	return sensors_write_sysfs_attr(&chip_features->chip, subfeature,
+					&chip_features->state[subfeat_nr],
+					to_write, flags);
 }
 
 /* Set the value of a subfeature of a certain chip. Note that chip should not
@@ -287,49 +599,42 @@ int sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
    on failure. */
 int sensors_set_value(const sensors_chip_name *name, int subfeat_nr,
 		      double value)
+{
+	return sensors_set_value_flags(name, subfeat_nr, value,
+				       SENSORS_SET_FORCE);
+}
+
+int sensors_set_value_flags(const sensors_chip_name *name, int subfeat_nr,
+			    double value, unsigned int flags)
 {
 	const sensors_chip_features *chip_features;
-	const sensors_subfeature *subfeature;
-	const sensors_expr *expr = NULL;
-	int i, res;
-	double to_write;
 
 	if (sensors_chip_name_has_wildcards(name))
 		return -SENSORS_ERR_WILDCARDS;
 	if (!(chip_features = sensors_lookup_chip(name)))
 		return -SENSORS_ERR_NO_ENTRY;
-	if (!(subfeature = sensors_lookup_subfeature_nr(chip_features,
-							subfeat_nr)))
+	return __sensors_set_value(chip_features, subfeat_nr, value, flags);
+}
+
+int sensors_set_values(const sensors_chip_name *name,
+		       const sensors_set_request *req, int count,
+		       unsigned int flags)
+{
+	const sensors_chip_features *chip_features;
+	int i, res, err = 0;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip_features = sensors_lookup_chip(name)))
 		return -SENSORS_ERR_NO_ENTRY;
-	if (!(subfeature->flags & SENSORS_MODE_W))
-		return -SENSORS_ERR_ACCESS_W;
 
-	/* Apply compute statement if it exists */
-	if (subfeature->flags & SENSORS_COMPUTE_MAPPING) {
-		const sensors_feature *feature;
-		const sensors_chip *chip;
-
-		feature = sensors_lookup_feature_nr(chip_features,
-					subfeature->mapping);
-
-		chip = NULL;
-		while (!expr &&
-		       (chip = sensors_for_all_config_chips(name, chip)))
-			for (i = 0; i < chip->computes_count; i++) {
-				if (!strcmp(feature->name,
-					    chip->computes[i].name)) {
-					expr = chip->computes[i].to_proc;
-					break;
-				}
-			}
+	for (i = 0; i < count; i++) {
+		res = __sensors_set_value(chip_features, req[i].subfeat_nr,
+					  req[i].value, flags);
+		if (res)
+			err = res;
 	}
-
-	to_write = value;
-	if (expr)
-		if ((res = sensors_eval_expr(chip_features, expr,
-					     value, 0, &to_write)))
-			return res;
-	return sensors_write_sysfs_attr(name, subfeature, to_write);
+	return err;
 }
 
 const sensors_chip_name *sensors_get_detected_chips(const sensors_chip_name
@@ -337,8 +642,13 @@ const sensors_chip_name *sensors_get_detected_chips(const sensors_chip_name
 {
 	const sensors_chip_name *res;
 
-	while (*nr < sensors_proc_chips_count) {
-		res = &sensors_proc_chips[(*nr)++].chip;
+	/* Virtual chips come after all detected chips */
+	while (*nr < sensors_proc_chips_count + sensors_virtual_chips_count) {
+		if (*nr < sensors_proc_chips_count)
+			res = &sensors_proc_chips[(*nr)++].chip;
+		else
+			res = &sensors_virtual_chips[(*nr)++ -
+						     sensors_proc_chips_count].chip;
 		if (!match || sensors_match_chip(res, match))
 			return res;
 	}
@@ -438,39 +748,286 @@ sensors_get_subfeature(const sensors_chip_name *name,
 	return NULL;	/* No such subfeature */
 }
 
-/* Evaluate an expression */
-static int sensors_eval_expr(const sensors_chip_features *chip_features,
-			     const sensors_expr *expr,
-			     double val, int depth, double *result)
+void sensors_cycle_begin(sensors_read_cycle *cycle)
 {
-	double res1, res2;
-	int res;
-	const sensors_subfeature *subfeature;
+	cycle->values = NULL;
+	cycle->count = cycle->max = 0;
+	if (!sensors_cycle)
+		sensors_cycle = cycle;
+}
 
-	if (expr->kind == sensors_kind_val) {
-		*result = expr->data.val;
-		return 0;
+void sensors_cycle_end(sensors_read_cycle *cycle)
+{
+	if (sensors_cycle == cycle)
+		sensors_cycle = NULL;
+	free(cycle->values);
+}
+
+void sensors_cycle_add(const sensors_chip_features *chip_features,
+		       const sensors_subfeature *subfeature, int err,
+		       double value)
+{
+	struct sensors_cycle_value new_el;
+
+	if (!sensors_cycle)
+		return;
+	new_el.chip = chip_features;
+	new_el.subfeature = subfeature;
+	new_el.err = err;
+	new_el.value = value;
+	sensors_add_array_el(&new_el, &sensors_cycle->values,
+			     &sensors_cycle->count, &sensors_cycle->max,
+			     sizeof(struct sensors_cycle_value));
+}
+
+/* Read a subfeature used as a variable, only once per read cycle */
+static int sensors_read_var(const sensors_chip_features *chip_features,
+			    const sensors_subfeature *subfeature, int depth,
+			    double *result)
+{
+	const struct sensors_cycle_value *v;
+	int i, res;
+
+	if (sensors_cycle) {
+		for (i = 0; i < sensors_cycle->count; i++) {
+			v = &sensors_cycle->values[i];
+			if (v->chip == chip_features &&
+			    v->subfeature == subfeature) {
+				*result = v->value;
+				return v->err;
+			}
+		}
 	}
-	if (expr->kind == sensors_kind_source) {
-		*result = val;
+
+	res = __sensors_get_value(&chip_features->chip, subfeature->number,
+				  depth + 1, result);
+	sensors_cycle_add(chip_features, subfeature, res, res ? 0 : *result);
+	return res;
+}
+
+/* The subfeatures a variable stands for. A variable is either the name
+   of a subfeature of the same chip, or a chip name and a subfeature name
+   separated by a colon, which refers to readable subfeatures of detected
+   chips. Both names may have wildcards. */
+struct sensors_var_iter {
+	const sensors_chip_features *self;
+	sensors_chip_name match;
+	int has_chip;
+	const char *pattern;	/* Subfeature name */
+	int chip_nr, subfeat_nr;
+};
+
+static int sensors_var_iter_init(struct sensors_var_iter *it,
+				 const sensors_chip_features *chip_features,
+				 const char *var)
+{
+	const char *colon;
+	char *name;
+	int res;
+
+	it->self = chip_features;
+	it->chip_nr = it->subfeat_nr = 0;
+	colon = strchr(var, ':');
+	if (!colon) {
+		it->has_chip = 0;
+		it->pattern = var;
 		return 0;
 	}
-	if (expr->kind == sensors_kind_var) {
-		if (!(subfeature = sensors_lookup_subfeature_name(chip_features,
-							    expr->data.var)))
-			return -SENSORS_ERR_NO_ENTRY;
-		return __sensors_get_value(&chip_features->chip,
-					   subfeature->number, depth + 1,
-					   result);
+
+	name = strndup(var, colon - var);
+	if (!name)
+		sensors_fatal_error(__func__, "Out of memory");
+	res = sensors_parse_chip_name(name, &it->match);
+	free(name);
+	if (res)
+		return -SENSORS_ERR_CHIP_NAME;
+	it->has_chip = 1;
+	it->pattern = colon + 1;
+	return 0;
+}
+
+static void sensors_var_iter_exit(struct sensors_var_iter *it)
+{
+	if (it->has_chip && it->match.prefix != SENSORS_CHIP_NAME_PREFIX_ANY)
+		free(it->match.prefix);
+}
+
+/* Find the next subfeature the variable stands for. Returns 1 if one was
+   found, 0 if there are no more. */
+static int sensors_var_iter_next(struct sensors_var_iter *it,
+				 const sensors_chip_features **chip_features,
+				 const sensors_subfeature **subfeature)
+{
+	const sensors_chip_features *chip;
+	const sensors_subfeature *sub;
+
+	for (;; it->chip_nr++, it->subfeat_nr = 0) {
+		if (it->has_chip) {
+			if (it->chip_nr >= sensors_proc_chips_count)
+				return 0;
+			chip = &sensors_proc_chips[it->chip_nr];
+			if (!sensors_match_chip(&chip->chip, &it->match))
+				continue;
+		} else {
+			if (it->chip_nr)
+				return 0;
+			chip = it->self;
+		}
+
+		while (it->subfeat_nr < chip->subfeature_count) {
+			sub = &chip->subfeature[it->subfeat_nr++];
+			if (it->has_chip && !(sub->flags & SENSORS_MODE_R))
+				continue;
+			if (!fnmatch(it->pattern, sub->name, 0)) {
+				*chip_features = chip;
+				*subfeature = sub;
+				return 1;
+			}
+		}
 	}
-	if ((res = sensors_eval_expr(chip_features, expr->data.subexpr.sub1,
-				     val, depth, &res1)))
+}
+
+/* Evaluate a variable. If it stands for several subfeatures, the first
+   one is used. */
+static int sensors_eval_var(const sensors_chip_features *chip_features,
+			    const char *var, int depth, double *result)
+{
+	struct sensors_var_iter it;
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	int res;
+
+	if ((res = sensors_var_iter_init(&it, chip_features, var)))
 		return res;
-	if (expr->data.subexpr.sub2 &&
-	    (res = sensors_eval_expr(chip_features, expr->data.subexpr.sub2,
-				     val, depth, &res2)))
+	if (sensors_var_iter_next(&it, &chip, &subfeature))
+		res = sensors_read_var(chip, subfeature, depth, result);
+	else
+		res = -SENSORS_ERR_NO_ENTRY;
+	sensors_var_iter_exit(&it);
+	return res;
+}
+
+/* Evaluate an aggregate, over all the subfeatures a variable stands for
+   which could be read. Fails if none could. */
+static int sensors_eval_agg(const sensors_chip_features *chip_features,
+			    sensors_operation op, const char *var, int depth,
+			    double *result)
+{
+	struct sensors_var_iter it;
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	double value, acc = 0;
+	int n = 0, res, err = -SENSORS_ERR_NO_ENTRY;
+
+	if ((res = sensors_var_iter_init(&it, chip_features, var)))
 		return res;
-	switch (expr->data.subexpr.op) {
+	while (sensors_var_iter_next(&it, &chip, &subfeature)) {
+		if ((res = sensors_read_var(chip, subfeature, depth, &value))) {
+			err = res;
+			continue;
+		}
+		if (!n++)
+			acc = value;
+		else if (op == sensors_agg_min)
+			acc = value < acc ? value : acc;
+		else if (op == sensors_agg_max)
+			acc = value > acc ? value : acc;
+		else
+			acc += value;
+	}
+	sensors_var_iter_exit(&it);
+
+	if (!n)
+		return err;
+	*result = op == sensors_agg_avg ? acc / n : acc;
+	return 0;
+}
+
+/* Subfeatures of virtual chips already visited by sensors_virtual_sources() */
+struct sensors_sources {
+	void (*fn)(const sensors_chip_features *, const sensors_subfeature *,
+		   void *);
+	void *data;
+	const sensors_subfeature **seen;
+	int seen_count;
+	int seen_max;
+};
+
+static void sensors_define_sources(struct sensors_sources *sources,
+				   const sensors_chip_features *chip_features,
+				   const sensors_subfeature *subfeature);
+
+static void sensors_expr_sources(struct sensors_sources *sources,
+				 const sensors_chip_features *chip_features,
+				 const sensors_expr *expr)
+{
+	struct sensors_var_iter it;
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+
+	switch (expr->kind) {
+	case sensors_kind_var:
+		if (sensors_var_iter_init(&it, chip_features, expr->data.var))
+			return;
+		while (sensors_var_iter_next(&it, &chip, &subfeature)) {
+			if (sensors_chip_is_virtual(chip))
+				sensors_define_sources(sources, chip,
+						       subfeature);
+			else
+				sources->fn(chip, subfeature, sources->data);
+		}
+		sensors_var_iter_exit(&it);
+		return;
+	case sensors_kind_sub:
+		sensors_expr_sources(sources, chip_features,
+				     expr->data.subexpr.sub1);
+		if (expr->data.subexpr.sub2)
+			sensors_expr_sources(sources, chip_features,
+					     expr->data.subexpr.sub2);
+		return;
+	default:
+		return;
+	}
+}
+
+static void sensors_define_sources(struct sensors_sources *sources,
+				   const sensors_chip_features *chip_features,
+				   const sensors_subfeature *subfeature)
+{
+	const sensors_expr *expr;
+	int i;
+
+	for (i = 0; i < sources->seen_count; i++)
+		if (sources->seen[i] == subfeature)
+			return;
+	sensors_add_array_el(&subfeature, &sources->seen, &sources->seen_count,
+			     &sources->seen_max, sizeof(sensors_subfeature *));
+
+	expr = sensors_lookup_define(chip_features, subfeature);
+	if (expr)
+		sensors_expr_sources(sources, chip_features, expr);
+}
+
+void sensors_virtual_sources(const sensors_chip_features *chip_features,
+			     const sensors_subfeature *subfeature,
+			     void (*fn)(const sensors_chip_features *,
+					const sensors_subfeature *, void *),
+			     void *data)
+{
+	struct sensors_sources sources;
+
+	memset(&sources, 0, sizeof(sources));
+	sources.fn = fn;
+	sources.data = data;
+	sensors_define_sources(&sources, chip_features, subfeature);
+	free(sources.seen);
+}
+
+/* Apply an operation to the values of its operands */
+static int sensors_apply_op(sensors_operation op, double res1, double res2,
+			    double *result)
+{
+	switch (op) {
 	case sensors_add:
 		*result = res1 + res2;
 		return 0;
@@ -496,6 +1053,210 @@ static int sensors_eval_expr(const sensors_chip_features *chip_features,
 			return -SENSORS_ERR_DIV_ZERO;
 		*result = log(res1);
 		return 0;
+	case sensors_min:
+		*result = res1 < res2 ? res1 : res2;
+		return 0;
+	case sensors_max:
+		*result = res1 > res2 ? res1 : res2;
+		return 0;
+	case sensors_abs:
+		*result = fabs(res1);
+		return 0;
+	case sensors_lt:
+		*result = res1 < res2;
+		return 0;
+	case sensors_le:
+		*result = res1 <= res2;
+		return 0;
+	case sensors_gt:
+		*result = res1 > res2;
+		return 0;
+	case sensors_ge:
+		*result = res1 >= res2;
+		return 0;
+	case sensors_eq:
+		*result = res1 == res2;
+		return 0;
+	case sensors_ne:
+		*result = res1 != res2;
+		return 0;
+	case sensors_cond:
+	case sensors_choice:
+	case sensors_agg_min:
+	case sensors_agg_max:
+	case sensors_agg_sum:
+	case sensors_agg_avg:
+		break;
+	}
+	return 0;
+}
+
+/* Evaluate an expression */
+static int sensors_eval_expr(const sensors_chip_features *chip_features,
+			     const sensors_expr *expr,
+			     double val, int depth, double *result)
+{
+	double res1, res2 = 0;
+	int res;
+	const sensors_expr *choice;
+
+	if (expr->kind == sensors_kind_val) {
+		*result = expr->data.val;
+		return 0;
+	}
+	if (expr->kind == sensors_kind_source) {
+		*result = val;
+		return 0;
+	}
+	if (expr->kind == sensors_kind_var)
+		return sensors_eval_var(chip_features, expr->data.var, depth,
+					result);
+	if (expr->data.subexpr.op >= sensors_agg_min)
+		return sensors_eval_agg(chip_features, expr->data.subexpr.op,
+					expr->data.subexpr.sub1->data.var,
+					depth, result);
+	if ((res = sensors_eval_expr(chip_features, expr->data.subexpr.sub1,
+				     val, depth, &res1)))
+		return res;
+
+	/* Only the branch of a conditional which was chosen is evaluated */
+	if (expr->data.subexpr.op == sensors_cond) {
+		choice = expr->data.subexpr.sub2;
+		return sensors_eval_expr(chip_features, res1 != 0.0 ?
+					 choice->data.subexpr.sub1 :
+					 choice->data.subexpr.sub2,
+					 val, depth, result);
+	}
+
+	if (expr->data.subexpr.sub2 &&
+	    (res = sensors_eval_expr(chip_features, expr->data.subexpr.sub2,
+				     val, depth, &res2)))
+		return res;
+	return sensors_apply_op(expr->data.subexpr.op, res1, res2, result);
+}
+
+/* Evaluate an expression for count values of @ at once, at most
+   EVAL_CHUNK, one operation after the other. Each result has its own
+   error code, so that errors in the branch of a conditional which was
+   not chosen can be ignored. Variables are only read once. */
+static void sensors_eval_chunk(const sensors_chip_features *chip_features,
+			       const sensors_expr *expr, const double *val,
+			       int count, double *result, int *err)
+{
+	const sensors_expr *choice;
+	double value = 0, res2[EVAL_CHUNK], res3[EVAL_CHUNK];
+	int err2[EVAL_CHUNK], err3[EVAL_CHUNK];
+	int i, res = 0;
+
+	switch (expr->kind) {
+	case sensors_kind_val:
+		for (i = 0; i < count; i++) {
+			result[i] = expr->data.val;
+			err[i] = 0;
+		}
+		return;
+	case sensors_kind_source:
+		memcpy(result, val, count * sizeof(double));
+		memset(err, 0, count * sizeof(int));
+		return;
+	case sensors_kind_var:
+		res = sensors_eval_var(chip_features, expr->data.var, 0,
+				       &value);
+		for (i = 0; i < count; i++) {
+			result[i] = value;
+			err[i] = res;
+		}
+		return;
+	case sensors_kind_sub:
+		break;
+	}
+
+	if (expr->data.subexpr.op >= sensors_agg_min) {
+		res = sensors_eval_agg(chip_features, expr->data.subexpr.op,
+				       expr->data.subexpr.sub1->data.var, 0,
+				       &value);
+		for (i = 0; i < count; i++) {
+			result[i] = value;
+			err[i] = res;
+		}
+		return;
+	}
+
+	sensors_eval_chunk(chip_features, expr->data.subexpr.sub1, val, count,
+			   result, err);
+
+	if (expr->data.subexpr.op == sensors_cond) {
+		choice = expr->data.subexpr.sub2;
+		sensors_eval_chunk(chip_features, choice->data.subexpr.sub1,
+				   val, count, res2, err2);
+		sensors_eval_chunk(chip_features, choice->data.subexpr.sub2,
+				   val, count, res3, err3);
+		for (i = 0; i < count; i++) {
+			if (err[i])
+				continue;
+			if (result[i] != 0.0) {
+				result[i] = res2[i];
+				err[i] = err2[i];
+			} else {
+				result[i] = res3[i];
+				err[i] = err3[i];
+			}
+		}
+		return;
+	}
+
+	if (expr->data.subexpr.sub2)
+		sensors_eval_chunk(chip_features, expr->data.subexpr.sub2,
+				   val, count, res2, err2);
+	else
+		memset(err2, 0, count * sizeof(int));
+	for (i = 0; i < count; i++) {
+		if (!err[i])
+			err[i] = err2[i];
+		if (!err[i])
+			err[i] = sensors_apply_op(expr->data.subexpr.op,
+						  result[i], res2[i],
+						  &result[i]);
+	}
+}
+
+int sensors_compute_values(const sensors_chip_name *name, int subfeat_nr,
+			   const double *in, double *out, int count)
+{
+	const sensors_chip_features *chip_features;
+	const sensors_subfeature *subfeature;
+	const sensors_expr *expr;
+	double a, b, val[EVAL_CHUNK];
+	int err[EVAL_CHUNK];
+	int i, j, n, res;
+
+	if (count < 0)
+		return -SENSORS_ERR_NO_ENTRY;
+	if ((res = sensors_lookup_readable(name, subfeat_nr, &chip_features,
+					   &subfeature)))
+		return res;
+
+	expr = sensors_lookup_compute(chip_features, subfeature, 0);
+	if (!expr) {
+		memmove(out, in, count * sizeof(double));
+		return 0;
+	}
+	sensors_stats_evals(chip_features, count);
+
+	if (sensors_expr_affine(expr, &a, &b)) {
+		for (i = 0; i < count; i++)
+			out[i] = a * in[i] + b;
+		return 0;
+	}
+
+	for (i = 0; i < count; i += n) {
+		n = count - i < EVAL_CHUNK ? count - i : EVAL_CHUNK;
+		/* out may be in */
+		memcpy(val, in + i, n * sizeof(double));
+		sensors_eval_chunk(chip_features, expr, val, n, out + i, err);
+		for (j = 0; j < n; j++)
+			if (err[j])
+				return err[j];
 	}
 	return 0;
 }
@@ -526,9 +1287,9 @@ static int sensors_do_this_chip_sets(const sensors_chip_name *name)
 				continue;
 			}
 
-			res = sensors_eval_expr(chip_features,
-						chip->sets[i].value, 0,
-						0, &value);
+			res = sensors_eval(chip_features,
+					   chip->sets[i].value, 0,
+					   0, &value);
 			if (res) {
 				sensors_parse_error_wfn("Error parsing expression",
 						    chip->sets[i].line.filename,
@@ -536,8 +1297,9 @@ static int sensors_do_this_chip_sets(const sensors_chip_name *name)
 				err = res;
 				continue;
 			}
-			if ((res = sensors_set_value(name, subfeature->number,
-						     value))) {
+			if ((res = __sensors_set_value(chip_features,
+						subfeature->number, value,
+						SENSORS_SET_FORCE))) {
 				sensors_parse_error_wfn("Failed to set value",
 						chip->sets[i].line.filename,
 						chip->sets[i].line.lineno);
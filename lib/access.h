@@ -30,4 +30,64 @@
    if there are wildcards. */
 int sensors_chip_name_has_wildcards(const sensors_chip_name *chip);
 
+/* Look up a chip in the intern chip list, and return a pointer to it.
+   Do not modify the struct the return value points to! Returns NULL if
+   not found.*/
+const sensors_chip_features *
+sensors_lookup_chip(const sensors_chip_name *name);
+
+/* Look up a readable subfeature of a certain chip. Note that chip should not
+   contain wildcard values! Returns 0 on success, and <0 on failure. */
+int sensors_lookup_readable(const sensors_chip_name *name, int subfeat_nr,
+			    const sensors_chip_features **chip_features,
+			    const sensors_subfeature **subfeature);
+
+/* Check whether a subfeature is computed without reading any attribute of
+   its chip: those of virtual chips, and derived power subfeatures whose
+   counter is sampled in the background */
+int sensors_is_computed(const sensors_chip_features *chip_features,
+			const sensors_subfeature *subfeature);
+
+/* Apply the compute statement of a subfeature, if any, to a value which
+   was just read from the kernel. Returns 0 on success, and <0 on failure. */
+int sensors_apply_compute(const sensors_chip_features *chip_features,
+			  const sensors_subfeature *subfeature,
+			  double val, double *result);
+
+/* Largest integer we are willing to handle in fixed point */
+#define RAW_MAX		9e18
+
+/* Same as above, for a raw integer value. Compute statements of the form
+   a * @ + b are applied in fixed point when a and b have few enough
+   decimals, others in floating point. */
+int sensors_apply_compute_raw(const sensors_chip_features *chip_features,
+			      const sensors_subfeature *subfeature,
+			      long long raw, sensors_raw_value *result);
+
+/* During a read cycle, each subfeature which expressions use as a
+   variable is read only once, and all expressions get the same value.
+   Read cycles may be nested, the outermost one is the one which counts.
+   Each thread has its own read cycle.
+   Values read otherwise during the cycle can be handed over with
+   sensors_cycle_add(), so that they are not read again. */
+typedef struct sensors_read_cycle {
+	struct sensors_cycle_value *values;
+	int count;
+	int max;
+} sensors_read_cycle;
+
+void sensors_cycle_begin(sensors_read_cycle *cycle);
+void sensors_cycle_end(sensors_read_cycle *cycle);
+void sensors_cycle_add(const sensors_chip_features *chip_features,
+		       const sensors_subfeature *subfeature, int err,
+		       double value);
+
+/* Call fn for each subfeature of a detected chip which the computation
+   of a subfeature of a virtual chip may read */
+void sensors_virtual_sources(const sensors_chip_features *chip_features,
+			     const sensors_subfeature *subfeature,
+			     void (*fn)(const sensors_chip_features *,
+					const sensors_subfeature *, void *),
+			     void *data);
+
 #endif /* def LIB_SENSORS_ACCESS_H */
@@ -0,0 +1,81 @@
+/*
+    backend.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_BACKEND_H
+#define LIB_SENSORS_BACKEND_H
+
+#include "data.h"
+
+/* A backend is where chips are found and where their attributes are read
+   from and written to. Attribute paths are built out of the chip paths the
+   backend set at discovery time, so they need not be actual file names. */
+typedef struct sensors_backend {
+	/* Add all buses and chips to sensors_proc_bus and
+	   sensors_proc_chips. source is the string which was passed to
+	   sensors_set_backend(). Returns 0 on success, <0 on error. */
+	int (*discover)(const char *source);
+	/* Read the raw value of an attribute given its full path. This may
+	   be called from several threads at once, and must not touch any
+	   library data structure. */
+	int (*read)(const char *path, long long *value);
+	/* Same as above, keeping the attribute file open in state for the
+	   next reads, see sensors_set_keep_open(). Only called from the
+	   thread which owns state. May be NULL. */
+	int (*read_open)(const char *path, sensors_subfeature_state *state,
+			 long long *value);
+	/* Write a raw value to an attribute. state may be used to keep
+	   a file descriptor open, see sensors_close_sysfs_attr(). */
+	int (*write)(const char *dir, const char *attr,
+		     sensors_subfeature_state *state, long value);
+	/* Read a text attribute, such as a label. Returns a newly allocated
+	   string, or NULL if there is no such attribute. */
+	char *(*read_text)(const char *dir, const char *attr);
+	/* Free whatever discover() allocated. May be NULL. */
+	void (*cleanup)(void);
+	/* Set if attribute paths are files which can be opened directly
+	   and polled for changes, see sensors_watch_add() */
+	int pollable;
+} sensors_backend;
+
+extern const sensors_backend sensors_sysfs_backend;
+extern const sensors_backend sensors_dir_backend;
+extern const sensors_backend sensors_memory_backend;
+extern const sensors_backend sensors_replay_backend;
+
+/* Backend in use since the last sensors_init(), sysfs by default */
+extern const sensors_backend *sensors_current_backend;
+
+/* Same as sensors_set_backend(), unless the application called it */
+int sensors_set_backend_default(int backend, const char *source);
+
+/* Apply the trace settings found in the environment, if any, unless the
+   application made its own */
+void sensors_trace_getenv(void);
+
+/* Record a read made directly from an attribute file, bypassing the
+   backend, if a trace is being recorded */
+void sensors_trace_read(const char *dir, const char *attr, int err,
+			long long value);
+
+/* Return the backend to use instead of inner to record a trace, or inner
+   itself if no trace was requested */
+const sensors_backend *sensors_trace_backend(const sensors_backend *inner);
+
+#endif /* def LIB_SENSORS_BACKEND_H */
@@ -0,0 +1,817 @@
+/*
+    batch.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "access.h"
+#include "sysfs.h"
+#include "fault.h"
+#include "stats.h"
+#include "budget.h"
+#include "energy.h"
+
+/* Upper limit on the number of threads used by a single batch read */
+#define BATCH_THREADS_MAX	16
+
+enum job_state { JOB_QUEUED, JOB_RUNNING, JOB_DONE, JOB_ABANDONED };
+
+/* A single attribute to be read. Worker threads may outlive the caller,
+   so they only ever look at path, type and counter, and store their
+   result in err and value or raw; all other fields belong to the
+   caller. */
+struct batch_job {
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	int index;		/* Index of the request in the caller's array */
+	int has_deadline;
+	struct timespec deadline;
+	char *path;		/* Private copy of the attribute file path */
+	int dirlen;		/* Length of the chip directory part of path */
+	sensors_subfeature_type type;
+	int counter;		/* Energy counter of a derived subfeature */
+	int state;		/* enum job_state, protected by the batch lock */
+	int stuck;		/* Abandoned while running, see stuck_get() */
+	int expired;		/* Abandoned because of its deadline */
+	int err;
+	double value;
+	long long raw;
+	sensors_timestamp ts;
+};
+
+/* A range of jobs which must be done sequentially, by a single thread */
+struct batch_unit {
+	int first;
+	int count;
+};
+
+/* The batch is shared between the caller and the worker threads, and
+   freed by whoever drops the last reference */
+struct batch {
+	struct batch_job *jobs;
+	int job_count;
+	struct batch_unit *units;
+	int unit_count;
+	int next_unit;
+	int pending;		/* Jobs neither done nor abandoned */
+	int raw;		/* Read raw integer values */
+	int refs;
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+};
+
+/* Chips with a read still running past its deadline. Further reads from
+   these chips with a deadline fail right away, rather than piling up more
+   threads behind the same stuck device. This list is independent from the
+   rest of the library data, as it is updated by threads which may still
+   be running after sensors_cleanup(). */
+struct stuck_chip {
+	char *path;
+	int count;		/* Number of reads still running */
+};
+
+static struct stuck_chip *stuck_chips;
+static int stuck_chips_count;
+static int stuck_chips_max;
+static pthread_mutex_t stuck_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int stuck_find(const struct batch_job *job)
+{
+	int i;
+
+	for (i = 0; i < stuck_chips_count; i++)
+		if (!strncmp(stuck_chips[i].path, job->path, job->dirlen) &&
+		    stuck_chips[i].path[job->dirlen] == '\0')
+			return i;
+	return -1;
+}
+
+static int stuck_check(const struct batch_job *job)
+{
+	int i;
+
+	pthread_mutex_lock(&stuck_lock);
+	i = stuck_find(job);
+	pthread_mutex_unlock(&stuck_lock);
+
+	return i >= 0;
+}
+
+/* Record that the read of job is still running past its deadline */
+static void stuck_get(struct batch_job *job)
+{
+	struct stuck_chip entry;
+	int i;
+
+	pthread_mutex_lock(&stuck_lock);
+	i = stuck_find(job);
+	if (i >= 0) {
+		stuck_chips[i].count++;
+	} else {
+		entry.path = strndup(job->path, job->dirlen);
+		if (!entry.path)
+			sensors_fatal_error(__func__, "Out of memory");
+		entry.count = 1;
+		sensors_add_array_el(&entry, &stuck_chips, &stuck_chips_count,
+				     &stuck_chips_max,
+				     sizeof(struct stuck_chip));
+	}
+	job->stuck = 1;
+	pthread_mutex_unlock(&stuck_lock);
+}
+
+/* Record that the read of job, which was stuck, finally completed */
+static void stuck_put(struct batch_job *job)
+{
+	int i;
+
+	pthread_mutex_lock(&stuck_lock);
+	i = stuck_find(job);
+	if (i >= 0 && !--stuck_chips[i].count) {
+		free(stuck_chips[i].path);
+		stuck_chips[i] = stuck_chips[--stuck_chips_count];
+	}
+	job->stuck = 0;
+	pthread_mutex_unlock(&stuck_lock);
+}
+
+/* Chips on these buses are accessed through a bus controller which can
+   only do one transfer at a time, so there is no point in reading them
+   in parallel. Other chips are either memory or I/O port mapped, or
+   purely virtual, and cheap to read. */
+static int bus_is_exclusive(const sensors_bus_id *bus)
+{
+	switch (bus->type) {
+	case SENSORS_BUS_TYPE_I2C:
+	case SENSORS_BUS_TYPE_SPI:
+	case SENSORS_BUS_TYPE_HID:
+	case SENSORS_BUS_TYPE_SCSI:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Sort jobs so that exclusive buses come first, grouped by bus, and
+   requests keep their original order within each bus */
+static int job_cmp(const void *p1, const void *p2)
+{
+	const struct batch_job *j1 = p1, *j2 = p2;
+	const sensors_bus_id *b1 = &j1->chip->chip.bus;
+	const sensors_bus_id *b2 = &j2->chip->chip.bus;
+	int e1 = bus_is_exclusive(b1), e2 = bus_is_exclusive(b2);
+
+	if (e1 != e2)
+		return e2 - e1;
+	if (e1) {
+		if (b1->type != b2->type)
+			return b1->type - b2->type;
+		if (b1->nr != b2->nr)
+			return b1->nr - b2->nr;
+	}
+	return j1->index - j2->index;
+}
+
+/* Split the sorted job list into units: one per exclusive bus, and one
+   per job for all other buses. Returns the number of units. */
+static int batch_split(struct batch_job *jobs, int count,
+		       struct batch_unit *units)
+{
+	int i, n = 0;
+
+	for (i = 0; i < count; i++) {
+		if (n && bus_is_exclusive(&jobs[i].chip->chip.bus) &&
+		    bus_is_exclusive(&jobs[i - 1].chip->chip.bus) &&
+		    jobs[i].chip->chip.bus.type ==
+		    jobs[i - 1].chip->chip.bus.type &&
+		    jobs[i].chip->chip.bus.nr == jobs[i - 1].chip->chip.bus.nr) {
+			units[n - 1].count++;
+			continue;
+		}
+		units[n].first = i;
+		units[n].count = 1;
+		n++;
+	}
+
+	return n;
+}
+
+/* Timestamps are in nanoseconds of CLOCK_MONOTONIC_RAW, which is not
+   subject to NTP frequency adjustments */
+static long long monotonic_raw_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+	return (long long)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void batch_free(struct batch *batch)
+{
+	int i;
+
+	for (i = 0; i < batch->job_count; i++)
+		free(batch->jobs[i].path);
+	free(batch->jobs);
+	free(batch->units);
+	pthread_cond_destroy(&batch->done);
+	pthread_mutex_destroy(&batch->lock);
+	free(batch);
+}
+
+static void batch_put(struct batch *batch)
+{
+	int refs;
+
+	pthread_mutex_lock(&batch->lock);
+	refs = --batch->refs;
+	pthread_mutex_unlock(&batch->lock);
+
+	if (!refs)
+		batch_free(batch);
+}
+
+/* Do units until there are none left */
+static void batch_process(struct batch *batch)
+{
+	struct batch_unit *unit;
+	struct batch_job *job;
+	sensors_timestamp ts;
+	double value = 0;
+	long long raw = 0;
+	int i, err;
+
+	pthread_mutex_lock(&batch->lock);
+	while (batch->next_unit < batch->unit_count) {
+		unit = &batch->units[batch->next_unit++];
+		for (i = 0; i < unit->count; i++) {
+			job = &batch->jobs[unit->first + i];
+			/* Skip jobs which have already expired */
+			if (job->state != JOB_QUEUED)
+				continue;
+			job->state = JOB_RUNNING;
+			pthread_mutex_unlock(&batch->lock);
+
+			ts.start = monotonic_raw_ns();
+			if (batch->raw || job->counter)
+				err = sensors_read_sysfs_raw(job->path, &raw);
+			else
+				err = sensors_read_sysfs_file(job->path,
+							      job->type,
+							      &value);
+			ts.end = monotonic_raw_ns();
+
+			pthread_mutex_lock(&batch->lock);
+			if (job->state == JOB_RUNNING) {
+				job->err = err;
+				job->value = value;
+				job->raw = raw;
+				job->ts = ts;
+				job->state = JOB_DONE;
+				if (!--batch->pending)
+					pthread_cond_signal(&batch->done);
+			} else if (job->stuck) {
+				/* Too late, the caller has given up */
+				stuck_put(job);
+			}
+		}
+	}
+	pthread_mutex_unlock(&batch->lock);
+}
+
+static void *batch_worker(void *arg)
+{
+	struct batch *batch = arg;
+
+	batch_process(batch);
+	batch_put(batch);
+
+	return NULL;
+}
+
+/* Start up to BATCH_THREADS_MAX detached threads to do all units. If
+   no job has a deadline and there is only one unit, or if no thread
+   could be started, the work is done from the calling thread. In the
+   latter case, jobs with a deadline fail right away with
+   -SENSORS_ERR_TIMEOUT, as nothing could stop them from blocking the
+   caller past it. */
+static void batch_start(struct batch *batch, int need_threads)
+{
+	struct batch_job *job;
+	pthread_attr_t attr;
+	pthread_t thread;
+	int i, nthreads;
+
+	nthreads = batch->unit_count;
+	if (nthreads > BATCH_THREADS_MAX)
+		nthreads = BATCH_THREADS_MAX;
+	if (!need_threads && nthreads <= 1)
+		nthreads = 0;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	for (i = 0; i < nthreads; i++) {
+		pthread_mutex_lock(&batch->lock);
+		batch->refs++;
+		pthread_mutex_unlock(&batch->lock);
+		if (pthread_create(&thread, &attr, batch_worker, batch)) {
+			batch_put(batch);
+			break;
+		}
+	}
+	pthread_attr_destroy(&attr);
+	if (i)
+		return;
+
+	if (need_threads) {
+		pthread_mutex_lock(&batch->lock);
+		for (i = 0; i < batch->job_count; i++) {
+			job = &batch->jobs[i];
+			if (!job->has_deadline || job->state != JOB_QUEUED)
+				continue;
+			job->state = JOB_ABANDONED;
+			job->err = -SENSORS_ERR_TIMEOUT;
+			batch->pending--;
+		}
+		pthread_mutex_unlock(&batch->lock);
+	}
+	batch_process(batch);
+}
+
+static int timespec_before(const struct timespec *t1,
+			   const struct timespec *t2)
+{
+	if (t1->tv_sec != t2->tv_sec)
+		return t1->tv_sec < t2->tv_sec;
+	return t1->tv_nsec < t2->tv_nsec;
+}
+
+static void timespec_add_ms(struct timespec *t, int ms)
+{
+	t->tv_sec += ms / 1000;
+	t->tv_nsec += (long)(ms % 1000) * 1000000;
+	if (t->tv_nsec >= 1000000000) {
+		t->tv_sec++;
+		t->tv_nsec -= 1000000000;
+	}
+}
+
+/* Wait until all jobs are done or have expired. Expired jobs get
+   -SENSORS_ERR_TIMEOUT. */
+static void batch_wait(struct batch *batch)
+{
+	struct batch_job *job;
+	struct timespec now;
+	const struct timespec *next;
+	int i;
+
+	pthread_mutex_lock(&batch->lock);
+	while (batch->pending) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		next = NULL;
+		for (i = 0; i < batch->job_count; i++) {
+			job = &batch->jobs[i];
+			if (!job->has_deadline || job->state == JOB_DONE ||
+			    job->state == JOB_ABANDONED)
+				continue;
+			if (!timespec_before(&now, &job->deadline)) {
+				if (job->state == JOB_RUNNING)
+					stuck_get(job);
+				job->state = JOB_ABANDONED;
+				job->expired = 1;
+				job->err = -SENSORS_ERR_TIMEOUT;
+				batch->pending--;
+			} else if (!next || timespec_before(&job->deadline,
+							    next)) {
+				next = &job->deadline;
+			}
+		}
+
+		if (!batch->pending)
+			break;
+		if (next)
+			pthread_cond_timedwait(&batch->done, &batch->lock,
+					       next);
+		else
+			pthread_cond_wait(&batch->done, &batch->lock);
+	}
+	pthread_mutex_unlock(&batch->lock);
+}
+
+static struct batch *batch_alloc(int count)
+{
+	struct batch *batch;
+	pthread_condattr_t attr;
+
+	batch = calloc(1, sizeof(struct batch));
+	if (!batch)
+		sensors_fatal_error(__func__, "Out of memory");
+	batch->jobs = calloc(count, sizeof(struct batch_job));
+	batch->units = malloc(count * sizeof(struct batch_unit));
+	if (!batch->jobs || !batch->units)
+		sensors_fatal_error(__func__, "Out of memory");
+	batch->refs = 1;
+
+	pthread_mutex_init(&batch->lock, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&batch->done, &attr);
+	pthread_condattr_destroy(&attr);
+
+	return batch;
+}
+
+/* Prepare a job for request req, which was successfully looked up. The
+   deadline is the earliest of the call deadline and the chip deadline.
+   Returns 0 on success, and -SENSORS_ERR_TIMEOUT if the chip is stuck. */
+static int batch_job_init(struct batch_job *job, const struct timespec *start,
+			  int timeout_ms)
+{
+	const sensors_subfeature *attr;
+	struct timespec chip_deadline;
+	size_t len;
+
+	/* Derived subfeatures are computed from their energy counter */
+	attr = sensors_energy_counter(job->chip, job->subfeature);
+	job->counter = attr != NULL;
+	if (!attr)
+		attr = job->subfeature;
+
+	len = strlen(job->chip->chip.path);
+	job->path = malloc(len + 1 + strlen(attr->name) + 1);
+	if (!job->path)
+		sensors_fatal_error(__func__, "Out of memory");
+	sprintf(job->path, "%s/%s", job->chip->chip.path, attr->name);
+	job->dirlen = len;
+	job->type = job->subfeature->type;
+	job->state = JOB_QUEUED;
+
+	job->deadline = *start;
+	if (timeout_ms > 0) {
+		timespec_add_ms(&job->deadline, timeout_ms);
+		job->has_deadline = 1;
+	}
+	if (job->chip->timeout_ms > 0) {
+		chip_deadline = *start;
+		timespec_add_ms(&chip_deadline, job->chip->timeout_ms);
+		if (!job->has_deadline ||
+		    timespec_before(&chip_deadline, &job->deadline))
+			job->deadline = chip_deadline;
+		job->has_deadline = 1;
+	}
+
+	if (job->has_deadline && stuck_check(job))
+		return -SENSORS_ERR_TIMEOUT;
+	return 0;
+}
+
+/* Add a job for the subfeature set in job, which was successfully looked
+   up, to the batch. index is that of the request, or past the requests
+   for the sources of virtual subfeatures. Returns 0 on success, and <0
+   if the subfeature won't be read. */
+static int batch_add_job(struct batch *batch, struct batch_job *job,
+			 int index, const struct timespec *start,
+			 int timeout_ms)
+{
+	int err;
+
+	err = sensors_fault_check(job->chip, job->subfeature);
+	if (err)
+		return err;
+	job->index = index;
+	err = batch_job_init(job, start, timeout_ms);
+	/* The path is freed along with the batch */
+	batch->job_count++;
+	if (err) {
+		job->err = err;
+		job->state = JOB_ABANDONED;
+		return err;
+	}
+	batch->pending++;
+	return 0;
+}
+
+static int batch_has_job(const struct batch *batch,
+			 const sensors_chip_features *chip,
+			 const sensors_subfeature *subfeature)
+{
+	int i;
+
+	for (i = 0; i < batch->job_count; i++)
+		if (batch->jobs[i].chip == chip &&
+		    batch->jobs[i].subfeature == subfeature)
+			return 1;
+	return 0;
+}
+
+/* The subfeatures virtual subfeatures are computed from */
+struct batch_source {
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+};
+
+struct batch_sources {
+	struct batch_source *src;
+	int count;
+	int max;
+};
+
+static void batch_add_source(const sensors_chip_features *chip,
+			     const sensors_subfeature *subfeature, void *data)
+{
+	struct batch_sources *sources = data;
+	struct batch_source new_el;
+	int i;
+
+	for (i = 0; i < sources->count; i++)
+		if (sources->src[i].chip == chip &&
+		    sources->src[i].subfeature == subfeature)
+			return;
+	new_el.chip = chip;
+	new_el.subfeature = subfeature;
+	sensors_add_array_el(&new_el, &sources->src, &sources->count,
+			     &sources->max, sizeof(struct batch_source));
+}
+
+/* Convert between raw and floating point values, for virtual and derived
+   subfeatures which are always computed in floating point */
+static int batch_to_raw(const sensors_subfeature *subfeature, double value,
+			sensors_raw_value *raw)
+{
+	double scaling;
+	int i;
+
+	raw->exponent = sensors_get_type_exponent(subfeature->type);
+	raw->unit = sensors_get_type_unit(subfeature->type);
+	for (scaling = 1, i = raw->exponent; i < 0; i++)
+		scaling *= 10;
+	if (fabs(value * scaling) >= RAW_MAX)
+		return -SENSORS_ERR_ACCESS_R;
+	raw->value = llround(value * scaling);
+	return 0;
+}
+
+static double batch_from_raw(const sensors_raw_value *raw)
+{
+	double value = raw->value;
+	int i;
+
+	for (i = raw->exponent; i < 0; i++)
+		value /= 10;
+	return value;
+}
+
+/* Read count values, with an optional deadline, and optionally report
+   when each value and the whole sample were read. If raw isn't NULL, raw
+   integer values are stored there instead of in req. */
+static int batch_read(sensors_value_request *req, int count, int timeout_ms,
+		      sensors_raw_value *raw, sensors_timestamp *ts,
+		      sensors_timestamp *span)
+{
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	struct batch_sources sources;
+	struct batch *batch;
+	struct batch_job *job;
+	struct timespec start;
+	sensors_read_cycle cycle;
+	sensors_raw_value raw_value, *rv;
+	sensors_timestamp vts;
+	double value;
+	int i, n, need_threads = 0, err = 0;
+
+	if (span)
+		memset(span, 0, sizeof(sensors_timestamp));
+	if (count <= 0)
+		return 0;
+	if (ts)
+		memset(ts, 0, count * sizeof(sensors_timestamp));
+
+	/* Virtual subfeatures are computed once all the values they are
+	   computed from were read, along with the other values */
+	memset(&sources, 0, sizeof(sources));
+	for (i = 0; i < count; i++)
+		if (!sensors_lookup_readable(req[i].name, req[i].subfeat_nr,
+					     &chip, &subfeature) &&
+		    sensors_chip_is_virtual(chip))
+			sensors_virtual_sources(chip, subfeature,
+						batch_add_source, &sources);
+
+	batch = batch_alloc(count + sources.count);
+	batch->raw = raw != NULL;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	/* Resolve the requests, invalid ones are not scheduled */
+	for (i = 0; i < count; i++) {
+		job = &batch->jobs[batch->job_count];
+		req[i].err = sensors_lookup_readable(req[i].name,
+						     req[i].subfeat_nr,
+						     &job->chip,
+						     &job->subfeature);
+		if (req[i].err || sensors_is_computed(job->chip, job->subfeature))
+			continue;
+		req[i].err = batch_add_job(batch, job, i, &start, timeout_ms);
+		if (!req[i].err && job->has_deadline)
+			need_threads = 1;
+	}
+
+	/* Then the sources which were not requested */
+	for (i = 0; i < sources.count; i++) {
+		if (batch_has_job(batch, sources.src[i].chip,
+				  sources.src[i].subfeature) ||
+		    sensors_is_computed(sources.src[i].chip,
+					sources.src[i].subfeature))
+			continue;
+		job = &batch->jobs[batch->job_count];
+		job->chip = sources.src[i].chip;
+		job->subfeature = sources.src[i].subfeature;
+		if (!batch_add_job(batch, job, count + i, &start, timeout_ms) &&
+		    job->has_deadline)
+			need_threads = 1;
+	}
+	free(sources.src);
+	n = batch->job_count;
+
+	qsort(batch->jobs, n, sizeof(struct batch_job), job_cmp);
+	batch->unit_count = batch_split(batch->jobs, n, batch->units);
+	batch_start(batch, need_threads);
+	batch_wait(batch);
+
+	/* Compute statements are applied afterwards, from this thread. All
+	   jobs are either done or abandoned by now, so no worker thread will
+	   touch their results any longer. */
+	sensors_cycle_begin(&cycle);
+	for (i = 0; i < n; i++) {
+		job = &batch->jobs[i];
+		if (job->state == JOB_DONE)
+			sensors_stats_read(job->chip, job->err,
+					   job->ts.end - job->ts.start);
+		if (job->state == JOB_DONE || job->expired)
+			sensors_fault_record(job->chip, job->subfeature,
+					     job->err);
+		value = 0;
+		rv = raw && job->index < count ? &raw[job->index] : &raw_value;
+		if (job->state == JOB_DONE && !job->err && job->counter) {
+			sensors_energy_sample(job->chip, job->subfeature,
+					      job->raw, &job->ts);
+			job->err = sensors_energy_power(job->chip,
+							job->subfeature,
+							&value);
+			if (!job->err && raw)
+				job->err = batch_to_raw(job->subfeature, value,
+							rv);
+		} else if (job->state == JOB_DONE && !job->err) {
+			if (raw) {
+				job->err = sensors_apply_compute_raw(job->chip,
+							job->subfeature,
+							job->raw, rv);
+				value = batch_from_raw(rv);
+			} else
+				job->err = sensors_apply_compute(job->chip,
+							job->subfeature,
+							job->value, &value);
+		}
+		if (job->state == JOB_DONE)
+			sensors_budget_record(job->chip, job->subfeature,
+					      raw || job->err ? NULL : &value,
+					      &job->ts);
+		/* Jobs which weren't done failed, so virtual subfeatures
+		   don't try to read them again */
+		sensors_cycle_add(job->chip, job->subfeature, job->err, value);
+
+		if (job->index < count) {
+			req[job->index].err = job->err;
+			if (!job->err && !raw)
+				req[job->index].value = value;
+		}
+
+		/* Failed values leave their timestamp zeroed, and don't
+		   widen the span */
+		if (job->state != JOB_DONE || job->err)
+			continue;
+		if (ts && job->index < count)
+			ts[job->index] = job->ts;
+		if (span) {
+			if (!span->start || job->ts.start < span->start)
+				span->start = job->ts.start;
+			if (job->ts.end > span->end)
+				span->end = job->ts.end;
+		}
+	}
+
+	/* Now all values virtual subfeatures need were read */
+	for (i = 0; i < count; i++) {
+		if (req[i].err ||
+		    sensors_lookup_readable(req[i].name, req[i].subfeat_nr,
+					    &chip, &subfeature) ||
+		    !sensors_is_computed(chip, subfeature))
+			continue;
+		vts.start = monotonic_raw_ns();
+		req[i].err = sensors_get_value(req[i].name, req[i].subfeat_nr,
+					       &value);
+		vts.end = monotonic_raw_ns();
+		if (!req[i].err) {
+			if (raw)
+				req[i].err = batch_to_raw(subfeature, value,
+							  &raw[i]);
+			else
+				req[i].value = value;
+		}
+		if (ts && !req[i].err)
+			ts[i] = vts;
+		else if (ts)
+			memset(&ts[i], 0, sizeof(ts[i]));
+	}
+	sensors_cycle_end(&cycle);
+
+	for (i = 0; i < count; i++)
+		if (req[i].err)
+			err = req[i].err;
+
+	batch_put(batch);
+	return err;
+}
+
+int sensors_get_values_timeout(sensors_value_request *req, int count,
+			       int timeout_ms)
+{
+	return batch_read(req, count, timeout_ms, NULL, NULL, NULL);
+}
+
+int sensors_get_values(sensors_value_request *req, int count)
+{
+	return batch_read(req, count, 0, NULL, NULL, NULL);
+}
+
+int sensors_get_values_ts(sensors_value_request *req, int count,
+			  sensors_timestamp *ts, sensors_timestamp *span)
+{
+	return batch_read(req, count, 0, NULL, ts, span);
+}
+
+int sensors_get_value_ts(const sensors_chip_name *name, int subfeat_nr,
+			 double *value, sensors_timestamp *ts)
+{
+	sensors_value_request req;
+	int err;
+
+	req.name = name;
+	req.subfeat_nr = subfeat_nr;
+	err = batch_read(&req, 1, 0, NULL, ts, NULL);
+	if (!err)
+		*value = req.value;
+	return err;
+}
+
+int sensors_get_value_timeout(const sensors_chip_name *name, int subfeat_nr,
+			      int timeout_ms, double *value)
+{
+	sensors_value_request req;
+	int err;
+
+	req.name = name;
+	req.subfeat_nr = subfeat_nr;
+	err = sensors_get_values_timeout(&req, 1, timeout_ms);
+	if (!err)
+		*value = req.value;
+	return err;
+}
+
+int sensors_get_raw_values(sensors_value_request *req, int count,
+			   sensors_raw_value *raw)
+{
+	return batch_read(req, count, 0, raw, NULL, NULL);
+}
+
+int sensors_get_raw_value(const sensors_chip_name *name, int subfeat_nr,
+			  sensors_raw_value *value)
+{
+	sensors_value_request req;
+
+	req.name = name;
+	req.subfeat_nr = subfeat_nr;
+	return batch_read(&req, 1, 0, value, NULL, NULL);
+}
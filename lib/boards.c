@@ -0,0 +1,652 @@
+/*
+    boards.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Needed for scandir(), alphasort() and secure_getenv() */
+#define _GNU_SOURCE 1
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sensors.h"
+#include "error.h"
+#include "general.h"
+#include "init.h"
+#include "image.h"
+#include "boards.h"
+
+/*
+ * A board database holds the configuration files of many boards, each
+ * compiled the same way as in a configuration image, and an index of the
+ * boards they are for. Boards are identified by a key made from their
+ * DMI vendor and board or product name (see make_key()).
+ *
+ * The database starts with a header, followed by a hash table of the
+ * keys: a bucket table, then the key records sorted by bucket. Entry b
+ * of the bucket table is the index of the first record of bucket b, and
+ * the table has one more entry for the end of the last bucket. Records
+ * point to their key string and configuration file in the data which
+ * follows them, by offset from its start. All values are in host byte
+ * order.
+ */
+#define BOARDS_MAGIC		"SENSBRDS"
+#define BOARDS_VERSION		2
+#define BOARDS_BYTE_ORDER	0x01020304
+
+/* Size of the header, in 32-bit words: magic, version, byte order,
+   bucket count, key count and 64-bit data length */
+#define HEADER_WORDS		8
+
+/* Size of a key record, in 32-bit words */
+#define RECORD_WORDS		5
+#define RECORD_HASH		0
+#define RECORD_KEY		1
+#define RECORD_KEY_LEN		2
+#define RECORD_FILE		3
+#define RECORD_FILE_LEN		4
+
+/* Can be overridden at build time, such as for tests */
+#ifndef DMI_DIR
+#define DMI_DIR			"/sys/class/dmi/id"
+#endif
+
+/* Keys and names longer than this are cut */
+#define KEY_MAX			128
+
+/* Boards and products a single configuration file can be for */
+#define NAMES_MAX		8
+
+static int boards_enabled;
+static char *boards_filename;
+
+/* Set once the application made its own choice, which the environment
+   doesn't override */
+static int boards_chosen;
+
+static void set_board_config(int enable, const char *filename)
+{
+	char *s = NULL;
+
+	if (filename && !(s = strdup(filename)))
+		sensors_fatal_error(__func__, "Out of memory");
+	free(boards_filename);
+	boards_filename = s;
+	boards_enabled = enable;
+}
+
+void sensors_set_board_config(int enable, const char *filename)
+{
+	set_board_config(enable, filename);
+	boards_chosen = 1;
+}
+
+void sensors_boards_getenv(void)
+{
+	const char *s;
+
+	if (boards_chosen ||
+	    !(s = secure_getenv("SENSORS_BOARD_CONFIG")) || !*s)
+		return;
+	if (!strcmp(s, "0"))
+		set_board_config(0, NULL);
+	else if (!strcmp(s, "1"))
+		set_board_config(1, NULL);
+	else
+		set_board_config(1, s);
+}
+
+/* Vendors which are known under several names */
+static const struct {
+	const char *name;
+	const char *canonical;
+} vendor_aliases[] = {
+	{ "asustek", "asus" },
+	{ "microstar", "msi" },
+	{ "hewlettpackard", "hp" },
+	{ "fujitsutechnologysolutions", "fujitsu" },
+};
+
+/* Copy the letters and digits of s up to end, in lower case */
+static size_t normalize(char *buf, size_t size, const char *s,
+			const char *end)
+{
+	size_t len = 0;
+
+	for (; s < end && *s; s++)
+		if (isalnum((unsigned char)*s) && len < size - 1)
+			buf[len++] = tolower((unsigned char)*s);
+	buf[len] = '\0';
+	return len;
+}
+
+/* Make the key of a board or product from its vendor and name, as
+   "vendor/name". Only letters and digits count, regardless of case, so
+   that "P8Z68-V LX" and "P8Z68-V_LX" match. Only the first word of the
+   vendor counts, so that "Intel" matches "Intel Corporation". Returns 0
+   if the vendor or name is empty. */
+static int make_key(char *key, const char *vendor, const char *name)
+{
+	char v[KEY_MAX / 2];
+	size_t len;
+	int i;
+
+	vendor += strspn(vendor, " \t");
+	if (!normalize(v, sizeof(v), vendor, vendor + strcspn(vendor, " \t")))
+		return 0;
+	for (i = 0; i < ARRAY_SIZE(vendor_aliases); i++) {
+		if (!strcmp(v, vendor_aliases[i].name)) {
+			strcpy(v, vendor_aliases[i].canonical);
+			break;
+		}
+	}
+
+	len = sprintf(key, "%s/", v);
+	return normalize(key + len, KEY_MAX - len, name,
+			 name + strlen(name)) != 0;
+}
+
+/* FNV-1a */
+static uint32_t key_hash(const char *key)
+{
+	uint32_t hash = 2166136261u;
+
+	for (; *key; key++) {
+		hash ^= (unsigned char)*key;
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+/* Loading */
+
+/* Read a DMI attribute, without trailing white space. Returns 0 if it
+   is missing or empty. */
+static int read_dmi(const char *attr, char *buf, size_t size)
+{
+	char path[64];
+	FILE *f;
+	size_t len;
+
+	snprintf(path, sizeof(path), DMI_DIR "/%s", attr);
+	f = fopen(path, "r");
+	if (!f)
+		return 0;
+	if (!fgets(buf, size, f))
+		buf[0] = '\0';
+	fclose(f);
+
+	len = strlen(buf);
+	while (len && isspace((unsigned char)buf[len - 1]))
+		buf[--len] = '\0';
+	return len != 0;
+}
+
+/* Look up the first of count keys which is in the database filename, and
+   load its configuration file */
+static int load_board(const char *filename, char keys[][KEY_MAX], int count)
+{
+	const uint32_t *header, *table, *records, *rec;
+	const char *data;
+	struct stat st;
+	void *map;
+	int64_t data_len;
+	uint32_t buckets, keys_count, hash, i, end;
+	size_t len;
+	int fd, k, res = 0;
+
+	fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return 0;
+	if (fstat(fd, &st) < 0 ||
+	    (size_t)st.st_size < HEADER_WORDS * sizeof(uint32_t)) {
+		close(fd);
+		return 0;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
+
+	header = map;
+	if (memcmp(header, BOARDS_MAGIC, 8) || header[2] != BOARDS_VERSION ||
+	    header[3] != BOARDS_BYTE_ORDER)
+		goto exit_unmap;
+	buckets = header[4];
+	keys_count = header[5];
+	memcpy(&data_len, &header[6], sizeof(data_len));
+
+	/* Buckets are a power of 2, and everything must add up to the size
+	   of the file */
+	if (!buckets || (buckets & (buckets - 1)) || buckets > INT_MAX / 4 ||
+	    data_len < 0 ||
+	    keys_count > INT_MAX / (4 * RECORD_WORDS) ||
+	    (int64_t)st.st_size != (int64_t)(HEADER_WORDS + buckets + 1 +
+		keys_count * RECORD_WORDS) * 4 + data_len)
+		goto exit_unmap;
+	table = header + HEADER_WORDS;
+	records = table + buckets + 1;
+	data = (const char *)(records + keys_count * RECORD_WORDS);
+
+	for (k = 0; k < count; k++) {
+		hash = key_hash(keys[k]);
+		len = strlen(keys[k]);
+		i = table[hash & (buckets - 1)];
+		end = table[(hash & (buckets - 1)) + 1];
+		if (i > end || end > keys_count)
+			goto exit_unmap;
+
+		for (; i < end; i++) {
+			rec = records + i * RECORD_WORDS;
+			if (rec[RECORD_HASH] != hash ||
+			    rec[RECORD_KEY_LEN] != len ||
+			    len > (uint64_t)data_len ||
+			    rec[RECORD_KEY] > data_len - (int64_t)len ||
+			    memcmp(data + rec[RECORD_KEY], keys[k], len))
+				continue;
+
+			if (rec[RECORD_FILE] > data_len - rec[RECORD_FILE_LEN])
+				goto exit_unmap;
+			res = sensors_image_load_files(data + rec[RECORD_FILE],
+						       rec[RECORD_FILE_LEN], 1);
+			/* A corrupt file was not loaded */
+			if (res > 0)
+				res = 0;
+			goto exit_unmap;
+		}
+	}
+
+exit_unmap:
+	munmap(map, st.st_size);
+	return res;
+}
+
+int sensors_boards_load(void)
+{
+	char keys[2][KEY_MAX], vendor[KEY_MAX], name[KEY_MAX];
+	int count = 0;
+
+	if (!boards_enabled)
+		return 0;
+
+	/* Boards first, then products, for systems where the board is
+	   not identified */
+	if (read_dmi("board_vendor", vendor, sizeof(vendor)) &&
+	    read_dmi("board_name", name, sizeof(name)) &&
+	    make_key(keys[count], vendor, name))
+		count++;
+	if (read_dmi("sys_vendor", vendor, sizeof(vendor)) &&
+	    read_dmi("product_name", name, sizeof(name)) &&
+	    make_key(keys[count], vendor, name))
+		count++;
+	if (!count)
+		return 0;
+
+	return load_board(boards_filename ? boards_filename :
+			  DEFAULT_BOARD_DATABASE, keys, count);
+}
+
+/* Compiling */
+
+struct board_key {
+	char *key;
+	uint32_t hash;
+	uint32_t bucket;
+	int file;		/* Index in board_files */
+	int order;		/* Index before sorting */
+};
+
+/* A compiled configuration file */
+struct board_file {
+	char *data;
+	size_t len;
+	size_t offset;		/* In the data of the database */
+};
+
+static struct board_key *board_keys;
+static int board_keys_count;
+static int board_keys_max;
+static struct board_file *board_files;
+static int board_files_count;
+static int board_files_max;
+
+/* Boards and products a configuration file is for */
+struct board_names {
+	char board_vendor[KEY_MAX];
+	char sys_vendor[KEY_MAX];
+	char boards[NAMES_MAX][KEY_MAX];
+	char products[NAMES_MAX][KEY_MAX];
+	int boards_count;
+	int products_count;
+};
+
+/* Add a key for file, unless it is already there. The first file for a
+   board wins. Returns 1 if the key was added. */
+static int add_key(const char *vendor, const char *name, int file)
+{
+	struct board_key key;
+	char buf[KEY_MAX];
+	int i;
+
+	if (!vendor || !make_key(buf, vendor, name))
+		return 0;
+	for (i = 0; i < board_keys_count; i++)
+		if (!strcmp(board_keys[i].key, buf))
+			return 0;
+
+	key.key = strdup(buf);
+	if (!key.key)
+		sensors_fatal_error(__func__, "Out of memory");
+	key.hash = key_hash(buf);
+	key.file = file;
+	key.order = board_keys_count;
+	sensors_add_array_el(&key, &board_keys, &board_keys_count,
+			     &board_keys_max, sizeof(struct board_key));
+	return 1;
+}
+
+static void copy_name(char *buf, const char *value)
+{
+	snprintf(buf, KEY_MAX, "%s", value);
+}
+
+/* Find the boards a configuration file is for in its comments, such as
+   "# dmi: board_vendor: ASRock" and "# dmi: board_name: X370 Taichi".
+   A name without a field is a board name. */
+static void read_dmi_comments(FILE *input, struct board_names *names)
+{
+	char line[256], *p, *end, *value;
+	const char *field;
+
+	while (fgets(line, sizeof(line), input)) {
+		p = line + strspn(line, " \t");
+		if (*p != '#')
+			continue;
+		p += 1 + strspn(p + 1, " \t");
+		if (strncmp(p, "dmi:", 4))
+			continue;
+		p += 4 + strspn(p + 4, " \t");
+
+		end = p + strlen(p);
+		while (end > p && isspace((unsigned char)end[-1]))
+			end--;
+		*end = '\0';
+		if (!*p)
+			continue;
+
+		value = p + strcspn(p, ": \t");
+		if (*value == ':') {
+			field = p;
+			*value++ = '\0';
+			value += strspn(value, " \t");
+		} else {
+			field = "board_name";
+			value = p;
+		}
+
+		if (!strcmp(field, "board_vendor"))
+			copy_name(names->board_vendor, value);
+		else if (!strcmp(field, "sys_vendor"))
+			copy_name(names->sys_vendor, value);
+		else if (!strcmp(field, "board_name") &&
+			 names->boards_count < NAMES_MAX)
+			copy_name(names->boards[names->boards_count++], value);
+		else if (!strcmp(field, "product_name") &&
+			 names->products_count < NAMES_MAX)
+			copy_name(names->products[names->products_count++],
+				  value);
+	}
+}
+
+/* Compile configuration file path, named base, in the directory of
+   vendor, if any */
+static int compile_file(const char *path, const char *base,
+			const char *vendor)
+{
+	struct board_names names;
+	struct board_file file;
+	char name[KEY_MAX];
+	FILE *input;
+	int i, file_nr, added = 0, res;
+
+	input = fopen(path, "r");
+	if (!input) {
+		sensors_parse_error_wfn(strerror(errno), path, 0);
+		return -SENSORS_ERR_PARSE;
+	}
+
+	res = sensors_parse_config(input, path);
+	memset(&names, 0, sizeof(names));
+	if (!res) {
+		rewind(input);
+		read_dmi_comments(input, &names);
+	}
+	fclose(input);
+
+	file.len = sensors_image_take_files(&file.data);
+	if (res) {
+		free(file.data);
+		return res;
+	}
+
+	file_nr = board_files_count;
+	for (i = 0; i < names.boards_count; i++)
+		added += add_key(names.board_vendor[0] ? names.board_vendor :
+				 vendor, names.boards[i], file_nr);
+	for (i = 0; i < names.products_count; i++)
+		added += add_key(names.sys_vendor[0] ? names.sys_vendor :
+				 vendor, names.products[i], file_nr);
+
+	/* The file is usually named after the board */
+	copy_name(name, base);
+	name[strlen(name) - strlen(".conf")] = '\0';
+	added += add_key(vendor, name, file_nr);
+
+	if (added)
+		sensors_add_array_el(&file, &board_files, &board_files_count,
+				     &board_files_max,
+				     sizeof(struct board_file));
+	else
+		free(file.data);
+	return 0;
+}
+
+static int file_filter(const struct dirent *entry)
+{
+	return entry->d_name[0] != '.';		/* Skip hidden files */
+}
+
+/* Compile all configuration files under dir. Files in a subdirectory
+   of the top directory are for boards of the vendor it is named after.
+   Files and subdirectories which can't be compiled are reported and
+   skipped, so that one bad file doesn't leave all boards out. */
+static int compile_dir(const char *dir, const char *vendor)
+{
+	struct dirent **namelist;
+	struct stat st;
+	char path[PATH_MAX];
+	const char *name;
+	size_t len;
+	int count, i, res;
+
+	count = scandir(dir, &namelist, file_filter, alphasort);
+	if (count < 0) {
+		sensors_parse_error_wfn(strerror(errno), dir, 0);
+		return -SENSORS_ERR_PARSE;
+	}
+
+	for (i = 0; i < count; i++) {
+		name = namelist[i]->d_name;
+		if (snprintf(path, sizeof(path), "%s/%s", dir, name) >=
+		    (int)sizeof(path) || stat(path, &st) < 0)
+			continue;
+
+		len = strlen(name);
+		if (S_ISDIR(st.st_mode))
+			res = compile_dir(path, vendor ? vendor : name);
+		else if (S_ISREG(st.st_mode) && len > strlen(".conf") &&
+			 !strcmp(name + len - strlen(".conf"), ".conf"))
+			res = compile_file(path, name, vendor);
+		else
+			res = 0;
+		if (res)
+			sensors_parse_error_wfn("Skipped, not compiled", path, 0);
+	}
+
+	for (i = 0; i < count; i++)
+		free(namelist[i]);
+	free(namelist);
+
+	return 0;
+}
+
+static int cmp_key(const void *a, const void *b)
+{
+	const struct board_key *x = a, *y = b;
+
+	if (x->bucket != y->bucket)
+		return x->bucket < y->bucket ? -1 : 1;
+	return x->order - y->order;
+}
+
+static int write_database(const char *filename)
+{
+	uint32_t header[HEADER_WORDS], *table, record[RECORD_WORDS];
+	const struct board_file *file;
+	uint32_t buckets;
+	int64_t data_len;
+	char *tmp;
+	FILE *f;
+	int i, res = 0;
+
+	for (buckets = 1; buckets < (uint32_t)board_keys_count; buckets <<= 1)
+		;
+	for (i = 0; i < board_keys_count; i++)
+		board_keys[i].bucket = board_keys[i].hash & (buckets - 1);
+	qsort(board_keys, board_keys_count, sizeof(struct board_key), cmp_key);
+
+	table = calloc(buckets + 1, sizeof(uint32_t));
+	if (!table)
+		sensors_fatal_error(__func__, "Out of memory");
+	for (i = 0; i < board_keys_count; i++)
+		table[board_keys[i].bucket + 1]++;
+	for (i = 0; i < (int)buckets; i++)
+		table[i + 1] += table[i];
+
+	/* Key strings come first in the data, then configuration files */
+	data_len = 0;
+	for (i = 0; i < board_keys_count; i++)
+		data_len += strlen(board_keys[i].key) + 1;
+	for (i = 0; i < board_files_count; i++) {
+		board_files[i].offset = data_len;
+		data_len += board_files[i].len;
+	}
+	if (data_len > UINT32_MAX) {
+		res = -SENSORS_ERR_IO;
+		goto exit_free_table;
+	}
+
+	memcpy(header, BOARDS_MAGIC, 8);
+	header[2] = BOARDS_VERSION;
+	header[3] = BOARDS_BYTE_ORDER;
+	header[4] = buckets;
+	header[5] = board_keys_count;
+	memcpy(&header[6], &data_len, sizeof(data_len));
+
+	/* Write to a temporary file, so that readers never see a partial
+	   database */
+	tmp = malloc(strlen(filename) + 5);
+	if (!tmp)
+		sensors_fatal_error(__func__, "Out of memory");
+	sprintf(tmp, "%s.new", filename);
+
+	f = fopen(tmp, "w");
+	if (!f) {
+		res = -SENSORS_ERR_IO;
+		goto exit_free;
+	}
+	if (fwrite(header, sizeof(header), 1, f) != 1 ||
+	    fwrite(table, sizeof(uint32_t), buckets + 1, f) != buckets + 1)
+		res = -SENSORS_ERR_IO;
+
+	data_len = 0;
+	for (i = 0; !res && i < board_keys_count; i++) {
+		file = &board_files[board_keys[i].file];
+		record[RECORD_HASH] = board_keys[i].hash;
+		record[RECORD_KEY] = data_len;
+		record[RECORD_KEY_LEN] = strlen(board_keys[i].key);
+		record[RECORD_FILE] = file->offset;
+		record[RECORD_FILE_LEN] = file->len;
+		data_len += record[RECORD_KEY_LEN] + 1;
+		if (fwrite(record, sizeof(record), 1, f) != 1)
+			res = -SENSORS_ERR_IO;
+	}
+	for (i = 0; !res && i < board_keys_count; i++)
+		if (fwrite(board_keys[i].key, strlen(board_keys[i].key) + 1,
+			   1, f) != 1)
+			res = -SENSORS_ERR_IO;
+	for (i = 0; !res && i < board_files_count; i++)
+		if (board_files[i].len &&
+		    fwrite(board_files[i].data, board_files[i].len, 1, f) != 1)
+			res = -SENSORS_ERR_IO;
+
+	if (fclose(f) && !res)
+		res = -SENSORS_ERR_IO;
+	if (!res && rename(tmp, filename))
+		res = -SENSORS_ERR_IO;
+	if (res)
+		unlink(tmp);
+
+exit_free:
+	free(tmp);
+exit_free_table:
+	free(table);
+	return res;
+}
+
+int sensors_boards_compile(const char *dir, const char *filename)
+{
+	int i, res;
+
+	res = compile_dir(dir, NULL);
+	if (!res)
+		res = write_database(filename);
+
+	for (i = 0; i < board_keys_count; i++)
+		free(board_keys[i].key);
+	for (i = 0; i < board_files_count; i++)
+		free(board_files[i].data);
+	free(board_keys);
+	free(board_files);
+	board_keys = NULL;
+	board_files = NULL;
+	board_keys_count = board_keys_max = 0;
+	board_files_count = board_files_max = 0;
+
+	return res;
+}
@@ -0,0 +1,39 @@
+/*
+    boards.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_BOARDS_H
+#define LIB_SENSORS_BOARDS_H
+
+/* Let programs which don't know about the board database use it */
+void sensors_boards_getenv(void);
+
+/* Load the configuration of the board the system runs on from the board
+   database, if this was enabled with sensors_set_board_config(). Returns
+   0 if it was loaded, or if there is none for this board or the database
+   is missing or invalid, and <0 if bus substitution failed. */
+int sensors_boards_load(void);
+
+/* Compile all configuration files under dir into a board database, and
+   write it to filename. Must be called while an image is being compiled
+   and with an empty configuration, which it leaves for the caller to
+   free. Returns 0 on success, and <0 on failure. */
+int sensors_boards_compile(const char *dir, const char *filename);
+
+#endif /* def LIB_SENSORS_BOARDS_H */
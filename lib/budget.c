@@ -0,0 +1,290 @@
+/*
+    budget.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "stats.h"
+#include "budget.h"
+
+/* A value at LIMIT_MARGIN (relative) from one of its limits has its
+   priority doubled, and the boost grows as the value gets closer, up to
+   LIMIT_BOOST_MAX once it reached the limit */
+#define LIMIT_MARGIN		0.1
+#define LIMIT_BOOST_MAX		16.0
+
+/* A request of sensors_get_values_budget() which could be looked up */
+struct budget_entry {
+	int index;		/* Index of the request in the caller's array */
+	sensors_subfeature_state *state;
+	double score;
+	int sel;		/* Index in the values to read, or -1 */
+};
+
+static sensors_subfeature_state *
+subfeature_state(const sensors_chip_features *chip_features,
+		 const sensors_subfeature *subfeature)
+{
+	return &sensors_chip_rw(chip_features)->
+		state[subfeature - chip_features->subfeature];
+}
+
+void sensors_budget_record(const sensors_chip_features *chip_features,
+			   const sensors_subfeature *subfeature,
+			   const double *value, const sensors_timestamp *ts)
+{
+	sensors_subfeature_state *state;
+	long long cost;
+
+	state = subfeature_state(chip_features, subfeature);
+
+	/* Running average, 0 is reserved for never read */
+	cost = ts->end - ts->start;
+	if (cost < 1)
+		cost = 1;
+	if (state->cost_ns)
+		cost = (state->cost_ns * 3 + cost) / 4;
+	state->cost_ns = cost;
+
+	if (!value)
+		return;
+	state->value = *value;
+	state->ts = *ts;
+	state->cached = 1;
+}
+
+/* Returns 1 for upper limits, -1 for lower limits, 0 for anything else.
+   Hysteresis values are not limits on their own. */
+static int limit_side(sensors_subfeature_type type)
+{
+	switch (type) {
+	case SENSORS_SUBFEATURE_IN_MAX:
+	case SENSORS_SUBFEATURE_IN_CRIT:
+	case SENSORS_SUBFEATURE_FAN_MAX:
+	case SENSORS_SUBFEATURE_TEMP_MAX:
+	case SENSORS_SUBFEATURE_TEMP_CRIT:
+	case SENSORS_SUBFEATURE_TEMP_EMERGENCY:
+	case SENSORS_SUBFEATURE_POWER_CAP:
+	case SENSORS_SUBFEATURE_POWER_MAX:
+	case SENSORS_SUBFEATURE_POWER_CRIT:
+	case SENSORS_SUBFEATURE_CURR_MAX:
+	case SENSORS_SUBFEATURE_CURR_CRIT:
+		return 1;
+	case SENSORS_SUBFEATURE_IN_MIN:
+	case SENSORS_SUBFEATURE_IN_LCRIT:
+	case SENSORS_SUBFEATURE_FAN_MIN:
+	case SENSORS_SUBFEATURE_TEMP_MIN:
+	case SENSORS_SUBFEATURE_TEMP_LCRIT:
+	case SENSORS_SUBFEATURE_POWER_MIN:
+	case SENSORS_SUBFEATURE_POWER_LCRIT:
+	case SENSORS_SUBFEATURE_CURR_MIN:
+	case SENSORS_SUBFEATURE_CURR_LCRIT:
+		return -1;
+	default:
+		return 0;
+	}
+}
+
+/* How much more urgent it is to read a subfeature because of how close
+   its last value was to the limits of its feature, as last read. Alarms
+   which were raised last time count as a reached limit. Subfeatures
+   which are limits themselves rarely change, and get no boost. Many
+   drivers report unset limits as 0, so a limit of 0 doesn't count. */
+static double limit_boost(const sensors_chip_features *chip_features,
+			  const sensors_subfeature *subfeature,
+			  const sensors_subfeature_state *state)
+{
+	const sensors_feature *feature;
+	const sensors_subfeature *limit;
+	const sensors_subfeature_state *limit_state;
+	double margin, boost = 1;
+	int i, side;
+
+	if (subfeature->type & 0x80)
+		return strstr(subfeature->name, "alarm") && state->value != 0 ?
+		       LIMIT_BOOST_MAX : 1;
+	if (limit_side(subfeature->type))
+		return 1;
+
+	if (subfeature->mapping >= chip_features->feature_count)
+		return 1;
+	feature = &chip_features->feature[subfeature->mapping];
+
+	for (i = feature->first_subfeature;
+	     i < chip_features->subfeature_count &&
+	     chip_features->subfeature[i].mapping == feature->number; i++) {
+		limit = &chip_features->subfeature[i];
+		limit_state = &chip_features->state[i];
+		side = limit_side(limit->type);
+		if (!side || !limit_state->cached || limit_state->value == 0)
+			continue;
+
+		margin = side * (limit_state->value - state->value) /
+			 fmax(fabs(limit_state->value), 1);
+		if (margin <= LIMIT_MARGIN / (LIMIT_BOOST_MAX - 1))
+			return LIMIT_BOOST_MAX;
+		if (1 + LIMIT_MARGIN / margin > boost)
+			boost = 1 + LIMIT_MARGIN / margin;
+	}
+
+	return boost;
+}
+
+/* Values never read come first, then the most urgent ones: the score
+   grows with the age of the cached value, its priority and how close it
+   is to a limit */
+static double budget_score(const sensors_chip_features *chip_features,
+			   const sensors_subfeature *subfeature,
+			   const sensors_subfeature_state *state,
+			   long long now)
+{
+	double age_ms;
+
+	if (!state->cached)
+		return HUGE_VAL;
+
+	age_ms = (now - state->ts.end) / 1e6;
+	if (age_ms < 0)
+		age_ms = 0;
+	return (age_ms + 1) * state->priority *
+	       limit_boost(chip_features, subfeature, state);
+}
+
+/* Sort by decreasing score, requests keep their original order on ties */
+static int entry_cmp(const void *p1, const void *p2)
+{
+	const struct budget_entry *e1 = p1, *e2 = p2;
+
+	if (e1->score != e2->score)
+		return e1->score < e2->score ? 1 : -1;
+	return e1->index - e2->index;
+}
+
+int sensors_get_values_budget(sensors_value_request *req, int count,
+			      int budget_us, sensors_timestamp *ts)
+{
+	const sensors_chip_features *chip_features;
+	const sensors_subfeature *subfeature;
+	struct budget_entry *entries, *entry;
+	sensors_value_request *sel;
+	sensors_timestamp *sel_ts;
+	long long now, spent = 0, budget_ns;
+	int i, n, nsel, err = 0;
+
+	if (count <= 0)
+		return 0;
+	if (ts)
+		memset(ts, 0, count * sizeof(sensors_timestamp));
+
+	entries = malloc(count * sizeof(struct budget_entry));
+	sel = malloc(count * sizeof(sensors_value_request));
+	sel_ts = malloc(count * sizeof(sensors_timestamp));
+	if (!entries || !sel || !sel_ts)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	/* Resolve the requests, invalid ones are neither read nor cached */
+	now = sensors_stats_now();
+	for (i = 0, n = 0; i < count; i++) {
+		req[i].err = sensors_lookup_readable(req[i].name,
+						     req[i].subfeat_nr,
+						     &chip_features,
+						     &subfeature);
+		if (req[i].err)
+			continue;
+		entry = &entries[n++];
+		entry->index = i;
+		entry->state = subfeature_state(chip_features, subfeature);
+		entry->score = budget_score(chip_features, subfeature,
+					    entry->state, now);
+	}
+	qsort(entries, n, sizeof(struct budget_entry), entry_cmp);
+
+	/* Pick the most urgent values which fit in the budget. Values never
+	   read are always picked, and so is the most urgent one, so that
+	   values slower than the whole budget still get read. */
+	budget_ns = budget_us > 0 ? (long long)budget_us * 1000 : 0;
+	for (i = 0, nsel = 0; i < n; i++) {
+		entry = &entries[i];
+		entry->sel = -1;
+		if (entry->score != HUGE_VAL && nsel &&
+		    spent + entry->state->cost_ns > budget_ns)
+			continue;
+		spent += entry->state->cost_ns;
+		sel[nsel].name = req[entry->index].name;
+		sel[nsel].subfeat_nr = req[entry->index].subfeat_nr;
+		entry->sel = nsel++;
+	}
+
+	sensors_get_values_ts(sel, nsel, sel_ts, NULL);
+
+	/* The others are served from the cache */
+	for (i = 0; i < n; i++) {
+		entry = &entries[i];
+		if (entry->sel >= 0) {
+			req[entry->index].err = sel[entry->sel].err;
+			if (!req[entry->index].err)
+				req[entry->index].value = sel[entry->sel].value;
+			if (ts)
+				ts[entry->index] = sel_ts[entry->sel];
+		} else {
+			req[entry->index].value = entry->state->value;
+			if (ts)
+				ts[entry->index] = entry->state->ts;
+		}
+	}
+
+	for (i = 0; i < count; i++)
+		if (req[i].err)
+			err = req[i].err;
+
+	free(sel_ts);
+	free(sel);
+	free(entries);
+	return err;
+}
+
+int sensors_set_read_priority(const sensors_chip_name *name, int subfeat_nr,
+			      int priority)
+{
+	const sensors_chip_features *chip_features;
+	sensors_chip_features *chip;
+	int i;
+
+	if (priority < 0)
+		priority = 0;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip_features = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	if (subfeat_nr >= chip_features->subfeature_count)
+		return -SENSORS_ERR_NO_ENTRY;
+
+	chip = sensors_chip_rw(chip_features);
+	for (i = 0; i < chip->subfeature_count; i++)
+		if (subfeat_nr < 0 || i == subfeat_nr)
+			chip->state[i].priority = priority;
+	return 0;
+}
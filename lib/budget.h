@@ -0,0 +1,33 @@
+/*
+    budget.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_BUDGET_H
+#define LIB_SENSORS_BUDGET_H
+
+#include "data.h"
+
+/* Record a read of a subfeature from the kernel, which took place during
+   ts. value is the value after the compute statement was applied, to be
+   served by sensors_get_values_budget(), or NULL if the read failed. */
+void sensors_budget_record(const sensors_chip_features *chip_features,
+			   const sensors_subfeature *subfeature,
+			   const double *value, const sensors_timestamp *ts);
+
+#endif /* def LIB_SENSORS_BUDGET_H */
@@ -32,40 +32,48 @@
 #include "access.h"
 #include "init.h"
 
-static void sensors_yyerror(const char *err);
+static void sensors_yyerror(sensors_parse_state *state, void *scanner,
+			    const char *err);
 static sensors_expr *malloc_expr(void);
-
-static sensors_chip *current_chip = NULL;
+static sensors_expr *new_subexpr(sensors_operation op, sensors_expr *sub1,
+				 sensors_expr *sub2);
+static sensors_expr *new_call(sensors_parse_state *state, void *scanner,
+			      char *name, sensors_expr_list *args);
 
 #define bus_add_el(el) sensors_add_array_el(el,\
-                                      &sensors_config_busses,\
-                                      &sensors_config_busses_count,\
-                                      &sensors_config_busses_max,\
+                                      &state->busses,\
+                                      &state->busses_count,\
+                                      &state->busses_max,\
                                       sizeof(sensors_bus))
 #define label_add_el(el) sensors_add_array_el(el,\
-                                        &current_chip->labels,\
-                                        &current_chip->labels_count,\
-                                        &current_chip->labels_max,\
+                                        &state->current_chip->labels,\
+                                        &state->current_chip->labels_count,\
+                                        &state->current_chip->labels_max,\
                                         sizeof(sensors_label));
 #define set_add_el(el) sensors_add_array_el(el,\
-                                      &current_chip->sets,\
-                                      &current_chip->sets_count,\
-                                      &current_chip->sets_max,\
+                                      &state->current_chip->sets,\
+                                      &state->current_chip->sets_count,\
+                                      &state->current_chip->sets_max,\
                                       sizeof(sensors_set));
 #define compute_add_el(el) sensors_add_array_el(el,\
-                                          &current_chip->computes,\
-                                          &current_chip->computes_count,\
-                                          &current_chip->computes_max,\
+                                          &state->current_chip->computes,\
+                                          &state->current_chip->computes_count,\
+                                          &state->current_chip->computes_max,\
                                           sizeof(sensors_compute));
 #define ignore_add_el(el) sensors_add_array_el(el,\
-                                          &current_chip->ignores,\
-                                          &current_chip->ignores_count,\
-                                          &current_chip->ignores_max,\
+                                          &state->current_chip->ignores,\
+                                          &state->current_chip->ignores_count,\
+                                          &state->current_chip->ignores_max,\
                                           sizeof(sensors_ignore));
+#define define_add_el(el) sensors_add_array_el(el,\
+                                          &state->current_chip->defines,\
+                                          &state->current_chip->defines_count,\
+                                          &state->current_chip->defines_max,\
+                                          sizeof(sensors_define));
 #define chip_add_el(el) sensors_add_array_el(el,\
-                                       &sensors_config_chips,\
-                                       &sensors_config_chips_count,\
-                                       &sensors_config_chips_max,\
+                                       &state->chips,\
+                                       &state->chips_count,\
+                                       &state->chips_max,\
                                        sizeof(sensors_chip));
 
 #define fits_add_el(el,list) sensors_add_array_el(el,\
@@ -73,20 +81,38 @@ static sensors_chip *current_chip = NULL;
                                                   &(list).fits_count,\
                                                   &(list).fits_max, \
 		                                  sizeof(sensors_chip_name));
+#define expr_add_el(el,list) sensors_add_array_el(el,\
+                                                  &(list).exprs,\
+                                                  &(list).count,\
+                                                  &(list).max,\
+                                                  sizeof(sensors_expr *));
 
 %}
 
+%define api.pure
+%parse-param {sensors_parse_state *state}
+%parse-param {void *scanner}
+%lex-param {void *scanner}
+
 %union {
   double value;
   char *name;
   void *nothing;
   sensors_chip_name_list chips;
   sensors_expr *expr;
+  sensors_expr_list exprs;
   sensors_bus_id bus;
   sensors_chip_name chip;
   sensors_config_line line;
 }  
 
+%{
+int sensors_yylex(YYSTYPE *lvalp, void *scanner);
+%}
+
+%right <nothing> '?' ':'
+%nonassoc <nothing> EQ NE
+%nonassoc <nothing> '<' '>' LE GE
 %left <nothing> '-' '+'
 %left <nothing> '*' '/'
 %left <nothing> NEG
@@ -100,17 +126,30 @@ static sensors_chip *current_chip = NULL;
 %token <line> CHIP
 %token <line> COMPUTE
 %token <line> IGNORE
+%token <line> VIRTUAL
+%token <line> DEFINE
 %token <value> FLOAT
 %token <name> NAME
 %token <nothing> ERROR
 
 %type <chips> chip_name_list
 %type <expr> expression
+%type <exprs> expression_list
 %type <bus> bus_id
 %type <name> adapter_name
 %type <name> function_name
 %type <name> string
 %type <chip> chip_name
+%type <chip> virtual_name
+
+/* Free what is discarded when recovering from syntax errors */
+%destructor { free($$); } <name>
+%destructor { sensors_free_expr($$); } <expr>
+%destructor { int i;
+              for (i = 0; i < $$.count; i++)
+                sensors_free_expr($$.exprs[i]);
+              free($$.exprs);
+            } <exprs>
 
 %start input
 
@@ -126,6 +165,8 @@ line:	  bus_statement EOL
 	| chip_statement EOL
 	| compute_statement EOL
 	| ignore_statement EOL
+	| virtual_statement EOL
+	| define_statement EOL
 	| error	EOL
 ;
 
@@ -140,8 +181,8 @@ bus_statement:	  BUS bus_id adapter_name
 
 label_statement:	  LABEL function_name string
 			  { sensors_label new_el;
-			    if (!current_chip) {
-			      sensors_yyerror("Label statement before first chip statement");
+			    if (!state->current_chip) {
+			      sensors_yyerror(state, scanner, "Label statement before first chip statement");
 			      free($2);
 			      free($3);
 			      YYERROR;
@@ -155,8 +196,8 @@ label_statement:	  LABEL function_name string
 
 set_statement:	  SET function_name expression
 		  { sensors_set new_el;
-		    if (!current_chip) {
-		      sensors_yyerror("Set statement before first chip statement");
+		    if (!state->current_chip) {
+		      sensors_yyerror(state, scanner, "Set statement before first chip statement");
 		      free($2);
 		      sensors_free_expr($3);
 		      YYERROR;
@@ -170,8 +211,8 @@ set_statement:	  SET function_name expression
 
 compute_statement:	  COMPUTE function_name expression ',' expression
 			  { sensors_compute new_el;
-			    if (!current_chip) {
-			      sensors_yyerror("Compute statement before first chip statement");
+			    if (!state->current_chip) {
+			      sensors_yyerror(state, scanner, "Compute statement before first chip statement");
 			      free($2);
 			      sensors_free_expr($3);
 			      sensors_free_expr($5);
@@ -187,8 +228,8 @@ compute_statement:	  COMPUTE function_name expression ',' expression
 
 ignore_statement:	IGNORE function_name
 			{ sensors_ignore new_el;
-			  if (!current_chip) {
-			    sensors_yyerror("Ignore statement before first chip statement");
+			  if (!state->current_chip) {
+			    sensors_yyerror(state, scanner, "Ignore statement before first chip statement");
 			    free($2);
 			    YYERROR;
 			  }
@@ -198,6 +239,21 @@ ignore_statement:	IGNORE function_name
 			}
 ;
 
+define_statement:	DEFINE function_name expression
+			{ sensors_define new_el;
+			  if (!state->current_virtual) {
+			    sensors_yyerror(state, scanner, "Define statement outside of a virtual statement");
+			    free($2);
+			    sensors_free_expr($3);
+			    YYERROR;
+			  }
+			  new_el.line = $1;
+			  new_el.name = $2;
+			  new_el.value = $3;
+			  define_add_el(&new_el);
+			}
+;
+
 chip_statement:	  CHIP chip_name_list
 		  { sensors_chip new_el;
 		    new_el.line = $1;
@@ -205,17 +261,30 @@ chip_statement:	  CHIP chip_name_list
 		    new_el.sets = NULL;
 		    new_el.computes = NULL;
 		    new_el.ignores = NULL;
+		    new_el.defines = NULL;
 		    new_el.labels_count = new_el.labels_max = 0;
 		    new_el.sets_count = new_el.sets_max = 0;
 		    new_el.computes_count = new_el.computes_max = 0;
 		    new_el.ignores_count = new_el.ignores_max = 0;
+		    new_el.defines_count = new_el.defines_max = 0;
 		    new_el.chips = $2;
 		    chip_add_el(&new_el);
-		    current_chip = sensors_config_chips + 
-		                   sensors_config_chips_count - 1;
+		    state->current_chip = state->chips + state->chips_count - 1;
+		    state->current_virtual = 0;
 		  }
 ;
 
+virtual_statement:	VIRTUAL virtual_name
+			{ sensors_chip new_el;
+			  memset(&new_el, 0, sizeof(new_el));
+			  new_el.line = $1;
+			  fits_add_el(&$2, new_el.chips);
+			  chip_add_el(&new_el);
+			  state->current_chip = state->chips + state->chips_count - 1;
+			  state->current_virtual = 1;
+			}
+;
+
 chip_name_list:	  chip_name
 		  { 
 		    $$.fits = NULL;
@@ -293,13 +362,45 @@ expression:	  FLOAT
 		    $$->data.subexpr.sub1 = $2;
 		    $$->data.subexpr.sub2 = NULL;
 		  }
+		| expression '<' expression
+		  { $$ = new_subexpr(sensors_lt, $1, $3); }
+		| expression LE expression
+		  { $$ = new_subexpr(sensors_le, $1, $3); }
+		| expression '>' expression
+		  { $$ = new_subexpr(sensors_gt, $1, $3); }
+		| expression GE expression
+		  { $$ = new_subexpr(sensors_ge, $1, $3); }
+		| expression EQ expression
+		  { $$ = new_subexpr(sensors_eq, $1, $3); }
+		| expression NE expression
+		  { $$ = new_subexpr(sensors_ne, $1, $3); }
+		| expression '?' expression ':' expression
+		  { $$ = new_subexpr(sensors_cond, $1,
+				     new_subexpr(sensors_choice, $3, $5));
+		  }
+		| NAME '(' expression_list ')'
+		  { $$ = new_call(state, scanner, $1, &$3);
+		    if (!$$)
+		      YYERROR;
+		  }
+;
+
+expression_list:  expression
+		  { $$.exprs = NULL;
+		    $$.count = $$.max = 0;
+		    expr_add_el(&$1,$$);
+		  }
+		| expression_list ',' expression
+		  { $$ = $1;
+		    expr_add_el(&$3,$$);
+		  }
 ;
 
 bus_id:		  NAME
 		  { int res = sensors_parse_bus_id($1,&$$);
 		    free($1);
 		    if (res) {
-                      sensors_yyerror("Parse error in bus id");
+                      sensors_yyerror(state, scanner, "Parse error in bus id");
 		      YYERROR;
                     }
 		  }
@@ -321,21 +422,47 @@ chip_name:	  NAME
 		  { int res = sensors_parse_chip_name($1,&$$); 
 		    free($1);
 		    if (res) {
-		      sensors_yyerror("Parse error in chip name");
+		      sensors_yyerror(state, scanner, "Parse error in chip name");
 		      YYERROR;
 		    }
 		  }
 ;
 
+/* The name of a virtual chip is only its prefix, it is always
+   PREFIX-virtual-0 */
+virtual_name:	  NAME
+		  { if (!*$1 || strpbrk($1, "-*:")) {
+		      sensors_yyerror(state, scanner, "Parse error in chip name");
+		      free($1);
+		      YYERROR;
+		    }
+		    $$.prefix = $1;
+		    $$.bus.type = SENSORS_BUS_TYPE_VIRTUAL;
+		    $$.bus.nr = SENSORS_BUS_NR_ANY;
+		    $$.addr = 0;
+		    $$.path = NULL;
+		  }
+;
+
 %%
 
-void sensors_yyerror(const char *err)
+/* Errors are kept with the file, and only reported once it is merged
+   into the configuration, so that they come in the order of the files */
+void sensors_yyerror(sensors_parse_state *state, void *scanner,
+		     const char *err)
 {
-  if (sensors_lex_error[0]) {
-    sensors_parse_error_wfn(sensors_lex_error, sensors_yyfilename, sensors_yylineno);
-    sensors_lex_error[0] = '\0';
-  } else
-    sensors_parse_error_wfn(err, sensors_yyfilename, sensors_yylineno);
+  struct sensors_parse_error new_el;
+
+  (void)scanner;
+  if (state->lex_error[0])
+    err = state->lex_error;
+  new_el.msg = strdup(err);
+  if (! new_el.msg)
+    sensors_fatal_error(__func__, "Allocating a new string");
+  new_el.lineno = state->lineno;
+  sensors_add_array_el(&new_el, &state->errors, &state->errors_count,
+                       &state->errors_max, sizeof(new_el));
+  state->lex_error[0] = '\0';
 }
 
 sensors_expr *malloc_expr(void)
@@ -345,3 +472,106 @@ sensors_expr *malloc_expr(void)
     sensors_fatal_error(__func__, "Allocating a new expression");
   return res;
 }
+
+sensors_expr *new_subexpr(sensors_operation op, sensors_expr *sub1,
+			  sensors_expr *sub2)
+{
+  sensors_expr *res = malloc_expr();
+  res->kind = sensors_kind_sub;
+  res->data.subexpr.op = op;
+  res->data.subexpr.sub1 = sub1;
+  res->data.subexpr.sub2 = sub2;
+  return res;
+}
+
+static sensors_expr *copy_expr(const sensors_expr *expr)
+{
+  sensors_expr *res;
+
+  if (! expr)
+    return NULL;
+  res = malloc_expr();
+  *res = *expr;
+  if (expr->kind == sensors_kind_var) {
+    res->data.var = strdup(expr->data.var);
+    if (! res->data.var)
+      sensors_fatal_error(__func__, "Allocating a new string");
+  } else if (expr->kind == sensors_kind_sub) {
+    res->data.subexpr.sub1 = copy_expr(expr->data.subexpr.sub1);
+    res->data.subexpr.sub2 = copy_expr(expr->data.subexpr.sub2);
+  }
+  return res;
+}
+
+/* Turn a function call into operations. The name and the arguments are
+   taken over. Returns NULL after reporting an error if the function is
+   unknown or doesn't get the right number of arguments. */
+sensors_expr *new_call(sensors_parse_state *state, void *scanner,
+		       char *name, sensors_expr_list *args)
+{
+  sensors_expr **arg = args->exprs, *res, *x;
+  int i, n = args->count;
+
+  if ((! strcmp(name, "min") || ! strcmp(name, "max")) && n == 1) {
+    /* min(var) and max(var) are aggregates */
+    if (arg[0]->kind != sensors_kind_var)
+      goto not_var;
+    res = new_subexpr(name[1] == 'i' ? sensors_agg_min : sensors_agg_max,
+                      arg[0], NULL);
+  } else if (! strcmp(name, "sum") || ! strcmp(name, "avg")) {
+    if (n != 1)
+      goto wrong_count;
+    if (arg[0]->kind != sensors_kind_var)
+      goto not_var;
+    res = new_subexpr(name[0] == 's' ? sensors_agg_sum : sensors_agg_avg,
+                      arg[0], NULL);
+  } else if (! strcmp(name, "min") || ! strcmp(name, "max")) {
+    if (n < 2)
+      goto wrong_count;
+    res = arg[0];
+    for (i = 1; i < n; i++)
+      res = new_subexpr(name[1] == 'i' ? sensors_min : sensors_max,
+                        res, arg[i]);
+  } else if (! strcmp(name, "abs")) {
+    if (n != 1)
+      goto wrong_count;
+    res = new_subexpr(sensors_abs, arg[0], NULL);
+  } else if (! strcmp(name, "clamp")) {
+    /* clamp(x, lo, hi) is max(min(x, hi), lo) */
+    if (n != 3)
+      goto wrong_count;
+    res = new_subexpr(sensors_max,
+                      new_subexpr(sensors_min, arg[0], arg[2]), arg[1]);
+  } else if (! strcmp(name, "poly")) {
+    /* poly(x, c0, c1, ..., cn) is c0 + x * (c1 + x * (... + x * cn)) */
+    if (n < 2)
+      goto wrong_count;
+    x = arg[0];
+    res = arg[n - 1];
+    for (i = n - 2; i >= 1; i--)
+      res = new_subexpr(sensors_add, arg[i],
+                        new_subexpr(sensors_multiply,
+                                    i == 1 ? x : copy_expr(x), res));
+    if (n == 2)
+      sensors_free_expr(x);
+  } else {
+    sensors_yyerror(state, scanner, "Unknown function");
+    goto exit_free;
+  }
+
+  free(args->exprs);
+  free(name);
+  return res;
+
+wrong_count:
+  sensors_yyerror(state, scanner, "Wrong number of arguments");
+  goto exit_free;
+not_var:
+  sensors_yyerror(state, scanner, "Argument of aggregate is not a variable");
+exit_free:
+  for (i = 0; i < n; i++)
+    sensors_free_expr(arg[i]);
+  free(args->exprs);
+  free(name);
+  return NULL;
+}
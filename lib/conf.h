@@ -21,14 +21,51 @@
 #ifndef LIB_SENSORS_CONF_H
 #define LIB_SENSORS_CONF_H
 
-/* This is defined in conf-lex.l */
-int sensors_yylex(void);
-extern char sensors_lex_error[];
-extern const char *sensors_yyfilename;
-extern int sensors_yylineno;
-extern FILE *sensors_yyin;
+/* Arguments of a function call in an expression */
+typedef struct sensors_expr_list {
+	sensors_expr **exprs;
+	int count;
+	int max;
+} sensors_expr_list;
+
+/* A configuration file being parsed. Each file is scanned and parsed into
+   its own state, so that several files can be parsed at the same time,
+   and the result is merged into the configuration afterwards. */
+struct sensors_parse_error {
+	char *msg;
+	int lineno;
+};
+
+typedef struct sensors_parse_state {
+	char *filename;
+	int lineno;
+	char lex_error[100];
+
+	/* Used by the scanner */
+	char *buffer;
+	int buffer_count;
+	int buffer_max;
+	char *map;
+	size_t map_len;
+	char *copy;
+
+	/* Statements found by the parser */
+	sensors_chip *chips;
+	int chips_count;
+	int chips_max;
+	sensors_chip *current_chip;
+	int current_virtual;	/* current_chip is a virtual statement */
+	sensors_bus *busses;
+	int busses_count;
+	int busses_max;
+
+	/* Errors, reported when the file is merged */
+	struct sensors_parse_error *errors;
+	int errors_count;
+	int errors_max;
+} sensors_parse_state;
 
 /* This is defined in conf-parse.y */
-int sensors_yyparse(void);
+int sensors_yyparse(sensors_parse_state *state, void *scanner);
 
 #endif /* def LIB_SENSORS_CONF_H */
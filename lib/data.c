@@ -50,10 +50,27 @@ sensors_chip_features *sensors_proc_chips = NULL;
 int sensors_proc_chips_count = 0;
 int sensors_proc_chips_max = 0;
 
+sensors_chip_features *sensors_virtual_chips = NULL;
+int sensors_virtual_chips_count = 0;
+int sensors_virtual_chips_max = 0;
+
 sensors_bus *sensors_proc_bus = NULL;
 int sensors_proc_bus_count = 0;
 int sensors_proc_bus_max = 0;
 
+int sensors_chip_is_virtual(const sensors_chip_features *chip)
+{
+	return chip >= sensors_virtual_chips &&
+	       chip < sensors_virtual_chips + sensors_virtual_chips_count;
+}
+
+sensors_chip_features *sensors_chip_rw(const sensors_chip_features *chip)
+{
+	if (sensors_chip_is_virtual(chip))
+		return sensors_virtual_chips + (chip - sensors_virtual_chips);
+	return sensors_proc_chips + (chip - sensors_proc_chips);
+}
+
 void sensors_free_chip_name(sensors_chip_name *chip)
 {
 	free(chip->prefix);
@@ -84,6 +101,8 @@ int sensors_parse_chip_name(const char *name, sensors_chip_name *res)
 {
 	char *dash;
 
+	res->path = NULL;
+
 	/* First, the prefix. It's either "*" or a real chip name. */
 	if (!strncmp(name, "*-", 2)) {
 		res->prefix = SENSORS_CHIP_NAME_PREFIX_ANY;
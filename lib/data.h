@@ -22,6 +22,7 @@
 #ifndef LIB_SENSORS_DATA_H
 #define LIB_SENSORS_DATA_H
 
+#include <time.h>
 #include "sensors.h"
 #include "general.h"
 
@@ -29,10 +30,18 @@
    for the representation of the config file data and the sensors
    data. */
 
-/* Kinds of expression operators recognized */
+/* Kinds of expression operators recognized. A conditional a ? b : c is
+   an operation sensors_cond on a and an operation sensors_choice on b
+   and c. Aggregates apply to all the subfeatures matched by a variable,
+   which is their only operand. New operators go last, they are stored in
+   compiled images. */
 typedef enum sensors_operation {
 	sensors_add, sensors_sub, sensors_multiply, sensors_divide,
 	sensors_negate, sensors_exp, sensors_log,
+	sensors_min, sensors_max, sensors_abs,
+	sensors_lt, sensors_le, sensors_gt, sensors_ge, sensors_eq, sensors_ne,
+	sensors_cond, sensors_choice,
+	sensors_agg_min, sensors_agg_max, sensors_agg_sum, sensors_agg_avg,
 } sensors_operation;
 
 /* An expression can have several forms */
@@ -97,6 +106,14 @@ typedef struct sensors_ignore {
 	sensors_config_line line;
 } sensors_ignore;
 
+/* Config file define declaration: a subfeature name of a virtual chip,
+   combined with the expression its value is computed with */
+typedef struct sensors_define {
+	char *name;
+	sensors_expr *value;
+	sensors_config_line line;
+} sensors_define;
+
 /* A list of chip names, used to represent a config file chips declaration */
 typedef struct sensors_chip_name_list {
 	sensors_chip_name *fits;
@@ -119,6 +136,9 @@ typedef struct sensors_chip {
 	sensors_ignore *ignores;
 	int ignores_count;
 	int ignores_max;
+	sensors_define *defines;	/* Only in virtual statements */
+	int defines_count;
+	int defines_max;
 	sensors_config_line line;
 } sensors_chip;
 
@@ -130,6 +150,34 @@ typedef struct sensors_bus {
 	sensors_config_line line;
 } sensors_bus;
 
+/* Read failure tracking of a subfeature or a chip. Once there were too
+   many consecutive failures, reads are skipped until retry. A chip only
+   counts failures while all its subfeatures which were read are failing. */
+typedef struct sensors_breaker {
+	int failures;		/* Consecutive failed reads */
+	int backoff_ms;		/* Current backoff delay, 0 if none */
+	struct timespec retry;	/* Time of the next read, if backoff_ms */
+	int recorded;		/* Subfeature: non-zero once read; chip:
+				   number of subfeatures read */
+	int failing;		/* Chip only: number of subfeatures whose
+				   last read failed */
+} sensors_breaker;
+
+/* Internal run-time state of a subfeature, one per detected subfeature */
+typedef struct sensors_subfeature_state {
+	int read_fd;		/* Attribute file kept open for reading, or -1 */
+	int write_fd;		/* Attribute file kept open for writing, or -1 */
+	int written;		/* Non-zero if last_written is valid */
+	long last_written;	/* Last raw value successfully written */
+	sensors_breaker breaker;
+	int cached;		/* Non-zero if value and ts are valid */
+	double value;		/* Last value successfully read */
+	sensors_timestamp ts;	/* When value was read */
+	long long cost_ns;	/* Average read time, 0 if never read */
+	int priority;		/* See sensors_set_read_priority() */
+	struct sensors_energy *energy;	/* Derived power only, or NULL */
+} sensors_subfeature_state;
+
 /* Internal data about all features and subfeatures of a chip */
 typedef struct sensors_chip_features {
 	struct sensors_chip_name chip;
@@ -137,6 +185,10 @@ typedef struct sensors_chip_features {
 	struct sensors_subfeature *subfeature;
 	int feature_count;
 	int subfeature_count;
+	sensors_subfeature_state *state;	/* subfeature_count entries */
+	int timeout_ms;		/* Read deadline, 0 if none */
+	sensors_breaker breaker;
+	sensors_stats stats;
 } sensors_chip_features;
 
 extern char **sensors_config_files;
@@ -164,6 +216,20 @@ extern int sensors_proc_chips_max;
 	(el), &sensors_proc_chips, &sensors_proc_chips_count,\
 	&sensors_proc_chips_max, sizeof(struct sensors_chip_features))
 
+/* Virtual chips, defined in the configuration. They are kept apart from
+   the detected chips, so that loading another configuration doesn't move
+   the detected chips around. */
+extern sensors_chip_features *sensors_virtual_chips;
+extern int sensors_virtual_chips_count;
+extern int sensors_virtual_chips_max;
+
+/* Check whether a chip is one of sensors_virtual_chips */
+int sensors_chip_is_virtual(const sensors_chip_features *chip);
+
+/* Chips are handed around as const pointers, get a writable pointer to
+   the same chip back */
+sensors_chip_features *sensors_chip_rw(const sensors_chip_features *chip);
+
 extern sensors_bus *sensors_proc_bus;
 extern int sensors_proc_bus_count;
 extern int sensors_proc_bus_max;
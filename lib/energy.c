@@ -0,0 +1,415 @@
+/*
+    energy.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* Needed for secure_getenv() */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "sysfs.h"
+#include "stats.h"
+#include "energy.h"
+
+/*
+ * Energy counters only ever grow, except when they wrap around or are
+ * reset, for example when the driver is reloaded. Power is the energy
+ * difference between two samples of a counter divided by the time between
+ * them. Samples are taken either when the power is read, or by a
+ * background thread at a fixed rate, in which case the power read is the
+ * average over all the samples taken since the previous read.
+ */
+
+/* Counters which wrap around at 32 bits, as seen in microjoules */
+#define ENERGY_WRAP_32		(1LL << 32)
+
+int sensors_energy_enabled;
+
+/* The rate state is shared with the sampling thread */
+static pthread_mutex_t energy_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Background sampling, see sensors_set_energy_sampling() */
+struct energy_counter {
+	char *path;
+	sensors_energy *energy;
+};
+
+static int sampling_ms;
+static int sampler_running;
+static int sampler_stop;
+static pthread_t sampler;
+static pthread_cond_t sampler_cond;
+static struct energy_counter *sampler_counters;
+static int sampler_counters_count;
+static int sampler_counters_max;
+
+/* Set once the application made its own choice, which the environment
+   doesn't override */
+static int energy_chosen;
+
+void sensors_set_energy_power(int enable)
+{
+	sensors_energy_enabled = enable;
+	energy_chosen = 1;
+}
+
+void sensors_energy_getenv(void)
+{
+	const char *s;
+
+	if (!energy_chosen && (s = secure_getenv("SENSORS_ENERGY_POWER")) &&
+	    *s)
+		sensors_energy_enabled = strcmp(s, "0") != 0;
+}
+
+void sensors_energy_init(sensors_chip_features *chip)
+{
+	const sensors_subfeature *sf;
+	sensors_energy *energy;
+	int i, j;
+
+	for (i = 0; i < chip->subfeature_count; i++) {
+		sf = &chip->subfeature[i];
+		if (sf->type != SENSORS_SUBFEATURE_ENERGY_POWER ||
+		    !(sf->flags & SENSORS_DERIVED))
+			continue;
+
+		/* The counter belongs to the same feature */
+		for (j = chip->feature[sf->mapping].first_subfeature;
+		     j < i; j++)
+			if (chip->subfeature[j].type ==
+			    SENSORS_SUBFEATURE_ENERGY_INPUT)
+				break;
+
+		energy = calloc(1, sizeof(sensors_energy));
+		if (!energy)
+			sensors_fatal_error(__func__, "Out of memory");
+		energy->counter = j;
+		chip->state[i].energy = energy;
+	}
+}
+
+void sensors_energy_free(sensors_chip_features *chip)
+{
+	int i;
+
+	for (i = 0; i < chip->subfeature_count; i++) {
+		free(chip->state[i].energy);
+		chip->state[i].energy = NULL;
+	}
+}
+
+static sensors_energy *
+energy_state(const sensors_chip_features *chip,
+	     const sensors_subfeature *subfeature)
+{
+	return chip->state[subfeature - chip->subfeature].energy;
+}
+
+const sensors_subfeature *
+sensors_energy_counter(const sensors_chip_features *chip,
+		       const sensors_subfeature *subfeature)
+{
+	const sensors_energy *energy = energy_state(chip, subfeature);
+
+	return energy ? &chip->subfeature[energy->counter] : NULL;
+}
+
+/* Decide whether a counter which went down by -delta wrapped around or
+   was reset. A counter which stays within 32 bits is taken to wrap at 32
+   bits, unless this makes it jump by more than half its range, or the
+   power more than twice the highest seen so far. Returns the energy
+   difference, or -1 for a reset. */
+static long long energy_wrap(const sensors_energy *energy, long long raw,
+			     long long delta, long long dt)
+{
+	if (energy->last_raw >= ENERGY_WRAP_32 || raw >= ENERGY_WRAP_32)
+		return -1;
+	delta += ENERGY_WRAP_32;
+	if (delta >= ENERGY_WRAP_32 / 2)
+		return -1;
+	if (energy->peak > 0 && delta * 1e3 / dt > 2 * energy->peak)
+		return -1;
+	return delta;
+}
+
+/* Add a sample to the rate state, with energy_lock held */
+static void energy_add(sensors_energy *energy, long long raw, long long ns)
+{
+	long long delta, dt;
+	double power;
+
+	if (!energy->valid) {
+		energy->last_raw = raw;
+		energy->last_ns = ns;
+		energy->valid = 1;
+		return;
+	}
+
+	/* A sample taken before the last one, by the other thread */
+	dt = ns - energy->last_ns;
+	if (dt <= 0)
+		return;
+
+	delta = raw - energy->last_raw;
+	if (delta < 0)
+		delta = energy_wrap(energy, raw, delta, dt);
+	energy->last_raw = raw;
+	energy->last_ns = ns;
+	/* The interval over which the counter was reset is left out */
+	if (delta < 0)
+		return;
+
+	energy->acc_uj += delta;
+	energy->acc_ns += dt;
+	power = delta * 1e3 / dt;	/* uJ/ns to W */
+	if (power > energy->peak)
+		energy->peak = power;
+}
+
+/* The counter was read between start and end, so the middle is the
+   best guess of when its value was latched */
+static long long sample_time(const sensors_timestamp *ts)
+{
+	return ts->start + (ts->end - ts->start) / 2;
+}
+
+void sensors_energy_sample(const sensors_chip_features *chip,
+			   const sensors_subfeature *subfeature,
+			   long long raw, const sensors_timestamp *ts)
+{
+	sensors_energy *energy = energy_state(chip, subfeature);
+
+	pthread_mutex_lock(&energy_lock);
+	energy_add(energy, raw, sample_time(ts));
+	pthread_mutex_unlock(&energy_lock);
+}
+
+int sensors_energy_sampled(const sensors_chip_features *chip,
+			   const sensors_subfeature *subfeature)
+{
+	sensors_energy *energy = energy_state(chip, subfeature);
+	int sampled;
+
+	pthread_mutex_lock(&energy_lock);
+	sampled = energy->sampled;
+	pthread_mutex_unlock(&energy_lock);
+
+	return sampled;
+}
+
+int sensors_energy_power(const sensors_chip_features *chip,
+			 const sensors_subfeature *subfeature, double *value)
+{
+	sensors_energy *energy = energy_state(chip, subfeature);
+	int res = 0;
+
+	pthread_mutex_lock(&energy_lock);
+	if (energy->acc_ns > 0) {
+		energy->power = energy->acc_uj * 1e3 / energy->acc_ns;
+		energy->reported = 1;
+		energy->acc_uj = 0;
+		energy->acc_ns = 0;
+	}
+	/* Without a new interval, the last power still holds */
+	if (energy->reported)
+		*value = energy->power;
+	else
+		res = -SENSORS_ERR_UNAVAILABLE;
+	pthread_mutex_unlock(&energy_lock);
+
+	return res;
+}
+
+int sensors_energy_read(const sensors_chip_features *chip,
+			const sensors_subfeature *subfeature)
+{
+	const sensors_subfeature *counter;
+	sensors_timestamp ts;
+	char n[NAME_MAX];
+	long long raw;
+	int res;
+
+	if (sensors_energy_sampled(chip, subfeature))
+		return 0;
+
+	counter = sensors_energy_counter(chip, subfeature);
+	snprintf(n, NAME_MAX, "%s/%s", chip->chip.path, counter->name);
+	ts.start = sensors_stats_now();
+	res = sensors_read_sysfs_raw(n, &raw);
+	ts.end = sensors_stats_now();
+	if (!res)
+		sensors_energy_sample(chip, subfeature, raw, &ts);
+
+	return res;
+}
+
+/* Sample all counters every sampling_ms milliseconds until told to stop */
+static void *sampler_thread(void *arg)
+{
+	struct timespec next, now;
+	sensors_timestamp ts;
+	long long raw;
+	int i, err;
+
+	(void)arg;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	pthread_mutex_lock(&energy_lock);
+	while (!sampler_stop) {
+		pthread_mutex_unlock(&energy_lock);
+
+		/* The counter list and sampling_ms only change while this
+		   thread is stopped, so they can be used without the lock */
+		for (i = 0; i < sampler_counters_count; i++) {
+			ts.start = sensors_stats_now();
+			err = sensors_read_sysfs_raw(sampler_counters[i].path,
+						     &raw);
+			ts.end = sensors_stats_now();
+			if (err)
+				continue;
+			pthread_mutex_lock(&energy_lock);
+			energy_add(sampler_counters[i].energy, raw,
+				   sample_time(&ts));
+			pthread_mutex_unlock(&energy_lock);
+		}
+
+		next.tv_sec += sampling_ms / 1000;
+		next.tv_nsec += (long)(sampling_ms % 1000) * 1000000;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000;
+		}
+		/* Don't try to catch up after falling behind */
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (now.tv_sec > next.tv_sec ||
+		    (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec))
+			next = now;
+
+		pthread_mutex_lock(&energy_lock);
+		while (!sampler_stop &&
+		       pthread_cond_timedwait(&sampler_cond, &energy_lock,
+					      &next) == 0)
+			;
+	}
+	pthread_mutex_unlock(&energy_lock);
+
+	return NULL;
+}
+
+static void add_counters(sensors_chip_features *chips, int count)
+{
+	struct energy_counter entry;
+	const sensors_subfeature *counter;
+	sensors_energy *energy;
+	int i, j;
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < chips[i].subfeature_count; j++) {
+			energy = chips[i].state[j].energy;
+			if (!energy)
+				continue;
+			counter = &chips[i].subfeature[energy->counter];
+			entry.path = malloc(strlen(chips[i].chip.path) + 1 +
+					    strlen(counter->name) + 1);
+			if (!entry.path)
+				sensors_fatal_error(__func__, "Out of memory");
+			sprintf(entry.path, "%s/%s", chips[i].chip.path,
+				counter->name);
+			entry.energy = energy;
+			sensors_add_array_el(&entry, &sampler_counters,
+					     &sampler_counters_count,
+					     &sampler_counters_max,
+					     sizeof(struct energy_counter));
+		}
+	}
+}
+
+int sensors_energy_start(void)
+{
+	pthread_condattr_t attr;
+	int i;
+
+	if (sampler_running || sampling_ms <= 0)
+		return 0;
+
+	add_counters(sensors_proc_chips, sensors_proc_chips_count);
+	if (!sampler_counters_count)
+		return 0;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&sampler_cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	sampler_stop = 0;
+	if (pthread_create(&sampler, NULL, sampler_thread, NULL)) {
+		pthread_cond_destroy(&sampler_cond);
+		sensors_energy_stop();
+		return -SENSORS_ERR_KERNEL;
+	}
+	sampler_running = 1;
+
+	/* From now on, the counters are only read by the thread */
+	pthread_mutex_lock(&energy_lock);
+	for (i = 0; i < sampler_counters_count; i++)
+		sampler_counters[i].energy->sampled = 1;
+	pthread_mutex_unlock(&energy_lock);
+
+	return 0;
+}
+
+void sensors_energy_stop(void)
+{
+	int i;
+
+	if (sampler_running) {
+		pthread_mutex_lock(&energy_lock);
+		sampler_stop = 1;
+		pthread_cond_signal(&sampler_cond);
+		pthread_mutex_unlock(&energy_lock);
+		pthread_join(sampler, NULL);
+		pthread_cond_destroy(&sampler_cond);
+		sampler_running = 0;
+	}
+
+	pthread_mutex_lock(&energy_lock);
+	for (i = 0; i < sampler_counters_count; i++) {
+		sampler_counters[i].energy->sampled = 0;
+		free(sampler_counters[i].path);
+	}
+	pthread_mutex_unlock(&energy_lock);
+	free(sampler_counters);
+	sampler_counters = NULL;
+	sampler_counters_count = sampler_counters_max = 0;
+}
+
+int sensors_set_energy_sampling(int interval_ms)
+{
+	sensors_energy_stop();
+	sampling_ms = interval_ms > 0 ? interval_ms : 0;
+	return sensors_energy_start();
+}
@@ -0,0 +1,89 @@
+/*
+    energy.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_ENERGY_H
+#define LIB_SENSORS_ENERGY_H
+
+#include "data.h"
+
+/* Non-zero if derived power subfeatures are added to the chips detected
+   from now on, see sensors_set_energy_power() */
+extern int sensors_energy_enabled;
+
+/* Let programs which don't know about derived power subfeatures use them */
+void sensors_energy_getenv(void);
+
+/* Rate state of a derived power subfeature */
+typedef struct sensors_energy {
+	int counter;		/* Subfeature number of the energy counter */
+	int sampled;		/* Sampled by the background thread */
+	int valid;		/* Non-zero if last_raw and last_ns are valid */
+	long long last_raw;	/* Last counter value, in microjoules */
+	long long last_ns;	/* When it was read, CLOCK_MONOTONIC_RAW */
+	long long acc_uj;	/* Energy since the last power reported */
+	long long acc_ns;	/* Time over which acc_uj was measured */
+	double peak;		/* Highest power over a sample interval */
+	int reported;		/* Non-zero if power is valid */
+	double power;		/* Last power reported, in W */
+} sensors_energy;
+
+/* Set up the rate state of the derived subfeatures of a chip whose
+   features were just built */
+void sensors_energy_init(sensors_chip_features *chip);
+
+/* Free the rate state of the derived subfeatures of a chip */
+void sensors_energy_free(sensors_chip_features *chip);
+
+/* Return the energy counter a derived power subfeature is computed from,
+   or NULL if the subfeature isn't a derived one */
+const sensors_subfeature *
+sensors_energy_counter(const sensors_chip_features *chip,
+		       const sensors_subfeature *subfeature);
+
+/* Check whether the energy counter of a derived power subfeature is
+   sampled by the background thread, in which case it must not be read */
+int sensors_energy_sampled(const sensors_chip_features *chip,
+			   const sensors_subfeature *subfeature);
+
+/* Feed the value of the energy counter of a derived power subfeature,
+   read between ts->start and ts->end */
+void sensors_energy_sample(const sensors_chip_features *chip,
+			   const sensors_subfeature *subfeature,
+			   long long raw, const sensors_timestamp *ts);
+
+/* Get the average power, in W, since the previous call. Returns 0 on
+   success, and -SENSORS_ERR_UNAVAILABLE if there is no complete interval
+   yet. */
+int sensors_energy_power(const sensors_chip_features *chip,
+			 const sensors_subfeature *subfeature, double *value);
+
+/* Read and feed the energy counter of a derived power subfeature, unless
+   it is sampled by the background thread. Returns 0 on success, and <0
+   if the counter could not be read. */
+int sensors_energy_read(const sensors_chip_features *chip,
+			const sensors_subfeature *subfeature);
+
+/* Start and stop the background sampling thread, around changes to the
+   detected chips. sensors_energy_start() returns 0 on success, and <0 if
+   the thread could not be started. */
+int sensors_energy_start(void);
+void sensors_energy_stop(void);
+
+#endif /* def LIB_SENSORS_ENERGY_H */
@@ -37,6 +37,8 @@ static const char *errorlist[] = {
 	/* SENSORS_ERR_ACCESS_W  */ "Can't write",
 	/* SENSORS_ERR_IO        */ "I/O error",
 	/* SENSORS_ERR_RECURSION */ "Evaluation recurses too deep",
+	/* SENSORS_ERR_TIMEOUT   */ "Deadline expired",
+	/* SENSORS_ERR_UNAVAILABLE */ "Temporarily unavailable",
 };
 
 const char *sensors_strerror(int errnum)
@@ -33,6 +33,8 @@
 #define SENSORS_ERR_ACCESS_W	9 /* Can't write */
 #define SENSORS_ERR_IO		10 /* I/O error */
 #define SENSORS_ERR_RECURSION	11 /* Evaluation recurses too deep */
+#define SENSORS_ERR_TIMEOUT	12 /* Deadline expired */
+#define SENSORS_ERR_UNAVAILABLE	13 /* Failing repeatedly, not read */
 
 #ifdef __cplusplus
 extern "C" {
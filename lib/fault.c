@@ -0,0 +1,189 @@
+/*
+    fault.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <time.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "fault.h"
+
+/* Fault policy, see sensors_set_fault_policy(). A threshold of 0 means
+   failures are counted, but reads are never skipped. */
+static int fault_threshold;
+static int fault_min_ms;
+static int fault_max_ms;
+
+void sensors_set_fault_policy(int threshold, int min_ms, int max_ms)
+{
+	if (threshold < 0)
+		threshold = 0;
+	if (min_ms < 1)
+		min_ms = 1;
+	if (max_ms < min_ms)
+		max_ms = min_ms;
+
+	fault_threshold = threshold;
+	fault_min_ms = min_ms;
+	fault_max_ms = max_ms;
+}
+
+/* Only errors which come from the device count as failures */
+static int is_device_error(int err)
+{
+	switch (-err) {
+	case SENSORS_ERR_ACCESS_R:
+	case SENSORS_ERR_KERNEL:
+	case SENSORS_ERR_IO:
+	case SENSORS_ERR_TIMEOUT:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Milliseconds left until t, 0 if t is in the past */
+static int ms_until(const struct timespec *t, const struct timespec *now)
+{
+	long long ms;
+
+	ms = (long long)(t->tv_sec - now->tv_sec) * 1000 +
+	     (t->tv_nsec - now->tv_nsec) / 1000000;
+	return ms > 0 ? (int)ms : 0;
+}
+
+static int breaker_open(const sensors_breaker *breaker,
+			const struct timespec *now)
+{
+	return breaker->backoff_ms && ms_until(&breaker->retry, now) > 0;
+}
+
+static void breaker_fail(sensors_breaker *breaker, const struct timespec *now)
+{
+	breaker->failures++;
+	if (!fault_threshold || breaker->failures < fault_threshold)
+		return;
+
+	/* Each failed retry doubles the delay, up to fault_max_ms */
+	if (!breaker->backoff_ms)
+		breaker->backoff_ms = fault_min_ms;
+	else if (breaker->backoff_ms > fault_max_ms / 2)
+		breaker->backoff_ms = fault_max_ms;
+	else
+		breaker->backoff_ms *= 2;
+
+	breaker->retry = *now;
+	breaker->retry.tv_sec += breaker->backoff_ms / 1000;
+	breaker->retry.tv_nsec += (long)(breaker->backoff_ms % 1000) * 1000000;
+	if (breaker->retry.tv_nsec >= 1000000000) {
+		breaker->retry.tv_sec++;
+		breaker->retry.tv_nsec -= 1000000000;
+	}
+}
+
+static void breaker_reset(sensors_breaker *breaker)
+{
+	breaker->failures = 0;
+	breaker->backoff_ms = 0;
+}
+
+int sensors_fault_check(const sensors_chip_features *chip_features,
+			const sensors_subfeature *subfeature)
+{
+	const sensors_breaker *breaker;
+	struct timespec now;
+
+	breaker = &chip_features->state[subfeature - chip_features->subfeature]
+		  .breaker;
+	if (!chip_features->breaker.backoff_ms && !breaker->backoff_ms)
+		return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (breaker_open(&chip_features->breaker, &now) ||
+	    breaker_open(breaker, &now))
+		return -SENSORS_ERR_UNAVAILABLE;
+	return 0;
+}
+
+void sensors_fault_record(const sensors_chip_features *chip_features,
+			  const sensors_subfeature *subfeature, int err)
+{
+	sensors_chip_features *chip = sensors_chip_rw(chip_features);
+	sensors_breaker *breaker;
+	struct timespec now;
+
+	breaker = &chip->state[subfeature - chip->subfeature].breaker;
+	if (!breaker->recorded) {
+		breaker->recorded = 1;
+		chip->breaker.recorded++;
+	}
+	if (!err) {
+		if (breaker->failures)
+			chip->breaker.failing--;
+		breaker_reset(breaker);
+		breaker_reset(&chip->breaker);
+		return;
+	}
+	if (!is_device_error(err))
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (!breaker->failures)
+		chip->breaker.failing++;
+	breaker_fail(breaker, &now);
+
+	/* A few dead channels must not take the healthy ones down with them,
+	   so the chip only fails as a whole when nothing on it reads */
+	if (chip->breaker.failing == chip->breaker.recorded)
+		breaker_fail(&chip->breaker, &now);
+}
+
+static void fill_fault_state(const sensors_breaker *breaker,
+			     const struct timespec *now,
+			     sensors_fault_state *state)
+{
+	state->failures = breaker->failures;
+	state->backoff_ms = breaker->backoff_ms;
+	state->retry_ms = breaker->backoff_ms ?
+			  ms_until(&breaker->retry, now) : 0;
+}
+
+int sensors_get_fault_state(const sensors_chip_name *name, int subfeat_nr,
+			    sensors_fault_state *state)
+{
+	const sensors_chip_features *chip_features;
+	struct timespec now;
+
+	if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	if (!(chip_features = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (subfeat_nr < 0) {
+		fill_fault_state(&chip_features->breaker, &now, state);
+		return 0;
+	}
+	if (subfeat_nr >= chip_features->subfeature_count)
+		return -SENSORS_ERR_NO_ENTRY;
+	fill_fault_state(&chip_features->state[subfeat_nr].breaker, &now,
+			 state);
+	return 0;
+}
@@ -0,0 +1,37 @@
+/*
+    fault.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_FAULT_H
+#define LIB_SENSORS_FAULT_H
+
+#include "data.h"
+
+/* Check whether a subfeature should be read at all. Returns 0 if it
+   should, and -SENSORS_ERR_UNAVAILABLE if it or its chip has failed too
+   many times in a row and its backoff delay isn't over yet. */
+int sensors_fault_check(const sensors_chip_features *chip_features,
+			const sensors_subfeature *subfeature);
+
+/* Record the outcome of a read from the kernel. err is 0 on success, and
+   the error returned by the read otherwise. */
+void sensors_fault_record(const sensors_chip_features *chip_features,
+			  const sensors_subfeature *subfeature, int err);
+
+#endif /* def LIB_SENSORS_FAULT_H */
@@ -39,6 +39,17 @@ void sensors_malloc_array(void *list, int *num_el, int *max_el, int el_size)
 	*num_el = 0;
 }
 
+/* Arrays double in size when they are full, so that adding n elements
+   one at a time only reallocates and copies them O(log n) times */
+static int grow_max(int max_el, int needed)
+{
+	int new_max_el = max_el < A_BUNCH ? A_BUNCH : max_el;
+
+	while (new_max_el < needed)
+		new_max_el *= 2;
+	return new_max_el;
+}
+
 void sensors_free_array(void *list, int *num_el, int *max_el)
 {
 	void **my_list = (void **)list;
@@ -55,7 +66,7 @@ void sensors_add_array_el(const void *el, void *list, int *num_el,
 	int new_max_el;
 	void **my_list = (void *)list;
 	if (*num_el + 1 > *max_el) {
-		new_max_el = *max_el + A_BUNCH;
+		new_max_el = grow_max(*max_el, *num_el + 1);
 		*my_list = realloc(*my_list, new_max_el * el_size);
 		if (! *my_list)
 			sensors_fatal_error(__func__,
@@ -72,8 +83,7 @@ void sensors_add_array_els(const void *els, int nr_els, void *list,
 	int new_max_el;
 	void **my_list = (void *)list;
 	if (*num_el + nr_els > *max_el) {
-		new_max_el = (*max_el + nr_els + A_BUNCH);
-		new_max_el -= new_max_el % A_BUNCH;
+		new_max_el = grow_max(*max_el, *num_el + nr_els);
 		*my_list = realloc(*my_list, new_max_el * el_size);
 		if (! *my_list)
 			sensors_fatal_error(__func__,
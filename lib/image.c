@@ -0,0 +1,794 @@
+/*
+    image.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "init.h"
+#include "image.h"
+
+/*
+ * A compiled configuration image holds the chip and bus statements of
+ * the default configuration files before bus substitution, which depends
+ * on the buses present when it is loaded. It is made of a header, a list
+ * of sources and a list of files. Sources are all the paths the contents
+ * of the configuration depends on, including the ones which didn't exist
+ * and the sensors.d directory itself, with their identity: the image is
+ * only used if none of them changed. The header tells how many of the
+ * files come from the main configuration file, before sensors.d. All
+ * values are in host byte order, and there are no pointers, only sizes
+ * and counts, so the image can be read from anywhere it is mapped.
+ *
+ * Strings are a 32-bit length followed by the characters and a NUL byte,
+ * with NO_STRING as the length of NULL strings. Expressions are written
+ * in prefix order, with NO_EXPR as the kind of missing subexpressions.
+ */
+#define IMAGE_MAGIC		"SENSCONF"
+#define IMAGE_VERSION		3
+#define IMAGE_BYTE_ORDER	0x01020304
+
+#define NO_STRING		0xffffffff
+#define NO_EXPR			0xffffffff
+
+/* Expressions nested deeper than this are considered corrupt */
+#define EXPR_DEPTH_MAX		1000
+
+struct buffer {
+	char *data;
+	size_t len;
+	size_t max;
+};
+
+static int image_active;
+static struct buffer image_sources;
+static struct buffer image_files;
+static unsigned int image_sources_count;
+static unsigned int image_files_count;
+static unsigned int image_main_count;
+
+/* Writing */
+
+static void put(struct buffer *buf, const void *data, size_t len)
+{
+	if (buf->len + len > buf->max) {
+		buf->max = (buf->len + len) * 2;
+		buf->data = realloc(buf->data, buf->max);
+		if (!buf->data)
+			sensors_fatal_error(__func__, "Out of memory");
+	}
+	memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+}
+
+static void put_u32(struct buffer *buf, uint32_t val)
+{
+	put(buf, &val, sizeof(val));
+}
+
+static void put_i64(struct buffer *buf, int64_t val)
+{
+	put(buf, &val, sizeof(val));
+}
+
+static void put_double(struct buffer *buf, double val)
+{
+	put(buf, &val, sizeof(val));
+}
+
+static void put_str(struct buffer *buf, const char *str)
+{
+	size_t len;
+
+	if (!str) {
+		put_u32(buf, NO_STRING);
+		return;
+	}
+	len = strlen(str);
+	put_u32(buf, len);
+	put(buf, str, len + 1);
+}
+
+static void put_expr(struct buffer *buf, const sensors_expr *expr)
+{
+	if (!expr) {
+		put_u32(buf, NO_EXPR);
+		return;
+	}
+
+	put_u32(buf, expr->kind);
+	switch (expr->kind) {
+	case sensors_kind_val:
+		put_double(buf, expr->data.val);
+		break;
+	case sensors_kind_source:
+		break;
+	case sensors_kind_var:
+		put_str(buf, expr->data.var);
+		break;
+	case sensors_kind_sub:
+		put_u32(buf, expr->data.subexpr.op);
+		put_expr(buf, expr->data.subexpr.sub1);
+		put_expr(buf, expr->data.subexpr.sub2);
+		break;
+	}
+}
+
+/* Identity of a path, all zero if it doesn't exist */
+static void put_identity(struct buffer *buf, const struct stat *st)
+{
+	put_i64(buf, st ? (int64_t)st->st_dev : 0);
+	put_i64(buf, st ? (int64_t)st->st_ino : 0);
+	put_i64(buf, st ? (int64_t)st->st_size : 0);
+	put_i64(buf, st ? (int64_t)st->st_mtim.tv_sec : 0);
+	put_i64(buf, st ? (int64_t)st->st_mtim.tv_nsec : 0);
+}
+
+static void add_source(const char *path, const struct stat *st)
+{
+	put_str(&image_sources, path);
+	put_identity(&image_sources, st);
+	image_sources_count++;
+}
+
+/* Record a path as it is now, whether it exists or not */
+static void add_source_path(const char *path)
+{
+	struct stat st;
+
+	add_source(path, stat(path, &st) ? NULL : &st);
+}
+
+int sensors_image_compiling(void)
+{
+	return image_active;
+}
+
+void sensors_image_begin(void)
+{
+	struct stat st;
+
+	image_active = 1;
+
+	/* The alternate file is only used if the default one is missing */
+	add_source_path(DEFAULT_CONFIG_FILE);
+	if (stat(DEFAULT_CONFIG_FILE, &st))
+		add_source_path(ALT_CONFIG_FILE);
+	/* Files added or removed change the directory */
+	add_source_path(DEFAULT_CONFIG_DIR);
+}
+
+static void put_chip(struct buffer *buf, const sensors_chip *chip)
+{
+	const sensors_chip_name *name;
+	int i;
+
+	put_u32(buf, chip->line.lineno);
+
+	put_u32(buf, chip->chips.fits_count);
+	for (i = 0; i < chip->chips.fits_count; i++) {
+		name = &chip->chips.fits[i];
+		put_str(buf, name->prefix);
+		put_u32(buf, (uint16_t)name->bus.type);
+		put_u32(buf, (uint16_t)name->bus.nr);
+		put_u32(buf, name->addr);
+		put_str(buf, name->path);
+	}
+
+	put_u32(buf, chip->labels_count);
+	for (i = 0; i < chip->labels_count; i++) {
+		put_u32(buf, chip->labels[i].line.lineno);
+		put_str(buf, chip->labels[i].name);
+		put_str(buf, chip->labels[i].value);
+	}
+
+	put_u32(buf, chip->sets_count);
+	for (i = 0; i < chip->sets_count; i++) {
+		put_u32(buf, chip->sets[i].line.lineno);
+		put_str(buf, chip->sets[i].name);
+		put_expr(buf, chip->sets[i].value);
+	}
+
+	put_u32(buf, chip->computes_count);
+	for (i = 0; i < chip->computes_count; i++) {
+		put_u32(buf, chip->computes[i].line.lineno);
+		put_str(buf, chip->computes[i].name);
+		put_expr(buf, chip->computes[i].from_proc);
+		put_expr(buf, chip->computes[i].to_proc);
+	}
+
+	put_u32(buf, chip->ignores_count);
+	for (i = 0; i < chip->ignores_count; i++) {
+		put_u32(buf, chip->ignores[i].line.lineno);
+		put_str(buf, chip->ignores[i].name);
+	}
+
+	put_u32(buf, chip->defines_count);
+	for (i = 0; i < chip->defines_count; i++) {
+		put_u32(buf, chip->defines[i].line.lineno);
+		put_str(buf, chip->defines[i].name);
+		put_expr(buf, chip->defines[i].value);
+	}
+}
+
+void sensors_image_add_file(FILE *input, const char *name, int first_chip)
+{
+	struct buffer *buf = &image_files;
+	struct stat st;
+	int i;
+
+	add_source(name, fstat(fileno(input), &st) ? NULL : &st);
+
+	put_str(buf, name);
+
+	put_u32(buf, sensors_config_busses_count);
+	for (i = 0; i < sensors_config_busses_count; i++) {
+		put_u32(buf, sensors_config_busses[i].line.lineno);
+		put_u32(buf, (uint16_t)sensors_config_busses[i].bus.type);
+		put_u32(buf, (uint16_t)sensors_config_busses[i].bus.nr);
+		put_str(buf, sensors_config_busses[i].adapter);
+	}
+
+	put_u32(buf, sensors_config_chips_count - first_chip);
+	for (i = first_chip; i < sensors_config_chips_count; i++)
+		put_chip(buf, &sensors_config_chips[i]);
+
+	image_files_count++;
+}
+
+void sensors_image_end_main(void)
+{
+	image_main_count = image_files_count;
+}
+
+static int write_image(const char *filename)
+{
+	struct buffer header = { NULL, 0, 0 };
+	char *tmp;
+	FILE *f;
+	int res = 0;
+
+	put(&header, IMAGE_MAGIC, 8);
+	put_u32(&header, IMAGE_VERSION);
+	put_u32(&header, IMAGE_BYTE_ORDER);
+	put_u32(&header, image_sources_count);
+	put_u32(&header, image_files_count);
+	put_u32(&header, image_main_count);
+	put_i64(&header, image_sources.len);
+	put_i64(&header, image_files.len);
+
+	/* Write to a temporary file, so that readers never see a partial
+	   image */
+	tmp = malloc(strlen(filename) + 5);
+	if (!tmp)
+		sensors_fatal_error(__func__, "Out of memory");
+	sprintf(tmp, "%s.new", filename);
+
+	f = fopen(tmp, "w");
+	if (!f) {
+		res = -SENSORS_ERR_IO;
+		goto exit_free;
+	}
+	if (fwrite(header.data, header.len, 1, f) != 1 ||
+	    (image_sources.len &&
+	     fwrite(image_sources.data, image_sources.len, 1, f) != 1) ||
+	    (image_files.len &&
+	     fwrite(image_files.data, image_files.len, 1, f) != 1))
+		res = -SENSORS_ERR_IO;
+	if (fclose(f) && !res)
+		res = -SENSORS_ERR_IO;
+	if (!res && rename(tmp, filename))
+		res = -SENSORS_ERR_IO;
+	if (res)
+		unlink(tmp);
+
+exit_free:
+	free(tmp);
+	free(header.data);
+	return res;
+}
+
+size_t sensors_image_take_files(char **data)
+{
+	size_t len = image_files.len;
+
+	*data = image_files.data;
+	memset(&image_files, 0, sizeof(image_files));
+	image_files_count = image_main_count = 0;
+	return len;
+}
+
+int sensors_image_end(const char *filename)
+{
+	int res = 0;
+
+	if (filename)
+		res = write_image(filename);
+
+	free(image_sources.data);
+	free(image_files.data);
+	memset(&image_sources, 0, sizeof(image_sources));
+	memset(&image_files, 0, sizeof(image_files));
+	image_sources_count = image_files_count = image_main_count = 0;
+	image_active = 0;
+
+	return res;
+}
+
+/* Reading */
+
+/* Position in a mapped image. Reading past the end sets err, and returns
+   zeroes from there on. */
+struct reader {
+	const char *p;
+	const char *end;
+	int err;
+};
+
+static void get(struct reader *r, void *data, size_t len)
+{
+	if (r->err || (size_t)(r->end - r->p) < len) {
+		r->err = 1;
+		memset(data, 0, len);
+		return;
+	}
+	memcpy(data, r->p, len);
+	r->p += len;
+}
+
+static uint32_t get_u32(struct reader *r)
+{
+	uint32_t val;
+
+	get(r, &val, sizeof(val));
+	return val;
+}
+
+static int64_t get_i64(struct reader *r)
+{
+	int64_t val;
+
+	get(r, &val, sizeof(val));
+	return val;
+}
+
+static double get_double(struct reader *r)
+{
+	double val;
+
+	get(r, &val, sizeof(val));
+	return val;
+}
+
+/* Returns a pointer into the image, or NULL */
+static const char *get_str_ptr(struct reader *r)
+{
+	const char *str;
+	uint32_t len;
+
+	len = get_u32(r);
+	if (r->err || len == NO_STRING)
+		return NULL;
+	if ((size_t)(r->end - r->p) <= len || r->p[len] != '\0') {
+		r->err = 1;
+		return NULL;
+	}
+	str = r->p;
+	r->p += len + 1;
+	return str;
+}
+
+static char *get_str(struct reader *r)
+{
+	const char *str;
+	char *copy;
+
+	str = get_str_ptr(r);
+	if (!str)
+		return NULL;
+	copy = strdup(str);
+	if (!copy)
+		sensors_fatal_error(__func__, "Out of memory");
+	return copy;
+}
+
+/* Same as get_str(), but a NULL string is an error */
+static char *get_name(struct reader *r)
+{
+	char *str;
+
+	str = get_str(r);
+	if (!str)
+		r->err = 1;
+	return str;
+}
+
+/* The evaluation of a conditional relies on it being built properly */
+static int is_choice(const sensors_expr *expr)
+{
+	return expr && expr->kind == sensors_kind_sub &&
+	       expr->data.subexpr.op == sensors_choice &&
+	       expr->data.subexpr.sub1 && expr->data.subexpr.sub2;
+}
+
+/* So does the evaluation of an aggregate */
+static int is_aggregate_of_var(const sensors_expr *expr)
+{
+	return expr->data.subexpr.sub1 &&
+	       expr->data.subexpr.sub1->kind == sensors_kind_var &&
+	       !expr->data.subexpr.sub2;
+}
+
+static sensors_expr *get_expr(struct reader *r, int depth)
+{
+	sensors_expr *expr;
+	uint32_t kind;
+
+	kind = get_u32(r);
+	if (r->err || kind == NO_EXPR)
+		return NULL;
+	if (depth >= EXPR_DEPTH_MAX || kind > sensors_kind_sub) {
+		r->err = 1;
+		return NULL;
+	}
+
+	expr = calloc(1, sizeof(sensors_expr));
+	if (!expr)
+		sensors_fatal_error(__func__, "Out of memory");
+	expr->kind = kind;
+	switch (expr->kind) {
+	case sensors_kind_val:
+		expr->data.val = get_double(r);
+		break;
+	case sensors_kind_source:
+		break;
+	case sensors_kind_var:
+		expr->data.var = get_name(r);
+		break;
+	case sensors_kind_sub:
+		expr->data.subexpr.op = get_u32(r);
+		if (expr->data.subexpr.op > sensors_agg_avg)
+			r->err = 1;
+		expr->data.subexpr.sub1 = get_expr(r, depth + 1);
+		expr->data.subexpr.sub2 = get_expr(r, depth + 1);
+		if (expr->data.subexpr.op == sensors_cond &&
+		    !is_choice(expr->data.subexpr.sub2))
+			r->err = 1;
+		if (expr->data.subexpr.op >= sensors_agg_min &&
+		    !is_aggregate_of_var(expr))
+			r->err = 1;
+		break;
+	}
+	return expr;
+}
+
+/* Expressions which must be there */
+static sensors_expr *get_expr_required(struct reader *r)
+{
+	sensors_expr *expr;
+
+	expr = get_expr(r, 0);
+	if (!expr)
+		r->err = 1;
+	return expr;
+}
+
+/* Read a count of elements, each taking at least min_size bytes */
+static int get_count(struct reader *r, size_t min_size)
+{
+	uint32_t count;
+
+	count = get_u32(r);
+	if (count > INT_MAX || count > (size_t)(r->end - r->p) / min_size) {
+		r->err = 1;
+		return 0;
+	}
+	return count;
+}
+
+static void get_line(struct reader *r, sensors_config_line *line,
+		     const char *filename)
+{
+	line->filename = filename;
+	line->lineno = get_u32(r);
+}
+
+/* Read a chip statement into sensors_config_chips. It is added even if
+   it is incomplete, so that it gets freed along with the others. */
+static void get_chip(struct reader *r, const char *filename)
+{
+	sensors_chip chip, *c;
+	sensors_chip_name name;
+	sensors_label label;
+	sensors_set set;
+	sensors_compute compute;
+	sensors_ignore ignore;
+	sensors_define define;
+	int i, count;
+
+	memset(&chip, 0, sizeof(chip));
+	get_line(r, &chip.line, filename);
+	sensors_add_array_el(&chip, &sensors_config_chips,
+			     &sensors_config_chips_count,
+			     &sensors_config_chips_max, sizeof(sensors_chip));
+	c = &sensors_config_chips[sensors_config_chips_count - 1];
+
+	count = get_count(r, 4 * 5);
+	for (i = 0; i < count; i++) {
+		name.prefix = get_str(r);
+		name.bus.type = (short)get_u32(r);
+		name.bus.nr = (short)get_u32(r);
+		name.addr = get_u32(r);
+		name.path = get_str(r);
+		if (r->err) {
+			free(name.prefix);
+			free(name.path);
+			break;
+		}
+		sensors_add_array_el(&name, &c->chips.fits,
+				     &c->chips.fits_count, &c->chips.fits_max,
+				     sizeof(sensors_chip_name));
+	}
+
+	count = get_count(r, 4 * 3);
+	for (i = 0; i < count; i++) {
+		get_line(r, &label.line, filename);
+		label.name = get_name(r);
+		label.value = get_name(r);
+		if (r->err) {
+			free(label.name);
+			free(label.value);
+			break;
+		}
+		sensors_add_array_el(&label, &c->labels, &c->labels_count,
+				     &c->labels_max, sizeof(sensors_label));
+	}
+
+	count = get_count(r, 4 * 3);
+	for (i = 0; i < count; i++) {
+		get_line(r, &set.line, filename);
+		set.name = get_name(r);
+		set.value = get_expr_required(r);
+		if (r->err) {
+			free(set.name);
+			if (set.value)
+				sensors_free_expr(set.value);
+			break;
+		}
+		sensors_add_array_el(&set, &c->sets, &c->sets_count,
+				     &c->sets_max, sizeof(sensors_set));
+	}
+
+	count = get_count(r, 4 * 4);
+	for (i = 0; i < count; i++) {
+		get_line(r, &compute.line, filename);
+		compute.name = get_name(r);
+		compute.from_proc = get_expr_required(r);
+		compute.to_proc = get_expr_required(r);
+		if (r->err) {
+			free(compute.name);
+			if (compute.from_proc)
+				sensors_free_expr(compute.from_proc);
+			if (compute.to_proc)
+				sensors_free_expr(compute.to_proc);
+			break;
+		}
+		sensors_add_array_el(&compute, &c->computes,
+				     &c->computes_count, &c->computes_max,
+				     sizeof(sensors_compute));
+	}
+
+	count = get_count(r, 4 * 2);
+	for (i = 0; i < count; i++) {
+		get_line(r, &ignore.line, filename);
+		ignore.name = get_name(r);
+		if (r->err)
+			break;
+		sensors_add_array_el(&ignore, &c->ignores, &c->ignores_count,
+				     &c->ignores_max, sizeof(sensors_ignore));
+	}
+
+	count = get_count(r, 4 * 3);
+	for (i = 0; i < count; i++) {
+		get_line(r, &define.line, filename);
+		define.name = get_name(r);
+		define.value = get_expr_required(r);
+		if (r->err) {
+			free(define.name);
+			if (define.value)
+				sensors_free_expr(define.value);
+			break;
+		}
+		sensors_add_array_el(&define, &c->defines, &c->defines_count,
+				     &c->defines_max, sizeof(sensors_define));
+	}
+}
+
+/* Check that a source still has the identity recorded in the image */
+static int source_unchanged(struct reader *r)
+{
+	const char *path;
+	struct stat st;
+	int64_t id[5];
+	int i, exists;
+
+	path = get_str_ptr(r);
+	for (i = 0; i < 5; i++)
+		id[i] = get_i64(r);
+	if (r->err || !path)
+		return 0;
+
+	exists = !stat(path, &st);
+	if (!exists)
+		return !id[0] && !id[1] && errno == ENOENT;
+	return id[0] == (int64_t)st.st_dev && id[1] == (int64_t)st.st_ino &&
+	       id[2] == (int64_t)st.st_size &&
+	       id[3] == (int64_t)st.st_mtim.tv_sec &&
+	       id[4] == (int64_t)st.st_mtim.tv_nsec;
+}
+
+/* Read the statements of a configuration file, and substitute buses as
+   parsing it would */
+static int get_file(struct reader *r)
+{
+	sensors_bus bus;
+	char *filename;
+	int i, count, res;
+
+	filename = get_name(r);
+	if (!filename)
+		return 0;
+	/* Record configuration file name for error reporting */
+	sensors_add_config_files(&filename);
+
+	count = get_count(r, 4 * 4);
+	for (i = 0; i < count; i++) {
+		get_line(r, &bus.line, filename);
+		bus.bus.type = (short)get_u32(r);
+		bus.bus.nr = (short)get_u32(r);
+		bus.adapter = get_name(r);
+		if (r->err)
+			break;
+		sensors_add_array_el(&bus, &sensors_config_busses,
+				     &sensors_config_busses_count,
+				     &sensors_config_busses_max,
+				     sizeof(sensors_bus));
+	}
+
+	count = get_count(r, 4 * 6);
+	for (i = 0; i < count && !r->err; i++)
+		get_chip(r, filename);
+
+	res = r->err ? 0 : sensors_substitute_busses();
+	sensors_free_config_busses();
+	return res;
+}
+
+/* Load the files of an image, calling after_main once the first
+   main_count of them were loaded */
+static int load_files(struct reader *r, unsigned int count,
+		      unsigned int main_count, int (*after_main)(void))
+{
+	unsigned int i;
+	int chips, names, err, res = 0;
+
+	/* Any error from here on leaves the configuration as it was */
+	chips = sensors_config_chips_count;
+	names = sensors_config_files_count;
+	for (i = 0; i <= count && !r->err; i++) {
+		if (i == main_count && after_main) {
+			err = after_main();
+			if (err) {
+				sensors_free_config_from(chips, names);
+				return err;
+			}
+		}
+		if (i == count)
+			break;
+		err = get_file(r);
+		if (err)
+			res = err;
+	}
+	if (r->err || r->p != r->end) {
+		sensors_free_config_from(chips, names);
+		res = 1;
+	}
+
+	return res;
+}
+
+int sensors_image_load_files(const char *data, size_t len,
+			     unsigned int count)
+{
+	struct reader r;
+
+	r.p = data;
+	r.end = data + len;
+	r.err = 0;
+
+	return load_files(&r, count, count, NULL);
+}
+
+int sensors_image_load(const char *filename, int (*after_main)(void))
+{
+	struct reader r;
+	struct stat st;
+	void *map;
+	char magic[8];
+	int64_t len;
+	unsigned int i, sources, files, main_count;
+	int fd, res;
+
+	fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return 1;
+	if (fstat(fd, &st) < 0 || st.st_size == 0) {
+		close(fd);
+		return 1;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 1;
+
+	r.p = map;
+	r.end = r.p + st.st_size;
+	r.err = 0;
+
+	get(&r, magic, sizeof(magic));
+	if (memcmp(magic, IMAGE_MAGIC, sizeof(magic)) ||
+	    get_u32(&r) != IMAGE_VERSION ||
+	    get_u32(&r) != IMAGE_BYTE_ORDER) {
+		munmap(map, st.st_size);
+		return 1;
+	}
+	sources = get_u32(&r);
+	files = get_u32(&r);
+	main_count = get_u32(&r);
+	len = get_i64(&r);
+	len += get_i64(&r);
+	if (r.err || main_count > files || len != r.end - r.p) {
+		munmap(map, st.st_size);
+		return 1;
+	}
+
+	for (i = 0; i < sources; i++) {
+		if (!source_unchanged(&r)) {
+			munmap(map, st.st_size);
+			return 1;
+		}
+	}
+
+	res = load_files(&r, files, main_count, after_main);
+
+	munmap(map, st.st_size);
+	return res;
+}
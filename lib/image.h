@@ -0,0 +1,64 @@
+/*
+    image.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_IMAGE_H
+#define LIB_SENSORS_IMAGE_H
+
+#include <stdio.h>
+
+/* Load the configuration from the compiled image filename, if it is up
+   to date with the configuration files it was compiled from. Returns 0
+   if the configuration was loaded, 1 if the image is missing, stale or
+   invalid so the configuration files must be parsed instead, and <0 if
+   the configuration was loaded but bus substitution or after_main
+   failed. If not NULL, after_main is called between the statements of
+   the main configuration file and those of the sensors.d directory. */
+int sensors_image_load(const char *filename, int (*after_main)(void));
+
+/* Non-zero while an image is being compiled */
+int sensors_image_compiling(void);
+
+/* Start compiling an image of the default configuration files */
+void sensors_image_begin(void);
+
+/* Add a configuration file, opened as input, which was just parsed: its
+   chip statements from first_chip on, and its bus statements. Must be
+   called before bus substitution. */
+void sensors_image_add_file(FILE *input, const char *name, int first_chip);
+
+/* Mark the files added so far as those of the main configuration file */
+void sensors_image_end_main(void);
+
+/* Take over the files compiled so far, to store them somewhere else than
+   in an image: *data is set to a buffer the caller must free, and its
+   length is returned. */
+size_t sensors_image_take_files(char **data);
+
+/* Load count files from data, as stored in an image. Returns 0 if they
+   were loaded, 1 if data is invalid, and <0 if they were loaded but bus
+   substitution failed. */
+int sensors_image_load_files(const char *data, size_t len,
+			     unsigned int count);
+
+/* Write the image compiled so far to filename, or discard it if filename
+   is NULL. Returns 0 on success, and <0 on failure. */
+int sensors_image_end(const char *filename);
+
+#endif /* def LIB_SENSORS_IMAGE_H */
@@ -32,43 +32,45 @@
 #include <errno.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <pthread.h>
 #include "sensors.h"
 #include "data.h"
 #include "error.h"
 #include "access.h"
 #include "conf.h"
 #include "sysfs.h"
+#include "backend.h"
+#include "stats.h"
+#include "probes.h"
 #include "scanner.h"
+#include "image.h"
+#include "boards.h"
+#include "virtual.h"
+#include "energy.h"
 #include "init.h"
 
-#define DEFAULT_CONFIG_FILE	ETCDIR "/sensors3.conf"
-#define ALT_CONFIG_FILE		ETCDIR "/sensors.conf"
-#define DEFAULT_CONFIG_DIR	ETCDIR "/sensors.d"
+/* Maximum number of threads parsing configuration files */
+#define PARSE_THREADS_MAX	8
 
-/* Wrapper around sensors_yyparse(), which clears the locale so that
-   the decimal numbers are always parsed properly. */
-static int sensors_parse(void)
+static void free_chip(sensors_chip *chip);
+
+/* Wrapper around sensors_yyparse(), which switches the calling thread to
+   the C locale so that the decimal numbers are always parsed properly.
+   The locale of the other threads is not affected. */
+static int sensors_parse(sensors_parse_state *state, void *scanner)
 {
+	locale_t c_locale, locale;
 	int res;
-	char *locale;
 
-	/* Remember the current locale and clear it */
-	locale = setlocale(LC_ALL, NULL);
-	if (locale) {
-		locale = strdup(locale);
-		if (!locale)
-			sensors_fatal_error(__func__, "Out of memory");
+	c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+	if (!c_locale)
+		sensors_fatal_error(__func__, "Out of memory");
+	locale = uselocale(c_locale);
 
-		setlocale(LC_ALL, "C");
-	}
+	res = sensors_yyparse(state, scanner);
 
-	res = sensors_yyparse();
-
-	/* Restore the old locale */
-	if (locale) {
-		setlocale(LC_ALL, locale);
-		free(locale);
-	}
+	uselocale(locale);
+	freelocale(c_locale);
 
 	return res;
 }
@@ -78,7 +80,7 @@ static void free_bus(sensors_bus *bus)
 	free(bus->adapter);
 }
 
-static void free_config_busses(void)
+void sensors_free_config_busses(void)
 {
 	int i;
 
@@ -89,47 +91,398 @@ static void free_config_busses(void)
 	sensors_config_busses_count = sensors_config_busses_max = 0;
 }
 
-static int parse_config(FILE *input, const char *name)
+static void init_parse_state(sensors_parse_state *state, const char *name)
 {
-	int err;
-	char *name_copy;
-
+	memset(state, 0, sizeof(sensors_parse_state));
 	if (name) {
-		/* Record configuration file name for error reporting */
-		name_copy = strdup(name);
-		if (!name_copy)
+		state->filename = strdup(name);
+		if (!state->filename)
 			sensors_fatal_error(__func__, "Out of memory");
-		sensors_add_config_files(&name_copy);
-	} else
-		name_copy = NULL;
+	}
+}
 
-	if (sensors_scanner_init(input, name_copy)) {
-		err = -SENSORS_ERR_PARSE;
-		goto exit_cleanup;
+static void free_parse_state(sensors_parse_state *state)
+{
+	int i;
+
+	free(state->filename);
+	state->filename = NULL;
+
+	for (i = 0; i < state->chips_count; i++)
+		free_chip(&state->chips[i]);
+	free(state->chips);
+	state->chips = NULL;
+	state->chips_count = state->chips_max = 0;
+
+	for (i = 0; i < state->busses_count; i++)
+		free_bus(&state->busses[i]);
+	free(state->busses);
+	state->busses = NULL;
+	state->busses_count = state->busses_max = 0;
+
+	for (i = 0; i < state->errors_count; i++)
+		free(state->errors[i].msg);
+	free(state->errors);
+	state->errors = NULL;
+	state->errors_count = state->errors_max = 0;
+}
+
+/* Parse input into state. This only touches state, so it can be called
+   for several files at once from different threads. Returns 0 on
+   success, and -SENSORS_ERR_PARSE if the file had errors. */
+static int parse_file(sensors_parse_state *state, FILE *input)
+{
+	void *scanner;
+	int err;
+
+	SENSORS_PROBE1(config__start, state->filename);
+	if (sensors_scanner_init(state, input, &scanner))
+		return -SENSORS_ERR_PARSE;
+	err = sensors_parse(state, scanner);
+	sensors_scanner_exit(state, scanner);
+
+	return err ? -SENSORS_ERR_PARSE : 0;
+}
+
+/* Add what was parsed from input into state to the configuration, after
+   reporting the errors found, and substitute the bus numbers of its chip
+   statements. err is the result of parse_file(). The state is freed. */
+static int add_parsed_config(sensors_parse_state *state, FILE *input,
+			     int err)
+{
+	int i, first_chip = sensors_config_chips_count;
+	char *name = state->filename;
+
+	/* Record configuration file name for error reporting */
+	if (name) {
+		sensors_add_config_files(&name);
+		state->filename = NULL;
 	}
-	err = sensors_parse();
-	sensors_scanner_exit();
-	if (err) {
-		err = -SENSORS_ERR_PARSE;
+
+	for (i = 0; i < state->errors_count; i++)
+		sensors_parse_error_wfn(state->errors[i].msg, name,
+					state->errors[i].lineno);
+
+	if (state->chips_count)
+		sensors_add_array_els(state->chips, state->chips_count,
+				      &sensors_config_chips,
+				      &sensors_config_chips_count,
+				      &sensors_config_chips_max,
+				      sizeof(sensors_chip));
+	state->chips_count = 0;
+	sensors_config_busses = state->busses;
+	sensors_config_busses_count = state->busses_count;
+	sensors_config_busses_max = state->busses_max;
+	state->busses = NULL;
+	state->busses_count = state->busses_max = 0;
+	free_parse_state(state);
+	if (err)
 		goto exit_cleanup;
-	}
 
+	if (sensors_image_compiling())
+		sensors_image_add_file(input, name, first_chip);
 	err = sensors_substitute_busses();
 
 exit_cleanup:
-	free_config_busses();
+	sensors_free_config_busses();
+	SENSORS_PROBE2(config__end, name, err);
 	return err;
 }
 
+int sensors_parse_config(FILE *input, const char *name)
+{
+	sensors_parse_state state;
+	int err;
+
+	init_parse_state(&state, name);
+	err = parse_file(&state, input);
+	return add_parsed_config(&state, input, err);
+}
+
+/* A configuration file which was loaded by name, the chip statements it
+   added to sensors_config_chips, and what it looked like at the time */
+struct config_source {
+	int file;		/* Index in sensors_config_files */
+	int first_chip;
+	int chip_count;
+	int discovery;		/* Bus substitution done for this discovery */
+	int reused;		/* Index in the previous configuration, or -1 */
+	dev_t dev;
+	ino_t ino;
+	struct timespec mtime;
+	off_t size;
+};
+
+static struct config_source *config_sources;
+static int config_sources_count;
+static int config_sources_max;
+
+/* Incremented by each chip discovery, as it invalidates bus substitution */
+static int discovery_count;
+
+/* Configuration data, which can be set aside while another one loads */
+struct config_state {
+	sensors_chip *chips;
+	int chips_count;
+	int chips_subst;
+	int chips_max;
+	char **files;
+	int files_count;
+	int files_max;
+	struct config_source *sources;
+	int sources_count;
+	int sources_max;
+};
+
+/* The configuration being replaced by sensors_reload_config(), if any */
+static struct config_state *config_prev;
+
+/* Exchange the current configuration with the one in state */
+static void config_swap(struct config_state *state)
+{
+	struct config_state tmp = *state;
+
+	state->chips = sensors_config_chips;
+	state->chips_count = sensors_config_chips_count;
+	state->chips_subst = sensors_config_chips_subst;
+	state->chips_max = sensors_config_chips_max;
+	state->files = sensors_config_files;
+	state->files_count = sensors_config_files_count;
+	state->files_max = sensors_config_files_max;
+	state->sources = config_sources;
+	state->sources_count = config_sources_count;
+	state->sources_max = config_sources_max;
+
+	sensors_config_chips = tmp.chips;
+	sensors_config_chips_count = tmp.chips_count;
+	sensors_config_chips_subst = tmp.chips_subst;
+	sensors_config_chips_max = tmp.chips_max;
+	sensors_config_files = tmp.files;
+	sensors_config_files_count = tmp.files_count;
+	sensors_config_files_max = tmp.files_max;
+	config_sources = tmp.sources;
+	config_sources_count = tmp.sources_count;
+	config_sources_max = tmp.sources_max;
+}
+
+/* Find a file of the previous configuration which is still the same */
+static int find_prev_source(const char *name, const struct stat *st)
+{
+	const struct config_source *src;
+	int i;
+
+	if (!config_prev)
+		return -1;
+
+	for (i = 0; i < config_prev->sources_count; i++) {
+		src = &config_prev->sources[i];
+		if (src->discovery == discovery_count &&
+		    src->dev == st->st_dev && src->ino == st->st_ino &&
+		    src->size == st->st_size &&
+		    src->mtime.tv_sec == st->st_mtim.tv_sec &&
+		    src->mtime.tv_nsec == st->st_mtim.tv_nsec &&
+		    config_prev->files[src->file] &&
+		    !strcmp(config_prev->files[src->file], name))
+			return i;
+	}
+	return -1;
+}
+
+/* Move the chip statements of file i of the previous configuration over
+   to the current one, along with the file name they point to. Bus
+   substitution was already done. */
+static void reuse_source(struct config_source *new, int i)
+{
+	struct config_source *src = &config_prev->sources[i];
+	sensors_chip *chip;
+	int j;
+
+	sensors_add_config_files(&config_prev->files[src->file]);
+	config_prev->files[src->file] = NULL;
+
+	for (j = 0; j < src->chip_count; j++) {
+		chip = &config_prev->chips[src->first_chip + j];
+		sensors_add_array_el(chip, &sensors_config_chips,
+				     &sensors_config_chips_count,
+				     &sensors_config_chips_max,
+				     sizeof(sensors_chip));
+		memset(chip, 0, sizeof(sensors_chip));
+	}
+	sensors_config_chips_subst = sensors_config_chips_count;
+
+	new->reused = i;
+}
+
+/* Give the chip statements which were reused back to the previous
+   configuration, before the current one is dropped */
+static void unreuse_sources(void)
+{
+	struct config_source *new, *src;
+	int i;
+
+	for (i = 0; i < config_sources_count; i++) {
+		new = &config_sources[i];
+		if (new->reused < 0)
+			continue;
+		src = &config_prev->sources[new->reused];
+
+		config_prev->files[src->file] = sensors_config_files[new->file];
+		sensors_config_files[new->file] = NULL;
+		memcpy(&config_prev->chips[src->first_chip],
+		       &sensors_config_chips[new->first_chip],
+		       new->chip_count * sizeof(sensors_chip));
+		memset(&sensors_config_chips[new->first_chip], 0,
+		       new->chip_count * sizeof(sensors_chip));
+	}
+}
+
+/* A configuration file being loaded */
+struct config_file {
+	FILE *input;		/* NULL if it could not be opened */
+	int error;		/* errno if it could not be opened */
+	int stat_ok;
+	struct stat st;
+	int prev;		/* Source to reuse, or -1 if it must be parsed */
+	int res;		/* Result of parse_file() */
+	sensors_parse_state state;
+};
+
+/* Start loading the configuration file name, opened as input. If it
+   didn't change since the configuration being replaced was loaded, its
+   chip statements will be taken over from there instead of parsing it
+   again. */
+static void init_config_file(struct config_file *file, FILE *input,
+			     const char *name)
+{
+	file->input = input;
+	file->error = 0;
+	file->stat_ok = !fstat(fileno(input), &file->st);
+	file->prev = file->stat_ok ? find_prev_source(name, &file->st) : -1;
+	file->res = 0;
+	init_parse_state(&file->state, file->prev < 0 ? name : NULL);
+}
+
+static void parse_config_file(struct config_file *file)
+{
+	if (file->input && file->prev < 0)
+		file->res = parse_file(&file->state, file->input);
+}
+
+/* Add a configuration file to the configuration, once parsed */
+static int add_config_file(struct config_file *file)
+{
+	struct config_source new;
+	int res = 0;
+
+	new.first_chip = sensors_config_chips_count;
+	new.discovery = discovery_count;
+	new.reused = -1;
+
+	if (file->prev >= 0)
+		reuse_source(&new, file->prev);
+	else
+		res = add_parsed_config(&file->state, file->input, file->res);
+
+	if (!file->stat_ok)
+		return res;
+
+	/* The file name is recorded even if parsing failed */
+	new.file = sensors_config_files_count - 1;
+	new.chip_count = sensors_config_chips_count - new.first_chip;
+	new.dev = file->st.st_dev;
+	new.ino = file->st.st_ino;
+	new.mtime = file->st.st_mtim;
+	new.size = file->st.st_size;
+	sensors_add_array_el(&new, &config_sources, &config_sources_count,
+			     &config_sources_max,
+			     sizeof(struct config_source));
+
+	return res;
+}
+
+/* Load the configuration file name, opened as input */
+static int load_config_file(FILE *input, const char *name)
+{
+	struct config_file file;
+
+	init_config_file(&file, input, name);
+	parse_config_file(&file);
+	return add_config_file(&file);
+}
+
+/* Configuration files shared by the threads parsing them */
+struct parse_queue {
+	struct config_file *files;
+	int count;
+	int next;
+	pthread_mutex_t lock;
+};
+
+static void *parse_worker(void *arg)
+{
+	struct parse_queue *queue = arg;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&queue->lock);
+		i = queue->next++;
+		pthread_mutex_unlock(&queue->lock);
+		if (i >= queue->count)
+			break;
+		parse_config_file(&queue->files[i]);
+	}
+
+	return NULL;
+}
+
+/* Parse the files which need it, on up to PARSE_THREADS_MAX threads
+   including the calling one. If no thread could be started, all files
+   are parsed from the calling thread. */
+static void parse_config_files(struct config_file *files, int count)
+{
+	pthread_t threads[PARSE_THREADS_MAX - 1];
+	struct parse_queue queue;
+	long nthreads;
+	int i, started;
+
+	for (nthreads = 0, i = 0; i < count; i++)
+		if (files[i].input && files[i].prev < 0)
+			nthreads++;
+	if (nthreads > sysconf(_SC_NPROCESSORS_ONLN))
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads > PARSE_THREADS_MAX)
+		nthreads = PARSE_THREADS_MAX;
+
+	queue.files = files;
+	queue.count = count;
+	queue.next = 0;
+	pthread_mutex_init(&queue.lock, NULL);
+
+	for (started = 0; started < nthreads - 1; started++)
+		if (pthread_create(&threads[started], NULL, parse_worker,
+				   &queue))
+			break;
+	parse_worker(&queue);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_mutex_destroy(&queue.lock);
+}
+
 static int config_file_filter(const struct dirent *entry)
 {
 	return entry->d_name[0] != '.';		/* Skip hidden files */
 }
 
+/* The files are parsed in parallel, then added to the configuration one
+   after the other in alphabetical order, with the errors of each file
+   reported as it is added, so the result is the same as if they were
+   parsed in that order */
 static int add_config_from_dir(const char *dir)
 {
-	int count, res, i;
+	int count, res, i, n;
 	struct dirent **namelist;
+	struct config_file *files;
 
 	count = scandir(dir, &namelist, config_file_filter, alphasort);
 	if (count < 0) {
@@ -141,7 +494,12 @@ static int add_config_from_dir(const char *dir)
 		return -SENSORS_ERR_PARSE;
 	}
 
-	for (res = 0, i = 0; !res && i < count; i++) {
+	files = calloc(count ? count : 1, sizeof(struct config_file));
+	if (!files)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	/* Loading stops at the first file which can't be opened */
+	for (n = 0, i = 0; i < count; i++) {
 		int len;
 		char path[PATH_MAX];
 		FILE *input;
@@ -150,8 +508,8 @@ static int add_config_from_dir(const char *dir)
 		len = snprintf(path, sizeof(path), "%s/%s", dir,
 			       namelist[i]->d_name);
 		if (len < 0 || len >= (int)sizeof(path)) {
-			res = -SENSORS_ERR_PARSE;
-			continue;
+			n++;
+			break;
 		}
 
 		/* Only accept regular files */
@@ -160,13 +518,31 @@ static int add_config_from_dir(const char *dir)
 
 		input = fopen(path, "r");
 		if (input) {
-			res = parse_config(input, path);
-			fclose(input);
+			init_config_file(&files[n++], input, path);
 		} else {
+			files[n].error = errno;
+			init_parse_state(&files[n++].state, path);
+			break;
+		}
+	}
+
+	parse_config_files(files, n);
+
+	for (res = 0, i = 0; i < n; i++) {
+		if (!res && files[i].input) {
+			res = add_config_file(&files[i]);
+		} else if (!res) {
 			res = -SENSORS_ERR_PARSE;
-			sensors_parse_error_wfn(strerror(errno), path, 0);
+			if (files[i].error)
+				sensors_parse_error_wfn(strerror(files[i].error),
+							files[i].state.filename,
+							0);
 		}
+		free_parse_state(&files[i].state);
+		if (files[i].input)
+			fclose(files[i].input);
 	}
+	free(files);
 
 	/* Free memory allocated by scandir() */
 	for (i = 0; i < count; i++)
@@ -176,22 +552,119 @@ static int add_config_from_dir(const char *dir)
 	return res;
 }
 
-/* Ideally, initialization and configuraton file loading should be exposed
-   separately, to make it possible to load several configuration files. */
-int sensors_init(FILE *input)
+const sensors_backend *sensors_current_backend = &sensors_sysfs_backend;
+static const sensors_backend *sensors_selected_backend = &sensors_sysfs_backend;
+static char *sensors_backend_source;
+static int sensors_backend_chosen;
+
+static int select_backend(int backend, const char *source)
+{
+	const sensors_backend *b;
+	char *s = NULL;
+
+	switch (backend) {
+	case SENSORS_BACKEND_SYSFS:
+		b = &sensors_sysfs_backend;
+		break;
+	case SENSORS_BACKEND_DIR:
+		b = &sensors_dir_backend;
+		break;
+	case SENSORS_BACKEND_MEMORY:
+		b = &sensors_memory_backend;
+		break;
+	case SENSORS_BACKEND_REPLAY:
+		b = &sensors_replay_backend;
+		break;
+	default:
+		return -SENSORS_ERR_NO_ENTRY;
+	}
+
+	if (b != &sensors_sysfs_backend) {
+		if (!source)
+			return -SENSORS_ERR_NO_ENTRY;
+		if (!(s = strdup(source)))
+			sensors_fatal_error(__func__, "Out of memory");
+	}
+
+	free(sensors_backend_source);
+	sensors_backend_source = s;
+	sensors_selected_backend = b;
+
+	return 0;
+}
+
+int sensors_set_backend(int backend, const char *source)
 {
 	int res;
 
-	if (!sensors_init_sysfs())
-		return -SENSORS_ERR_KERNEL;
-	if ((res = sensors_read_sysfs_bus()) ||
-	    (res = sensors_read_sysfs_chips()))
-		goto exit_cleanup;
+	if (!(res = select_backend(backend, source)))
+		sensors_backend_chosen = 1;
+	return res;
+}
+
+int sensors_set_backend_default(int backend, const char *source)
+{
+	if (sensors_backend_chosen)
+		return 0;
+	return select_backend(backend, source);
+}
+
+static void free_proc_chips(void);
+static void free_config(void);
+
+static int environment_read;
+
+int sensors_discover(void)
+{
+	long long start;
+	int res;
+
+	free_proc_chips();
+	discovery_count++;
+
+	/* The environment is only read once, so that it doesn't undo what
+	   the application changed since */
+	if (!environment_read) {
+		sensors_trace_getenv();
+		sensors_boards_getenv();
+		sensors_energy_getenv();
+		environment_read = 1;
+	}
+	sensors_current_backend = sensors_trace_backend(sensors_selected_backend);
+	start = sensors_stats_now();
+	res = sensors_current_backend->discover(sensors_backend_source);
+	__atomic_store_n(&sensors_stats_total.discovery_ns,
+			 sensors_stats_now() - start, __ATOMIC_RELAXED);
+	if (res) {
+		free_proc_chips();
+	} else {
+		sensors_virtual_update();
+		sensors_energy_start();
+	}
+
+	return res;
+}
+
+static int load_config(FILE *input)
+{
+	long long start;
+	int res;
 
+	start = sensors_stats_now();
+
+	/* The configuration of the board comes after the main configuration
+	   file, so that it overrides its generic chip statements, and before
+	   the sensors.d directory, so that local changes override it */
 	if (input) {
-		res = parse_config(input, NULL);
+		res = sensors_parse_config(input, NULL);
+		if (res)
+			return res;
+	} else if (!sensors_image_compiling() &&
+		   (res = sensors_image_load(DEFAULT_CONFIG_IMAGE,
+					     sensors_boards_load)) <= 0) {
+		/* Loaded from the compiled image, which is up to date */
 		if (res)
-			goto exit_cleanup;
+			return res;
 	} else {
 		const char* name;
 
@@ -200,27 +673,139 @@ int sensors_init(FILE *input)
 		if (!input && errno == ENOENT)
 			input = fopen(name = ALT_CONFIG_FILE, "r");
 		if (input) {
-			res = parse_config(input, name);
+			res = load_config_file(input, name);
 			fclose(input);
 			if (res)
-				goto exit_cleanup;
+				return res;
 
 		} else if (errno != ENOENT) {
 			sensors_parse_error_wfn(strerror(errno), name, 0);
-			res = -SENSORS_ERR_PARSE;
-			goto exit_cleanup;
+			return -SENSORS_ERR_PARSE;
+		}
+
+		if (sensors_image_compiling())
+			sensors_image_end_main();
+		else {
+			res = sensors_boards_load();
+			if (res)
+				return res;
 		}
 
 		/* Also check for files in default directory */
 		res = add_config_from_dir(DEFAULT_CONFIG_DIR);
 		if (res)
-			goto exit_cleanup;
+			return res;
 	}
+	__atomic_store_n(&sensors_stats_total.config_ns,
+			 sensors_stats_now() - start, __ATOMIC_RELAXED);
 
 	return 0;
+}
+
+int sensors_load_config(FILE *input)
+{
+	int res;
+
+	res = load_config(input);
+	if (!res)
+		sensors_virtual_update();
+	return res;
+}
+
+int sensors_reload_config(FILE *input)
+{
+	struct config_state old;
+	int i, j, res;
+
+	/* Load the new configuration while the old one is set aside.
+	   Files which didn't change are not parsed again. */
+	memset(&old, 0, sizeof(old));
+	config_swap(&old);
+	config_prev = &old;
+	res = load_config(input);
+
+	if (res) {
+		/* Drop what was loaded, and keep the old configuration */
+		unreuse_sources();
+		config_prev = NULL;
+		free_config();
+		config_swap(&old);
+		return res;
+	}
+	config_prev = NULL;
+
+	/* Drop the old configuration */
+	config_swap(&old);
+	free_config();
+	config_swap(&old);
+
+	/* Cached values were computed with the old compute statements */
+	for (i = 0; i < sensors_proc_chips_count; i++)
+		for (j = 0; j < sensors_proc_chips[i].subfeature_count; j++)
+			sensors_proc_chips[i].state[j].cached = 0;
+
+	sensors_virtual_update();
+	for (i = 0; i < sensors_virtual_chips_count; i++)
+		for (j = 0; j < sensors_virtual_chips[i].subfeature_count; j++)
+			sensors_virtual_chips[i].state[j].cached = 0;
+
+	return 0;
+}
+
+int sensors_compile_config(const char *filename)
+{
+	struct config_state old;
+	int res;
+
+	/* Parse the default configuration files on their own */
+	memset(&old, 0, sizeof(old));
+	config_swap(&old);
+	sensors_image_begin();
+	res = load_config(NULL);
+	res = sensors_image_end(res ? NULL : filename ? filename :
+				DEFAULT_CONFIG_IMAGE);
+	free_config();
+	config_swap(&old);
+
+	return res;
+}
+
+int sensors_compile_boards(const char *dir, const char *filename)
+{
+	struct config_state old;
+	int res;
+
+	memset(&old, 0, sizeof(old));
+	config_swap(&old);
+	sensors_image_begin();
+	res = sensors_boards_compile(dir, filename ? filename :
+				     DEFAULT_BOARD_DATABASE);
+	sensors_image_end(NULL);
+	free_config();
+	config_swap(&old);
+
+	return res;
+}
+
+int sensors_init(FILE *input)
+{
+	int res;
+
+	SENSORS_PROBE(init__start);
+	res = sensors_discover();
+	if (res)
+		goto exit_cleanup;
+
+	res = sensors_load_config(input);
+	if (res)
+		goto exit_cleanup;
+
+	SENSORS_PROBE1(init__end, 0);
+	return 0;
 
 exit_cleanup:
 	sensors_cleanup();
+	SENSORS_PROBE1(init__end, res);
 	return res;
 }
 
@@ -234,9 +819,13 @@ static void free_chip_features(sensors_chip_features *features)
 {
 	int i;
 
-	for (i = 0; i < features->subfeature_count; i++)
+	sensors_energy_free(features);
+	for (i = 0; i < features->subfeature_count; i++) {
 		free(features->subfeature[i].name);
+		sensors_close_sysfs_attr(&features->state[i]);
+	}
 	free(features->subfeature);
+	free(features->state);
 	for (i = 0; i < features->feature_count; i++)
 		free(features->feature[i].name);
 	free(features->feature);
@@ -279,6 +868,12 @@ static void free_ignore(sensors_ignore *ignore)
 	free(ignore->name);
 }
 
+static void free_define(sensors_define *define)
+{
+	free(define->name);
+	sensors_free_expr(define->value);
+}
+
 static void free_chip(sensors_chip *chip)
 {
 	int i;
@@ -307,12 +902,19 @@ static void free_chip(sensors_chip *chip)
 		free_ignore(&chip->ignores[i]);
 	free(chip->ignores);
 	chip->ignores_count = chip->ignores_max = 0;
+
+	for (i = 0; i < chip->defines_count; i++)
+		free_define(&chip->defines[i]);
+	free(chip->defines);
+	chip->defines_count = chip->defines_max = 0;
 }
 
-void sensors_cleanup(void)
+static void free_proc_chips(void)
 {
 	int i;
 
+	sensors_energy_stop();
+	sensors_virtual_free();
 	for (i = 0; i < sensors_proc_chips_count; i++) {
 		free_chip_name(&sensors_proc_chips[i].chip);
 		free_chip_features(&sensors_proc_chips[i]);
@@ -320,6 +922,34 @@ void sensors_cleanup(void)
 	free(sensors_proc_chips);
 	sensors_proc_chips = NULL;
 	sensors_proc_chips_count = sensors_proc_chips_max = 0;
+	if (sensors_current_backend->cleanup)
+		sensors_current_backend->cleanup();
+
+	for (i = 0; i < sensors_proc_bus_count; i++)
+		free_bus(&sensors_proc_bus[i]);
+	free(sensors_proc_bus);
+	sensors_proc_bus = NULL;
+	sensors_proc_bus_count = sensors_proc_bus_max = 0;
+}
+
+void sensors_free_config_from(int chips_count, int files_count)
+{
+	int i;
+
+	for (i = chips_count; i < sensors_config_chips_count; i++)
+		free_chip(&sensors_config_chips[i]);
+	sensors_config_chips_count = chips_count;
+	if (sensors_config_chips_subst > chips_count)
+		sensors_config_chips_subst = chips_count;
+
+	for (i = files_count; i < sensors_config_files_count; i++)
+		free(sensors_config_files[i]);
+	sensors_config_files_count = files_count;
+}
+
+static void free_config(void)
+{
+	int i;
 
 	for (i = 0; i < sensors_config_chips_count; i++)
 		free_chip(&sensors_config_chips[i]);
@@ -328,15 +958,19 @@ void sensors_cleanup(void)
 	sensors_config_chips_count = sensors_config_chips_max = 0;
 	sensors_config_chips_subst = 0;
 
-	for (i = 0; i < sensors_proc_bus_count; i++)
-		free_bus(&sensors_proc_bus[i]);
-	free(sensors_proc_bus);
-	sensors_proc_bus = NULL;
-	sensors_proc_bus_count = sensors_proc_bus_max = 0;
-
 	for (i = 0; i < sensors_config_files_count; i++)
 		free(sensors_config_files[i]);
 	free(sensors_config_files);
 	sensors_config_files = NULL;
 	sensors_config_files_count = sensors_config_files_max = 0;
+
+	free(config_sources);
+	config_sources = NULL;
+	config_sources_count = config_sources_max = 0;
+}
+
+void sensors_cleanup(void)
+{
+	free_proc_chips();
+	free_config();
 }
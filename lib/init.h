@@ -23,6 +23,23 @@
 
 #include "data.h"
 
+#define DEFAULT_CONFIG_FILE	ETCDIR "/sensors3.conf"
+#define ALT_CONFIG_FILE		ETCDIR "/sensors.conf"
+#define DEFAULT_CONFIG_DIR	ETCDIR "/sensors.d"
+#define DEFAULT_CONFIG_IMAGE	ETCDIR "/sensors3.conf.bin"
+#define DEFAULT_BOARD_DATABASE	DATADIR "/lm-sensors/boards.bin"
+
 void sensors_free_expr(sensors_expr *expr);
 
+/* Parse the configuration file name, opened as input, and substitute its
+   bus statements */
+int sensors_parse_config(FILE *input, const char *name);
+
+/* Free the bus statements of the configuration file being loaded */
+void sensors_free_config_busses(void);
+
+/* Free the chip statements and configuration file names past the given
+   counts, to undo a partial load */
+void sensors_free_config_from(int chips_count, int files_count);
+
 #endif /* def LIB_SENSORS_INIT_H */
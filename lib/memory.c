@@ -0,0 +1,382 @@
+/*
+    memory.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* this define needed for getline() */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <ctype.h>
+#include <errno.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "access.h"
+#include "sysfs.h"
+#include "backend.h"
+#include "stats.h"
+
+/*
+ * The memory backend holds all chips and attributes in memory, as read
+ * from a description file at discovery time:
+ *
+ *   # comment
+ *   bus i2c-0 SMBus I801 adapter at 0400
+ *   chip lm75-i2c-0-48 [path]
+ *   temp1_input 42000
+ *   temp1_max 80000 rw
+ *   temp1_label Ambient
+ *
+ * Attribute lines belong to the last chip line above them. Numeric values
+ * are raw sysfs values, optionally followed by ro (the default), rw or wo.
+ * Anything else, and all _label attributes, is text. The chip path
+ * defaults to the chip name.
+ */
+
+struct memory_attr {
+	char *path;		/* chip path, slash, attribute name */
+	const char *name;	/* attribute name, points into path */
+	char *text;		/* NULL for numeric attributes */
+	long long value;
+	int mode;
+};
+
+static struct memory_attr *memory_attrs;
+static int memory_attrs_count, memory_attrs_max;
+
+struct memory_attr_range {
+	int next, end;
+};
+
+static const char *memory_next_attr(void *data)
+{
+	struct memory_attr_range *r = data;
+
+	if (r->next >= r->end)
+		return NULL;
+	return memory_attrs[r->next++].name;
+}
+
+/* name is always the attribute memory_next_attr() just returned */
+static int memory_attr_mode(void *data, const char *name)
+{
+	struct memory_attr_range *r = data;
+	(void)name; /* hide warning */
+
+	return memory_attrs[r->next - 1].mode;
+}
+
+/* Register a chip with the attributes found since index first, the chip
+   line having been parsed at time start. Chips without any known
+   attribute are discarded, as with sysfs. */
+static void memory_add_chip(sensors_chip_features *entry, int first,
+			    long long start)
+{
+	struct memory_attr_range r = { first, memory_attrs_count };
+	sensors_attr_list attrs = { memory_next_attr, memory_attr_mode, &r,
+				    1 };
+
+	sensors_build_chip_features(entry, &attrs);
+	if (!entry->subfeature) {
+		free(entry->chip.prefix);
+		free(entry->chip.path);
+		return;
+	}
+	entry->timeout_ms = 0;
+	memset(&entry->breaker, 0, sizeof(entry->breaker));
+	memset(&entry->stats, 0, sizeof(entry->stats));
+	entry->stats.discovery_ns = sensors_stats_now() - start;
+	sensors_add_proc_chips(entry);
+}
+
+static int memory_parse_attr(const char *chip_path, const char *name,
+			     char *rest)
+{
+	struct memory_attr attr;
+	size_t len;
+	char *end;
+
+	attr.text = NULL;
+	attr.value = 0;
+	attr.mode = SENSORS_MODE_R;
+
+	len = strlen(name);
+	if (len < 6 || strcmp(name + len - 6, "_label"))
+		attr.value = strtoll(rest, &end, 10);
+	else
+		end = rest;
+
+	if (end == rest) {
+		/* Text attribute */
+		attr.text = strdup(rest);
+		if (!attr.text)
+			sensors_fatal_error(__func__, "Out of memory");
+	} else {
+		while (isspace((unsigned char)*end))
+			end++;
+		if (!strcmp(end, "rw"))
+			attr.mode = SENSORS_MODE_R | SENSORS_MODE_W;
+		else if (!strcmp(end, "wo"))
+			attr.mode = SENSORS_MODE_W;
+		else if (*end && strcmp(end, "ro"))
+			return -SENSORS_ERR_PARSE;
+	}
+
+	len = strlen(chip_path) + 1 + strlen(name) + 1;
+	attr.path = malloc(len);
+	if (!attr.path)
+		sensors_fatal_error(__func__, "Out of memory");
+	snprintf(attr.path, len, "%s/%s", chip_path, name);
+	attr.name = attr.path + strlen(chip_path) + 1;
+
+	sensors_add_array_el(&attr, &memory_attrs, &memory_attrs_count,
+			     &memory_attrs_max, sizeof(struct memory_attr));
+	return 0;
+}
+
+static int memory_parse_chip(sensors_chip_features *entry, const char *name,
+			     const char *path)
+{
+	memset(entry, 0, sizeof(*entry));
+	if (sensors_parse_chip_name(name, &entry->chip))
+		return -SENSORS_ERR_CHIP_NAME;
+	/* Bus types without a number, such as ISA, are on bus 0 */
+	switch (entry->chip.bus.type) {
+	case SENSORS_BUS_TYPE_I2C:
+	case SENSORS_BUS_TYPE_SPI:
+	case SENSORS_BUS_TYPE_HID:
+	case SENSORS_BUS_TYPE_SCSI:
+		break;
+	default:
+		if (entry->chip.bus.nr == SENSORS_BUS_NR_ANY)
+			entry->chip.bus.nr = 0;
+	}
+	if (sensors_chip_name_has_wildcards(&entry->chip)) {
+		if (entry->chip.prefix != SENSORS_CHIP_NAME_PREFIX_ANY)
+			free(entry->chip.prefix);
+		return -SENSORS_ERR_CHIP_NAME;
+	}
+
+	entry->chip.path = strdup(*path ? path : name);
+	if (!entry->chip.path)
+		sensors_fatal_error(__func__, "Out of memory");
+	return 0;
+}
+
+static int memory_parse_bus(const char *name, const char *adapter)
+{
+	sensors_bus entry;
+
+	memset(&entry, 0, sizeof(entry));
+	if (sensors_parse_bus_id(name, &entry.bus) || !*adapter)
+		return -SENSORS_ERR_BUS_NAME;
+	entry.adapter = strdup(adapter);
+	if (!entry.adapter)
+		sensors_fatal_error(__func__, "Out of memory");
+	sensors_add_proc_bus(&entry);
+	return 0;
+}
+
+/* Terminate the first word of s and return what follows it, without
+   leading blanks */
+static char *memory_split(char *s)
+{
+	while (*s && !isspace((unsigned char)*s))
+		s++;
+	if (*s)
+		*s++ = '\0';
+	while (isspace((unsigned char)*s))
+		s++;
+	return s;
+}
+
+static int memory_attr_cmp(const void *a, const void *b)
+{
+	return strcmp(((const struct memory_attr *)a)->path,
+		      ((const struct memory_attr *)b)->path);
+}
+
+static int memory_path_cmp(const void *key, const void *attr)
+{
+	return strcmp(key, ((const struct memory_attr *)attr)->path);
+}
+
+static struct memory_attr *memory_find(const char *path)
+{
+	return bsearch(path, memory_attrs, memory_attrs_count,
+		       sizeof(struct memory_attr), memory_path_cmp);
+}
+
+static int memory_discover(const char *filename)
+{
+	sensors_chip_features entry;
+	int have_chip = 0, first = 0, lineno = 0, i, res = 0;
+	char *line = NULL, *key, *rest, *end;
+	long long start = 0;
+	size_t size = 0;
+	FILE *f;
+
+	if (!(f = fopen(filename, "r"))) {
+		sensors_parse_error_wfn(strerror(errno), filename, 0);
+		return -SENSORS_ERR_PARSE;
+	}
+
+	while (!res && getline(&line, &size, f) >= 0) {
+		lineno++;
+
+		/* Split the line into a keyword and the rest, dropping
+		   comments and surrounding blanks */
+		if ((end = strchr(line, '#')))
+			*end = '\0';
+		end = line + strlen(line);
+		while (end > line && isspace((unsigned char)end[-1]))
+			*--end = '\0';
+		for (key = line; isspace((unsigned char)*key); key++)
+			;
+		if (!*key)
+			continue;
+		rest = memory_split(key);
+
+		if (!strcmp(key, "bus")) {
+			end = memory_split(rest);
+			res = memory_parse_bus(rest, end);
+			if (res)
+				sensors_parse_error_wfn("Invalid bus line",
+							filename, lineno);
+		} else if (!strcmp(key, "chip")) {
+			if (have_chip)
+				memory_add_chip(&entry, first, start);
+			have_chip = 0;
+			end = memory_split(rest);
+			res = memory_parse_chip(&entry, rest, end);
+			if (res)
+				sensors_parse_error_wfn("Invalid chip name",
+							filename, lineno);
+			have_chip = !res;
+			first = memory_attrs_count;
+			start = sensors_stats_now();
+		} else if (!have_chip) {
+			sensors_parse_error_wfn("Attribute outside of a chip",
+						filename, lineno);
+			res = -SENSORS_ERR_PARSE;
+		} else {
+			res = memory_parse_attr(entry.chip.path, key, rest);
+			if (res)
+				sensors_parse_error_wfn("Invalid attribute value",
+							filename, lineno);
+		}
+	}
+	free(line);
+	fclose(f);
+
+	if (have_chip) {
+		if (res) {
+			free(entry.chip.prefix);
+			free(entry.chip.path);
+		} else
+			memory_add_chip(&entry, first, start);
+	}
+	if (res)
+		return res;
+
+	/* Sort attributes by path for lookups */
+	qsort(memory_attrs, memory_attrs_count, sizeof(struct memory_attr),
+	      memory_attr_cmp);
+	for (i = 1; i < memory_attrs_count; i++)
+		if (!strcmp(memory_attrs[i - 1].path, memory_attrs[i].path)) {
+			sensors_parse_error_wfn("Duplicate attribute",
+						filename, 0);
+			return -SENSORS_ERR_PARSE;
+		}
+
+	return 0;
+}
+
+static int memory_read(const char *path, long long *value)
+{
+	const struct memory_attr *attr;
+
+	if (!(attr = memory_find(path)))
+		return -SENSORS_ERR_KERNEL;
+	if (attr->text || !(attr->mode & SENSORS_MODE_R))
+		return -SENSORS_ERR_ACCESS_R;
+
+	/* Written by memory_write() while batch workers read */
+	*value = __atomic_load_n(&attr->value, __ATOMIC_RELAXED);
+	return 0;
+}
+
+static int memory_write(const char *dir, const char *attr_name,
+			sensors_subfeature_state *state, long value)
+{
+	struct memory_attr *attr;
+	char n[NAME_MAX];
+	(void)state; /* hide warning */
+
+	snprintf(n, NAME_MAX, "%s/%s", dir, attr_name);
+	if (!(attr = memory_find(n)))
+		return -SENSORS_ERR_KERNEL;
+	if (attr->text || !(attr->mode & SENSORS_MODE_W))
+		return -SENSORS_ERR_ACCESS_W;
+
+	__atomic_store_n(&attr->value, value, __ATOMIC_RELAXED);
+	return 0;
+}
+
+static char *memory_read_text(const char *dir, const char *attr_name)
+{
+	const struct memory_attr *attr;
+	char n[NAME_MAX], *text;
+
+	snprintf(n, NAME_MAX, "%s/%s", dir, attr_name);
+	if (!(attr = memory_find(n)) || !attr->text)
+		return NULL;
+
+	text = strdup(attr->text);
+	if (!text)
+		sensors_fatal_error(__func__, "Out of memory");
+	return text;
+}
+
+static void memory_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < memory_attrs_count; i++) {
+		free(memory_attrs[i].path);
+		free(memory_attrs[i].text);
+	}
+	free(memory_attrs);
+	memory_attrs = NULL;
+	memory_attrs_count = memory_attrs_max = 0;
+}
+
+const sensors_backend sensors_memory_backend = {
+	memory_discover,
+	memory_read,
+	NULL,
+	memory_write,
+	memory_read_text,
+	memory_cleanup,
+	0,
+};
@@ -0,0 +1,49 @@
+/*
+    probes.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_PROBES_H
+#define LIB_SENSORS_PROBES_H
+
+/*
+ * Static tracepoints (USDT probes) of provider "libsensors", built in
+ * with "make USE_SDT=1", the default when <sys/sdt.h> is found. Each
+ * probe is a single nop until a tracer such as bpftrace or perf attaches
+ * to it; with USE_SDT=0, they are not compiled at all. See
+ * prog/debug/README for the list of probes and their arguments.
+ */
+#ifdef HAVE_SDT
+#include <sys/sdt.h>
+
+#define SENSORS_PROBE(name) \
+	STAP_PROBE(libsensors, name)
+#define SENSORS_PROBE1(name, a) \
+	STAP_PROBE1(libsensors, name, a)
+#define SENSORS_PROBE2(name, a, b) \
+	STAP_PROBE2(libsensors, name, a, b)
+#define SENSORS_PROBE3(name, a, b, c) \
+	STAP_PROBE3(libsensors, name, a, b, c)
+#else
+#define SENSORS_PROBE(name)			do { } while (0)
+#define SENSORS_PROBE1(name, a)			do { } while (0)
+#define SENSORS_PROBE2(name, a, b)		do { } while (0)
+#define SENSORS_PROBE3(name, a, b, c)		do { } while (0)
+#endif
+
+#endif /* def LIB_SENSORS_PROBES_H */
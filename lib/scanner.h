@@ -21,8 +21,11 @@
 #ifndef LIB_SENSORS_SCANNER_H
 #define LIB_SENSORS_SCANNER_H
 
-int sensors_scanner_init(FILE *input, const char *filename);
-void sensors_scanner_exit(void);
+/* Create a scanner reading input into state. Returns 0 if successful,
+   !0 otherwise. */
+int sensors_scanner_init(sensors_parse_state *state, FILE *input,
+			 void **scanner);
+void sensors_scanner_exit(sensors_parse_state *state, void *scanner);
 
 #endif /* def LIB_SENSORS_SCANNER_H */
 
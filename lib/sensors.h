@@ -31,7 +31,7 @@
    when the API or ABI breaks), the third digit is incremented to track small
    API additions like new flags / enum values. The second digit is for tracking
    larger additions like new methods. */
-#define SENSORS_API_VERSION		0x500
+#define SENSORS_API_VERSION		0x510
 
 #define SENSORS_CHIP_NAME_PREFIX_ANY	NULL
 #define SENSORS_CHIP_NAME_ADDR_ANY	(-1)
@@ -71,14 +71,105 @@ typedef struct sensors_chip_name {
 /* Load the configuration file and the detected chips list. If this
    returns a value unequal to zero, you are in trouble; you can not
    assume anything will be initialized properly. If you want to
-   reload the configuration file, call sensors_cleanup() below before
-   calling sensors_init() again. */
+   reload the configuration file, call sensors_reload_config() below, or
+   sensors_cleanup() before calling sensors_init() again. This is the
+   same as sensors_discover() followed by sensors_load_config(). */
 int sensors_init(FILE *input);
 
+/* Build the detected chips list, without loading any configuration. If
+   chips were already detected, they are detected again, and all chip
+   names previously returned become invalid. Bus statements are resolved
+   when configuration files are loaded, so call sensors_reload_config()
+   afterwards if they are used. Returns 0 on success, and <0 on failure,
+   in which case no chip is left. */
+int sensors_discover(void);
+
+/* Load a configuration file on top of the configuration already loaded,
+   binding it to the chips detected by sensors_discover(). If input is
+   NULL, the default configuration files are loaded. Returns 0 on success,
+   and <0 on failure, in which case the configuration may have been
+   partially loaded. */
+int sensors_load_config(FILE *input);
+
+/* Replace the whole configuration with the one loaded from input, or
+   from the default configuration files if input is NULL, without
+   detecting chips again, so chip names stay valid. Files which didn't
+   change since they were loaded, according to their inode, modification
+   time and size, are not parsed again, and their errors are not reported
+   again. If the new configuration fails to load, the previous one is
+   kept. Returns 0 on success, and <0 on failure. */
+int sensors_reload_config(FILE *input);
+
+/* Compile the default configuration files into a binary image, written
+   to filename, or to the default location if filename is NULL. When
+   the default configuration files are loaded, the image at the default
+   location is used instead of parsing them, as long as none of them
+   changed since it was compiled. The configuration currently loaded is
+   left untouched. Returns 0 on success, and <0 on failure. */
+int sensors_compile_config(const char *filename);
+
+/* Load the configuration of the board the system runs on along with the
+   default configuration files, from the board database filename, or from
+   the default one if filename is NULL. The board is identified by its DMI
+   vendor and board or product name. Its configuration is loaded after
+   the main configuration file, so that it overrides its generic chip
+   statements, and before the files in sensors.d. Pass enable 0 to
+   stop. This takes effect from the next time the default configuration
+   files are loaded. The environment variable SENSORS_BOARD_CONFIG does
+   the same for programs which don't call this function: "1" enables the
+   default database, "0" disables it, and anything else is the database
+   to use. */
+void sensors_set_board_config(int enable, const char *filename);
+
+/* Compile all the configuration files under directory dir, typically
+   the configs directory of lm-sensors, into a board database written to
+   filename, or to the default location if filename is NULL. Files in a
+   subdirectory of dir are for boards of the vendor it is named after,
+   and the board name is the file name, or is given by "# dmi:" comments
+   in the file. The configuration currently loaded is left untouched.
+   Returns 0 on success, and <0 on failure. */
+int sensors_compile_boards(const char *dir, const char *filename);
+
 /* Clean-up function: You can't access anything after
    this, until the next sensors_init() call! */
 void sensors_cleanup(void);
 
+/* Backends, which is where sensors_init() finds chips and where their
+   attributes are read and written. The default is the live sysfs mounted
+   on /sys. SENSORS_BACKEND_DIR reads a directory tree laid out like sysfs,
+   rooted at source, for example a copy of /sys taken on another system.
+   SENSORS_BACKEND_MEMORY keeps everything in memory, as described by the
+   text file source; see libsensors(3) for its format.
+   SENSORS_BACKEND_REPLAY serves chips and values from a trace file
+   recorded with sensors_set_trace(). */
+#define SENSORS_BACKEND_SYSFS		0
+#define SENSORS_BACKEND_DIR		1
+#define SENSORS_BACKEND_MEMORY		2
+#define SENSORS_BACKEND_REPLAY		3
+
+/* Select the backend used from the next call to sensors_init() on. Call
+   this before sensors_init(), or after sensors_cleanup(). source is
+   ignored for SENSORS_BACKEND_SYSFS. Returns 0 on success,
+   -SENSORS_ERR_NO_ENTRY if backend is unknown or source is missing. */
+int sensors_set_backend(int backend, const char *source);
+
+/* Record the chips found and all raw attribute reads and writes, with
+   their timing, to a binary trace file, from the next call to
+   sensors_init() on. Pass NULL to stop recording. The environment
+   variable SENSORS_TRACE_RECORD does the same for programs which don't
+   call this function. */
+void sensors_set_trace(const char *filename);
+
+/* Set how fast SENSORS_BACKEND_REPLAY replays a trace. At speed 0, the
+   default, the reads of each attribute are served in the recorded order,
+   and the last one is repeated once the trace is exhausted. At speed s > 0,
+   a read returns the value which was last read at time t * s of the trace,
+   t being the time since sensors_init(), so 1 is the recorded speed. The
+   environment variables SENSORS_TRACE_REPLAY and SENSORS_TRACE_SPEED
+   select replay and its speed for programs which don't call these
+   functions. */
+void sensors_set_replay_speed(double speed);
+
 /* Parse a chip name to the internal representation. Return 0 on success, <0
    on error. */
 int sensors_parse_chip_name(const char *orig_name, sensors_chip_name *res);
@@ -112,12 +203,328 @@ char *sensors_get_label(const sensors_chip_name *name,
 int sensors_get_value(const sensors_chip_name *name, int subfeat_nr,
 		      double *value);
 
+/* Apply the compute statement of a subfeature of a certain chip to count
+   values, as if each had just been read from the chip, and store the
+   results in out, which may be the same array as in. This is meant for
+   values which were read or recorded before: the compute statement is
+   looked up once and evaluated for many values at once, and the other
+   subfeatures it refers to are read once for a group of values rather
+   than once per value. Note that chip should not
+   contain wildcard values! This function will return 0 on success, and <0
+   on failure. */
+int sensors_compute_values(const sensors_chip_name *name, int subfeat_nr,
+			   const double *in, double *out, int count);
+
 /* Set the value of a subfeature of a certain chip. Note that chip should not
    contain wildcard values! This function will return 0 on success, and <0
    on failure. */
 int sensors_set_value(const sensors_chip_name *name, int subfeat_nr,
 		      double value);
 
+/* Flags for sensors_set_value_flags() and sensors_set_values() */
+#define SENSORS_SET_FORCE		1 /* Write even if value didn't change */
+
+/* Same as sensors_set_value(), except that the attribute file is not
+   written to if the value to be written is the same as the one which was
+   last written, unless flags contains SENSORS_SET_FORCE. The attribute
+   file is kept open between calls, so this is well suited to control
+   loops. This function will return 0 on success, and <0 on failure. */
+int sensors_set_value_flags(const sensors_chip_name *name, int subfeat_nr,
+			    double value, unsigned int flags);
+
+/* A single value to be written by sensors_set_values() */
+typedef struct sensors_set_request {
+	int subfeat_nr;
+	double value;
+} sensors_set_request;
+
+/* Write count values to subfeatures of a single chip in one pass, with
+   the same semantics as sensors_set_value_flags(). Note that chip should
+   not contain wildcard values! All values are tried even if some fail.
+   This function will return 0 on success, and the last error (<0) if at
+   least one value could not be written. */
+int sensors_set_values(const sensors_chip_name *name,
+		       const sensors_set_request *req, int count,
+		       unsigned int flags);
+
+/* A single value to be read by sensors_get_values() */
+typedef struct sensors_value_request {
+	const sensors_chip_name *name;
+	int subfeat_nr;
+	int err;		/* Set on return: 0 on success, <0 on failure */
+	double value;		/* Set on return if err is 0 */
+} sensors_value_request;
+
+/* Read count values, possibly from different chips, at once. Chips which
+   sit on different I2C, SPI, HID or SCSI buses are read in parallel, while
+   chips on the same bus are read one after the other. All other chips are
+   read in parallel. Note that chip names should not contain wildcard
+   values! This function will return 0 if all values could be read, and
+   the last error (<0) otherwise. */
+int sensors_get_values(sensors_value_request *req, int count);
+
+/* Read the value of a subfeature of a certain chip, giving up after
+   timeout_ms milliseconds. If timeout_ms is 0, the chip's own deadline
+   (see sensors_set_chip_timeout()) is used, and if the chip has none,
+   this is the same as sensors_get_value(). When the deadline expires,
+   -SENSORS_ERR_TIMEOUT is returned and the pending read is left to
+   complete in the background; its result is discarded. While such a
+   read is pending, further reads from the same chip with a deadline fail
+   immediately with -SENSORS_ERR_TIMEOUT. So do all reads with a deadline
+   if no thread can be created to run them. */
+int sensors_get_value_timeout(const sensors_chip_name *name, int subfeat_nr,
+			      int timeout_ms, double *value);
+
+/* Same as sensors_get_values(), but all values which could not be read
+   within timeout_ms milliseconds, or within the deadline of their chip,
+   fail with -SENSORS_ERR_TIMEOUT. The values which could be read are
+   returned as usual. */
+int sensors_get_values_timeout(sensors_value_request *req, int count,
+			       int timeout_ms);
+
+/* Set the read deadline of all detected chips matching name, in
+   milliseconds. It applies to all reads from these chips, including
+   sensors_get_value() and sensors_get_values(). Use 0 to remove the
+   deadline. Returns 0 on success, -SENSORS_ERR_NO_ENTRY if no chip
+   matched. */
+int sensors_set_chip_timeout(const sensors_chip_name *name, int timeout_ms);
+
+/* Time at which a value was read, in nanoseconds of CLOCK_MONOTONIC_RAW.
+   start is taken right before the attribute is read, end right after. */
+typedef struct sensors_timestamp {
+	long long start;
+	long long end;
+} sensors_timestamp;
+
+/* Same as sensors_get_value(), but also report when the value was read.
+   ts is left zeroed on failure. */
+int sensors_get_value_ts(const sensors_chip_name *name, int subfeat_nr,
+			 double *value, sensors_timestamp *ts);
+
+/* Same as sensors_get_values(), but also report when each value was read,
+   in ts, which must have count entries. If span isn't NULL, it is set to
+   the start of the earliest read and the end of the latest one, so the
+   skew of the whole sample is span->end - span->start. Entries of values
+   which could not be read are left zeroed. */
+int sensors_get_values_ts(sensors_value_request *req, int count,
+			  sensors_timestamp *ts, sensors_timestamp *span);
+
+/* Same as sensors_get_values(), but only spend about budget_us
+   microseconds of read time, as measured on previous reads. The most
+   urgent values are read, and all others are served from the last value
+   read, without accessing the device. Values are more urgent when their
+   last value is older, when they are closer to a limit of their feature,
+   or when they have a higher priority (see sensors_set_read_priority()).
+   Values never read successfully are always read, and so is the most
+   urgent value, even if it doesn't fit in the budget on its own. If ts
+   isn't NULL, it must have count entries, and is set to when each value
+   was actually read, so the caller knows how old cached values are. */
+int sensors_get_values_budget(sensors_value_request *req, int count,
+			      int budget_us, sensors_timestamp *ts);
+
+/* Set the priority of a subfeature of a certain chip for
+   sensors_get_values_budget(), or of all its subfeatures if subfeat_nr
+   is -1. The default priority is 1; a subfeature with priority 2 is read
+   as often as one with priority 1 which is twice as old. Priority 0 only
+   reads the subfeature when there is budget left. Note that chip should
+   not contain wildcard values! This function will return 0 on success,
+   and <0 on failure. */
+int sensors_set_read_priority(const sensors_chip_name *name, int subfeat_nr,
+			      int priority);
+
+/* A set of attributes to wait for change notifications on. Many drivers
+   notify userspace when an alarm attribute changes. */
+typedef struct sensors_watch sensors_watch;
+
+/* Create an empty watch set. Returns NULL on failure. A watch set refers
+   to libsensors internal structures, so it must be freed before calling
+   sensors_cleanup(). */
+sensors_watch *sensors_watch_new(void);
+
+/* Free a watch set and close all its file descriptors */
+void sensors_watch_free(sensors_watch *watch);
+
+/* Add a subfeature of a certain chip to a watch set. Note that chip should
+   not contain wildcard values! Returns 0 on success, and <0 on failure. */
+int sensors_watch_add(sensors_watch *watch, const sensors_chip_name *name,
+		      int subfeat_nr);
+
+/* Return a file descriptor which becomes readable when a watched
+   attribute changes, so that it can be added to an application's own
+   poll() or epoll loop. Do not close it. */
+int sensors_watch_fd(const sensors_watch *watch);
+
+/* Wait up to timeout_ms milliseconds (-1 for no limit) for watched
+   attributes to change. The changed attributes, at most max of them, are
+   read again and stored in req. Returns the number of changed attributes,
+   0 if none changed before the timeout or a signal, and <0 on failure. */
+int sensors_watch_wait(sensors_watch *watch, int timeout_ms,
+		       sensors_value_request *req, int max);
+
+/* A set of subfeatures to report only when their value changes */
+typedef struct sensors_subscription sensors_subscription;
+
+/* The deadband is relative to the last reported value */
+#define SENSORS_DEADBAND_RELATIVE	1
+
+/* Create an empty subscription set. Every refresh_ms milliseconds, all
+   values are reported whether they changed or not; use 0 to never do
+   that. A subscription set must be freed before calling
+   sensors_cleanup(). */
+sensors_subscription *sensors_subscription_new(int refresh_ms);
+
+/* Free a subscription set */
+void sensors_subscription_free(sensors_subscription *sub);
+
+/* Add a subfeature of a certain chip to a subscription set. Its value is
+   only reported when it moved by more than deadband since the last time
+   it was reported. With SENSORS_DEADBAND_RELATIVE in flags, deadband is
+   a fraction of the last reported value. Note that chip should not
+   contain wildcard values, and must stay valid as long as the set is
+   used! Returns 0 on success, and <0 on failure. */
+int sensors_subscribe(sensors_subscription *sub,
+		      const sensors_chip_name *name, int subfeat_nr,
+		      double deadband, unsigned int flags);
+
+/* Read all the subfeatures of a subscription set, and store the ones to
+   be reported in req, at most max of them; the others are reported by
+   the next calls. Values are reported the first time, when they moved
+   beyond their deadband, when reading them starts or stops failing, and
+   at each full refresh. Returns the number of values stored in req. */
+int sensors_subscription_poll(sensors_subscription *sub,
+			      sensors_value_request *req, int max);
+
+/* Add a subfeature energyN_power, of type SENSORS_SUBFEATURE_ENERGY_POWER
+   and with flag SENSORS_DERIVED, to each energy feature with a readable
+   energyN_input counter, from the next call to sensors_init() or
+   sensors_discover() on. Reading it returns the average power, in W,
+   since the previous time it was read, from the counter difference and
+   the time between the two reads. Counters which stay within 32 bits are
+   assumed to wrap around at 32 bits; other decreases are resets, and the
+   interval over which they happened is left out. The first read, and
+   reads before a complete interval was measured, fail with
+   -SENSORS_ERR_UNAVAILABLE; later reads without a new interval return the
+   last power again. Compute statements don't apply to these subfeatures.
+   Pass enable 0 to stop. The environment variable SENSORS_ENERGY_POWER
+   does the same for programs which don't call this function: "0"
+   disables, anything else enables. */
+void sensors_set_energy_power(int enable);
+
+/* Sample the counters of all derived power subfeatures every interval_ms
+   milliseconds from a background thread, so that a counter which wraps
+   around quickly is never sampled too seldom. Reads of these subfeatures
+   then don't access the device: they return the average power over all
+   the samples taken since the previous read. Use 0 to stop. This takes
+   effect immediately, and again each time chips are detected. Returns 0
+   on success, and <0 if the thread could not be started. */
+int sensors_set_energy_sampling(int interval_ms);
+
+/* Keep attribute files open after sensors_get_value() read them, so that
+   reading the same values again only costs one system call each. This is
+   meant for programs which read the same values over and over, at the
+   price of one file descriptor per value read, up to half of the file
+   descriptors the process may open. Pass enable 0 to read through the
+   file names again; files already open are closed by sensors_cleanup()
+   or when chips are detected again. */
+void sensors_set_keep_open(int enable);
+
+/* Units of raw values */
+typedef enum sensors_unit {
+	SENSORS_UNIT_NONE,
+	SENSORS_UNIT_VOLT,
+	SENSORS_UNIT_RPM,
+	SENSORS_UNIT_CELSIUS,
+	SENSORS_UNIT_WATT,
+	SENSORS_UNIT_JOULE,
+	SENSORS_UNIT_AMPERE,
+	SENSORS_UNIT_PERCENT,
+	SENSORS_UNIT_SECOND,
+} sensors_unit;
+
+/* A value in fixed point: value * 10^exponent, in unit */
+typedef struct sensors_raw_value {
+	long long value;
+	int exponent;
+	sensors_unit unit;
+} sensors_raw_value;
+
+/* Read the value of a subfeature of a certain chip as an integer, as the
+   kernel reports it, without going through floating point. If the
+   subfeature has a compute statement of the form a * @ + b, where a and
+   b have a finite number of decimals, it is applied in fixed point and
+   the exponent is adjusted as needed. Other compute statements are
+   applied in floating point and the result is rounded. Note that chip
+   should not contain wildcard values! This function will return 0 on
+   success, and <0 on failure. */
+int sensors_get_raw_value(const sensors_chip_name *name, int subfeat_nr,
+			  sensors_raw_value *value);
+
+/* Same as sensors_get_values(), but store the values as integers in raw,
+   which must have count entries, instead of in the value member of each
+   request */
+int sensors_get_raw_values(sensors_value_request *req, int count,
+			   sensors_raw_value *raw);
+
+/* Once a subfeature failed to read threshold times in a row, or a chip
+   did while all its subfeatures read so far were failing, stop reading it
+   for min_ms milliseconds, and let reads fail immediately with
+   -SENSORS_ERR_UNAVAILABLE. If the next read fails again, the delay
+   doubles, up to max_ms milliseconds. A successful read resets
+   everything. A threshold of 0, the default, disables this. */
+void sensors_set_fault_policy(int threshold, int min_ms, int max_ms);
+
+/* Read failure state of a subfeature or a chip */
+typedef struct sensors_fault_state {
+	int failures;		/* Consecutive failed reads */
+	int backoff_ms;		/* Current delay between reads, 0 if none */
+	int retry_ms;		/* Time left until the next read is allowed */
+} sensors_fault_state;
+
+/* Get the read failure state of a subfeature of a certain chip, or of the
+   chip as a whole if subfeat_nr is -1. Note that chip should not contain
+   wildcard values! This function will return 0 on success, and <0 on
+   failure. */
+int sensors_get_fault_state(const sensors_chip_name *name, int subfeat_nr,
+			    sensors_fault_state *state);
+
+/* Version of struct sensors_stats implemented by this library. Members
+   are only ever added at the end, along with a new version. */
+#define SENSORS_STATS_VERSION		1
+
+/* Read errors are counted by error code (SENSORS_ERR_*), larger codes in
+   entry 0. Read latencies are counted in buckets of powers of 2: bucket i
+   counts reads which took from 2^i to 2^(i+1) - 1 nanoseconds, and the
+   last bucket all slower reads. */
+#define SENSORS_STATS_ERRORS		16
+#define SENSORS_STATS_LATENCY_BUCKETS	32
+
+/* Activity counters, since the process started for the whole library, or
+   since the last sensors_init() for a chip. Counters which are not kept
+   per chip are 0 in chip statistics. */
+typedef struct sensors_stats {
+	unsigned int version;	/* Set by the caller */
+	unsigned int padding1;
+	unsigned long long discovery_ns;	/* Last chip discovery */
+	unsigned long long config_ns;	/* Last configuration loading */
+	unsigned long long values_read;
+	unsigned long long values_written;
+	unsigned long long read_errors[SENSORS_STATS_ERRORS];
+	unsigned long long read_latency[SENSORS_STATS_LATENCY_BUCKETS];
+	unsigned long long evals;	/* Compute and set expressions */
+	unsigned long long config_lookups;	/* Not per chip */
+	unsigned long long opens;	/* Attribute files, not per chip */
+	unsigned long long reads;	/* read(2) calls, not per chip */
+	unsigned long long writes;	/* write(2) calls, not per chip */
+	unsigned long long bytes_read;	/* Not per chip */
+} sensors_stats;
+
+/* Get the activity counters of a certain chip, or of the whole library if
+   name is NULL. The caller sets stats->version to the version it was
+   built against, usually SENSORS_STATS_VERSION, and only the members of
+   that version are filled. Note that chip should not contain wildcard
+   values! This function will return 0 on success, and <0 on failure. */
+int sensors_get_stats(const sensors_chip_name *name, sensors_stats *stats);
+
 /* Execute all set statements for this particular chip. The chip may contain
    wildcards!  This function will return 0 on success, and <0 on failure. */
 int sensors_do_chip_sets(const sensors_chip_name *name);
@@ -126,7 +533,9 @@ int sensors_do_chip_sets(const sensors_chip_name *name);
    one by one. If no chip name is provided, all detected chips are returned.
    To start at the beginning of the list, use 0 for nr; NULL is returned if
    we are at the end of the list. Do not try to change these chip names, as
-   they point to internal structures! */
+   they point to internal structures! Virtual chips defined in the
+   configuration come after the detected chips; they stay valid when the
+   configuration is reloaded, unless their name or subfeatures change. */
 const sensors_chip_name *sensors_get_detected_chips(const sensors_chip_name
 						    *match, int *nr);
 
@@ -134,6 +543,7 @@ const sensors_chip_name *sensors_get_detected_chips(const sensors_chip_name
 #define SENSORS_MODE_R			1
 #define SENSORS_MODE_W			2
 #define SENSORS_COMPUTE_MAPPING		4
+#define SENSORS_DERIVED			8
 
 typedef enum sensors_feature_type {
 	SENSORS_FEATURE_IN		= 0x00,
@@ -226,6 +636,7 @@ typedef enum sensors_subfeature_type {
 	SENSORS_SUBFEATURE_POWER_LCRIT_ALARM,
 
 	SENSORS_SUBFEATURE_ENERGY_INPUT = SENSORS_FEATURE_ENERGY << 8,
+	SENSORS_SUBFEATURE_ENERGY_POWER,
 
 	SENSORS_SUBFEATURE_CURR_INPUT = SENSORS_FEATURE_CURR << 8,
 	SENSORS_SUBFEATURE_CURR_MIN,
@@ -273,8 +684,9 @@ struct sensors_feature {
      (for example subfeatures fan1_input, fan1_min, fan1_div and fan1_alarm
       are mapped to main feature fan1)
    flags is a bitfield, its value is a combination of SENSORS_MODE_R (readable),
-     SENSORS_MODE_W (writable) and SENSORS_COMPUTE_MAPPING (affected by the
-     computation rules of the main feature) */
+     SENSORS_MODE_W (writable), SENSORS_COMPUTE_MAPPING (affected by the
+     computation rules of the main feature) and SENSORS_DERIVED (computed
+     by libsensors from other subfeatures, see sensors_set_energy_power()) */
 typedef struct sensors_subfeature {
 	char *name;
 	int number;
@@ -0,0 +1,122 @@
+/*
+    stats.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "access.h"
+#include "stats.h"
+
+sensors_stats sensors_stats_total;
+
+/* Size of struct sensors_stats for each version */
+static const size_t stats_size[] = {
+	0,
+	offsetof(sensors_stats, bytes_read) + sizeof(unsigned long long),
+};
+
+long long sensors_stats_now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &t);
+	return (long long)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static sensors_stats *chip_stats(const sensors_chip_features *chip_features)
+{
+	return &sensors_chip_rw(chip_features)->stats;
+}
+
+static void stats_read(sensors_stats *stats, int err, int bucket)
+{
+	sensors_stats_add(stats->values_read, 1);
+	sensors_stats_add(stats->read_latency[bucket], 1);
+	if (err)
+		sensors_stats_add(stats->read_errors[-err < SENSORS_STATS_ERRORS
+						     ? -err : 0], 1);
+}
+
+void sensors_stats_read(const sensors_chip_features *chip_features, int err,
+			long long ns)
+{
+	int bucket;
+
+	/* Index of the most significant bit */
+	bucket = ns > 1 ? 63 - __builtin_clzll(ns) : 0;
+	if (bucket >= SENSORS_STATS_LATENCY_BUCKETS)
+		bucket = SENSORS_STATS_LATENCY_BUCKETS - 1;
+
+	stats_read(&sensors_stats_total, err, bucket);
+	stats_read(chip_stats(chip_features), err, bucket);
+}
+
+void sensors_stats_eval(const sensors_chip_features *chip_features)
+{
+	sensors_stats_add(sensors_stats_total.evals, 1);
+	sensors_stats_add(chip_stats(chip_features)->evals, 1);
+}
+
+void sensors_stats_evals(const sensors_chip_features *chip_features,
+			 int count)
+{
+	sensors_stats_add(sensors_stats_total.evals, count);
+	sensors_stats_add(chip_stats(chip_features)->evals, count);
+}
+
+void sensors_stats_write(const sensors_chip_features *chip_features)
+{
+	sensors_stats_add(sensors_stats_total.values_written, 1);
+	sensors_stats_add(chip_stats(chip_features)->values_written, 1);
+}
+
+int sensors_get_stats(const sensors_chip_name *name, sensors_stats *stats)
+{
+	const sensors_chip_features *chip_features;
+	const unsigned long long *src;
+	unsigned long long *dst;
+	size_t i, count;
+
+	if (stats->version < 1 ||
+	    stats->version >= sizeof(stats_size) / sizeof(stats_size[0]))
+		return -SENSORS_ERR_NO_ENTRY;
+
+	if (!name)
+		src = &sensors_stats_total.discovery_ns;
+	else if (sensors_chip_name_has_wildcards(name))
+		return -SENSORS_ERR_WILDCARDS;
+	else if (!(chip_features = sensors_lookup_chip(name)))
+		return -SENSORS_ERR_NO_ENTRY;
+	else
+		src = &chip_features->stats.discovery_ns;
+
+	/* All members past the header are counters, which other threads
+	   may be updating */
+	dst = &stats->discovery_ns;
+	count = (stats_size[stats->version] -
+		 offsetof(sensors_stats, discovery_ns)) / sizeof(*dst);
+	for (i = 0; i < count; i++)
+		dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+
+	return 0;
+}
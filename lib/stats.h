@@ -0,0 +1,50 @@
+/*
+    stats.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_STATS_H
+#define LIB_SENSORS_STATS_H
+
+#include "data.h"
+
+/* Counters of the whole process */
+extern sensors_stats sensors_stats_total;
+
+/* Counters are updated from any thread, including batch worker threads
+   which may outlive sensors_cleanup(), without any ordering guarantee */
+#define sensors_stats_add(counter, n) \
+	((void)__atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED))
+
+/* Current time in nanoseconds, for measuring durations */
+long long sensors_stats_now(void);
+
+/* Account for a value read from a chip, which took ns nanoseconds. err is
+   0 on success, and the error returned by the read otherwise. */
+void sensors_stats_read(const sensors_chip_features *chip_features, int err,
+			long long ns);
+
+/* Account for an expression evaluation, or a value written */
+void sensors_stats_eval(const sensors_chip_features *chip_features);
+void sensors_stats_write(const sensors_chip_features *chip_features);
+
+/* Account for an expression evaluated for count values at once */
+void sensors_stats_evals(const sensors_chip_features *chip_features,
+			 int count);
+
+#endif /* def LIB_SENSORS_STATS_H */
@@ -0,0 +1,192 @@
+/*
+    subscribe.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "access.h"
+
+struct subscription_entry {
+	const sensors_chip_name *name;
+	int subfeat_nr;
+	double deadband;
+	unsigned int flags;
+	int reported;		/* Non-zero once reported at least once */
+	int refresh;		/* Non-zero if due for a full refresh */
+	int last_err;		/* Last reported error */
+	double last_value;	/* Last reported value, if last_err is 0 */
+};
+
+struct sensors_subscription {
+	struct subscription_entry *entries;
+	int entries_count;
+	int entries_max;
+	sensors_value_request *req;	/* Scratch space for batch reads */
+	int refresh_ms;
+	struct timespec next_refresh;
+	int next_entry;		/* Where the next poll starts looking */
+};
+
+sensors_subscription *sensors_subscription_new(int refresh_ms)
+{
+	sensors_subscription *sub;
+
+	sub = calloc(1, sizeof(sensors_subscription));
+	if (!sub)
+		sensors_fatal_error(__func__, "Out of memory");
+	sub->refresh_ms = refresh_ms > 0 ? refresh_ms : 0;
+
+	return sub;
+}
+
+void sensors_subscription_free(sensors_subscription *sub)
+{
+	if (!sub)
+		return;
+
+	free(sub->entries);
+	free(sub->req);
+	free(sub);
+}
+
+int sensors_subscribe(sensors_subscription *sub,
+		      const sensors_chip_name *name, int subfeat_nr,
+		      double deadband, unsigned int flags)
+{
+	struct subscription_entry entry;
+	const sensors_chip_features *chip_features;
+	const sensors_subfeature *subfeature;
+	int err;
+
+	if ((err = sensors_lookup_readable(name, subfeat_nr, &chip_features,
+					   &subfeature)))
+		return err;
+
+	entry.name = name;
+	entry.subfeat_nr = subfeat_nr;
+	entry.deadband = fabs(deadband);
+	entry.flags = flags;
+	entry.reported = 0;
+	entry.refresh = 0;
+	entry.last_err = 0;
+	entry.last_value = 0;
+	sensors_add_array_el(&entry, &sub->entries, &sub->entries_count,
+			     &sub->entries_max,
+			     sizeof(struct subscription_entry));
+
+	/* Grow the scratch space along */
+	free(sub->req);
+	sub->req = malloc(sub->entries_max * sizeof(sensors_value_request));
+	if (!sub->req)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	return 0;
+}
+
+/* Check whether a new reading moved beyond the deadband of an entry */
+static int entry_changed(const struct subscription_entry *entry,
+			 const sensors_value_request *req)
+{
+	double limit;
+
+	if (!entry->reported || req->err != entry->last_err)
+		return 1;
+	if (req->err)
+		return 0;
+
+	limit = entry->deadband;
+	if (entry->flags & SENSORS_DEADBAND_RELATIVE)
+		limit *= fabs(entry->last_value);
+	if (limit == 0)
+		return req->value != entry->last_value;
+	return fabs(req->value - entry->last_value) > limit;
+}
+
+/* Check whether a full refresh is due, and schedule the next one if so */
+static int refresh_due(sensors_subscription *sub)
+{
+	struct timespec now;
+
+	if (!sub->refresh_ms)
+		return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (now.tv_sec < sub->next_refresh.tv_sec ||
+	    (now.tv_sec == sub->next_refresh.tv_sec &&
+	     now.tv_nsec < sub->next_refresh.tv_nsec))
+		return 0;
+
+	sub->next_refresh = now;
+	sub->next_refresh.tv_sec += sub->refresh_ms / 1000;
+	sub->next_refresh.tv_nsec += (long)(sub->refresh_ms % 1000) * 1000000;
+	if (sub->next_refresh.tv_nsec >= 1000000000) {
+		sub->next_refresh.tv_sec++;
+		sub->next_refresh.tv_nsec -= 1000000000;
+	}
+	return 1;
+}
+
+int sensors_subscription_poll(sensors_subscription *sub,
+			      sensors_value_request *req, int max)
+{
+	struct subscription_entry *entry;
+	int i, j, n;
+
+	if (!sub->entries_count)
+		return 0;
+
+	for (i = 0; i < sub->entries_count; i++) {
+		sub->req[i].name = sub->entries[i].name;
+		sub->req[i].subfeat_nr = sub->entries[i].subfeat_nr;
+	}
+	sensors_get_values(sub->req, sub->entries_count);
+
+	if (refresh_due(sub))
+		for (i = 0; i < sub->entries_count; i++)
+			sub->entries[i].refresh = 1;
+
+	/* Entries which don't fit are reported by a later call, as their
+	   last reported value and refresh flag aren't updated. That call
+	   starts where this one stopped, so that entries which change all
+	   the time don't keep the others from being reported. */
+	if (sub->next_entry >= sub->entries_count)
+		sub->next_entry = 0;
+	for (j = 0, n = 0; j < sub->entries_count && n < max; j++) {
+		i = (sub->next_entry + j) % sub->entries_count;
+		entry = &sub->entries[i];
+		if (!entry->refresh && !entry_changed(entry, &sub->req[i]))
+			continue;
+
+		entry->reported = 1;
+		entry->refresh = 0;
+		entry->last_err = sub->req[i].err;
+		if (!sub->req[i].err)
+			entry->last_value = sub->req[i].value;
+		req[n++] = sub->req[i];
+		if (n == max)
+			sub->next_entry = i + 1;
+	}
+
+	return n;
+}
@@ -25,6 +25,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/vfs.h>
+#include <sys/resource.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
@@ -36,6 +38,10 @@
 #include "access.h"
 #include "general.h"
 #include "sysfs.h"
+#include "backend.h"
+#include "stats.h"
+#include "probes.h"
+#include "energy.h"
 
 
 /****************************************************************************/
@@ -56,12 +62,15 @@ static char *sysfs_read_attr(const char *device, const char *attr)
 
 	snprintf(path, NAME_MAX, "%s/%s", device, attr);
 
+	sensors_stats_add(sensors_stats_total.opens, 1);
 	if (!(f = fopen(path, "r")))
 		return NULL;
 	p = fgets(buf, ATTR_MAX, f);
 	fclose(f);
+	sensors_stats_add(sensors_stats_total.reads, 1);
 	if (!p)
 		return NULL;
+	sensors_stats_add(sensors_stats_total.bytes_read, strlen(buf));
 
 	/* Last byte is a '\n'; chop that off */
 	p = strndup(buf, strlen(buf) - 1);
@@ -137,6 +146,12 @@ static int sysfs_foreach_busdev(const char *bus_type,
 /****************************************************************************/
 
 char sensors_sysfs_mount[NAME_MAX];
+int sensors_keep_open;
+
+/* Attribute files kept open for reading, and how many may be, so that
+   the process keeps file descriptors for everything else */
+static int sysfs_read_fds;
+static int sysfs_read_fds_max;
 
 static
 int get_type_scaling(sensors_subfeature_type type)
@@ -167,6 +182,58 @@ int get_type_scaling(sensors_subfeature_type type)
 	}
 }
 
+/* Power of ten the raw value of a subfeature is expressed in */
+int sensors_get_type_exponent(sensors_subfeature_type type)
+{
+	int scaling = get_type_scaling(type);
+	int exponent = 0;
+
+	while (scaling >= 10) {
+		scaling /= 10;
+		exponent--;
+	}
+	return exponent;
+}
+
+sensors_unit sensors_get_type_unit(sensors_subfeature_type type)
+{
+	/* Second class subfeatures first */
+	switch (type) {
+	case SENSORS_SUBFEATURE_POWER_AVERAGE_INTERVAL:
+		return SENSORS_UNIT_SECOND;
+	case SENSORS_SUBFEATURE_TEMP_OFFSET:
+		return SENSORS_UNIT_CELSIUS;
+	case SENSORS_SUBFEATURE_ENERGY_POWER:
+		return SENSORS_UNIT_WATT;
+	default:
+		break;
+	}
+
+	/* Alarms, beeps, faults, types, dividers... */
+	if (type & 0x80)
+		return SENSORS_UNIT_NONE;
+
+	switch (type >> 8) {
+	case SENSORS_FEATURE_IN:
+	case SENSORS_FEATURE_VID:
+		return SENSORS_UNIT_VOLT;
+	case SENSORS_FEATURE_FAN:
+		return SENSORS_UNIT_RPM;
+	case SENSORS_FEATURE_TEMP:
+		return SENSORS_UNIT_CELSIUS;
+	case SENSORS_FEATURE_POWER:
+		return SENSORS_UNIT_WATT;
+	case SENSORS_FEATURE_ENERGY:
+		return SENSORS_UNIT_JOULE;
+	case SENSORS_FEATURE_CURR:
+		return SENSORS_UNIT_AMPERE;
+	case SENSORS_FEATURE_HUMIDITY:
+		return SENSORS_UNIT_PERCENT;
+	default:
+		return SENSORS_UNIT_NONE;
+	}
+}
+
 static
 char *get_feature_name(sensors_feature_type ftype, char *sfname)
 {
@@ -293,6 +360,7 @@ static const struct subfeature_type_match power_matches[] = {
 
 static const struct subfeature_type_match energy_matches[] = {
 	{ "input", SENSORS_SUBFEATURE_ENERGY_INPUT },
+	{ "power", SENSORS_SUBFEATURE_ENERGY_POWER },
 	{ NULL, 0 }
 };
 
@@ -415,25 +483,59 @@ static int sensors_get_attr_mode(const char *device, const char *attr)
 	return mode;
 }
 
-static int sensors_read_dynamic_chip(sensors_chip_features *chip,
-				     const char *dev_path)
+/* Subfeatures of one feature type, sparse and sorted, see
+   sensors_build_chip_features() */
+struct sparse_subfeatures {
+	int count;
+	sensors_subfeature *sf;
+};
+
+/* Add a derived energyN_power subfeature next to each readable energyN_input
+   counter, unless the chip has one already. Returns the number of
+   subfeatures added. */
+static int add_energy_power(struct sparse_subfeatures *energy,
+			    int feature_size)
+{
+	sensors_subfeature *input, *power;
+	char name[32];
+	int nr, added = 0;
+
+	for (nr = 0; nr < energy->count; nr++) {
+		input = &energy->sf[nr * feature_size +
+			(SENSORS_SUBFEATURE_ENERGY_INPUT & 0x7F)];
+		power = &energy->sf[nr * feature_size +
+			(SENSORS_SUBFEATURE_ENERGY_POWER & 0x7F)];
+		if (!input->name || !(input->flags & SENSORS_MODE_R) ||
+		    power->name)
+			continue;
+
+		snprintf(name, sizeof(name), "energy%d_power", nr + 1);
+		power->type = SENSORS_SUBFEATURE_ENERGY_POWER;
+		power->name = strdup(name);
+		if (!power->name)
+			sensors_fatal_error(__func__, "Out of memory");
+		power->flags = SENSORS_MODE_R | SENSORS_DERIVED;
+		added++;
+	}
+
+	return added;
+}
+
+/* Build the feature and subfeature tables of a chip out of the list of its
+   attributes, as provided by the backend. */
+int sensors_build_chip_features(sensors_chip_features *chip,
+				const sensors_attr_list *attrs)
 {
 	int i, fnum = 0, sfnum = 0, prev_slot;
 	static int max_subfeatures, feature_size;
-	DIR *dir;
-	struct dirent *ent;
-	struct {
-		int count;
-		sensors_subfeature *sf;
-	} all_types[SENSORS_FEATURE_MAX];
+	const char *name;
+	struct sparse_subfeatures all_types[SENSORS_FEATURE_MAX];
 	sensors_subfeature *dyn_subfeatures;
 	sensors_feature *dyn_features;
+	sensors_subfeature_state *dyn_state;
 	sensors_feature_type ftype;
 	sensors_subfeature_type sftype;
 
-	if (!(dir = opendir(dev_path)))
-		return -errno;
-
 	/* Dynamically figure out the max number of subfeatures */
 	if (!max_subfeatures) {
 		max_subfeatures = sensors_compute_max_sf();
@@ -445,16 +547,9 @@ static int sensors_read_dynamic_chip(sensors_chip_features *chip,
 	   can store them sorted and then later create a dense sorted table. */
 	memset(&all_types, 0, sizeof(all_types));
 
-	while ((ent = readdir(dir))) {
-		char *name;
+	while ((name = attrs->next(attrs->data))) {
 		int nr;
 
-		/* Skip directories and symlinks */
-		if (ent->d_type != DT_REG)
-			continue;
-
-		name = ent->d_name;
-
 		sftype = sensors_subfeature_get_type(name, &nr);
 		if (sftype == SENSORS_SUBFEATURE_UNKNOWN)
 			continue;
@@ -529,15 +624,18 @@ static int sensors_read_dynamic_chip(sensors_chip_features *chip,
 		/* Other and misc subfeatures are never scaled */
 		if (sftype < SENSORS_SUBFEATURE_VID && !(sftype & 0x80))
 			all_types[ftype].sf[i].flags |= SENSORS_COMPUTE_MAPPING;
-		all_types[ftype].sf[i].flags |=
-					sensors_get_attr_mode(dev_path, name);
+		all_types[ftype].sf[i].flags |= attrs->mode(attrs->data, name);
 
 		sfnum++;
 	}
-	closedir(dir);
+
+	if (attrs->derived && sensors_energy_enabled)
+		sfnum += add_energy_power(&all_types[SENSORS_FEATURE_ENERGY],
+					  feature_size);
 
 	if (!sfnum) { /* No subfeature */
 		chip->subfeature = NULL;
+		chip->state = NULL;
 		goto exit_free;
 	}
 
@@ -557,8 +655,14 @@ static int sensors_read_dynamic_chip(sensors_chip_features *chip,
 
 	dyn_subfeatures = calloc(sfnum, sizeof(sensors_subfeature));
 	dyn_features = calloc(fnum, sizeof(sensors_feature));
-	if (!dyn_subfeatures || !dyn_features)
+	dyn_state = calloc(sfnum, sizeof(sensors_subfeature_state));
+	if (!dyn_subfeatures || !dyn_features || !dyn_state)
 		sensors_fatal_error(__func__, "Out of memory");
+	for (i = 0; i < sfnum; i++) {
+		dyn_state[i].read_fd = -1;
+		dyn_state[i].write_fd = -1;
+		dyn_state[i].priority = 1;
+	}
 
 	/* Copy from the sparse array to the compact array */
 	sfnum = 0;
@@ -595,6 +699,8 @@ static int sensors_read_dynamic_chip(sensors_chip_features *chip,
 	chip->subfeature_count = sfnum;
 	chip->feature = dyn_features;
 	chip->feature_count = ++fnum;
+	chip->state = dyn_state;
+	sensors_energy_init(chip);
 
 exit_free:
 	for (ftype = 0; ftype < SENSORS_FEATURE_MAX; ftype++)
@@ -602,8 +708,50 @@ exit_free:
 	return 0;
 }
 
+struct sysfs_attr_dir {
+	DIR *dir;
+	const char *path;
+};
+
+static const char *sysfs_next_attr(void *data)
+{
+	struct sysfs_attr_dir *d = data;
+	struct dirent *ent;
+
+	while ((ent = readdir(d->dir))) {
+		/* Skip directories and symlinks */
+		if (ent->d_type == DT_REG)
+			return ent->d_name;
+	}
+	return NULL;
+}
+
+static int sysfs_attr_mode(void *data, const char *name)
+{
+	struct sysfs_attr_dir *d = data;
+
+	return sensors_get_attr_mode(d->path, name);
+}
+
+static int sensors_read_dynamic_chip(sensors_chip_features *chip,
+				     const char *dev_path)
+{
+	struct sysfs_attr_dir d;
+	sensors_attr_list attrs = { sysfs_next_attr, sysfs_attr_mode, &d, 1 };
+	int ret;
+
+	if (!(d.dir = opendir(dev_path)))
+		return -errno;
+	d.path = dev_path;
+
+	ret = sensors_build_chip_features(chip, &attrs);
+	closedir(d.dir);
+
+	return ret;
+}
+
 /* returns !0 if sysfs filesystem was found, 0 otherwise */
-int sensors_init_sysfs(void)
+static int sensors_init_sysfs(void)
 {
 	struct statfs statfsbuf;
 
@@ -761,10 +909,16 @@ static int sensors_read_one_sysfs_chip(const char *dev_path,
 	int ret = 1;
 	int virtual = 0;
 	sensors_chip_features entry;
+	long long start;
+
+	SENSORS_PROBE1(chip__start, hwmon_path);
+	start = sensors_stats_now();
 
 	/* ignore any device without name attribute */
-	if (!(entry.chip.prefix = sysfs_read_attr(hwmon_path, "name")))
+	if (!(entry.chip.prefix = sysfs_read_attr(hwmon_path, "name"))) {
+		SENSORS_PROBE2(chip__end, hwmon_path, 0);
 		return 0;
+	}
 
 	entry.chip.path = strdup(hwmon_path);
 	if (!entry.chip.path)
@@ -797,13 +951,19 @@ static int sensors_read_one_sysfs_chip(const char *dev_path,
 		ret = 0;
 		goto exit_free;
 	}
+	entry.timeout_ms = 0;
+	memset(&entry.breaker, 0, sizeof(entry.breaker));
+	memset(&entry.stats, 0, sizeof(entry.stats));
+	entry.stats.discovery_ns = sensors_stats_now() - start;
 	sensors_add_proc_chips(&entry);
 
+	SENSORS_PROBE2(chip__end, hwmon_path, ret);
 	return ret;
 
 exit_free:
 	free(entry.chip.prefix);
 	free(entry.chip.path);
+	SENSORS_PROBE2(chip__end, hwmon_path, ret);
 	return ret;
 }
 
@@ -914,69 +1074,367 @@ int sensors_read_sysfs_bus(void)
 	return 0;
 }
 
+static int sysfs_discover(const char *source)
+{
+	int res;
+	(void)source; /* hide warning */
+
+	if (!sensors_init_sysfs())
+		return -SENSORS_ERR_KERNEL;
+	if ((res = sensors_read_sysfs_bus()))
+		return res;
+	return sensors_read_sysfs_chips();
+}
+
+/* Same as above, but in a directory tree which merely looks like sysfs,
+   for example a copy of /sys taken on another system */
+static int dir_discover(const char *root)
+{
+	struct stat st;
+	int res;
+
+	/* Attribute paths are built out of the root */
+	if (strlen(root) >= NAME_MAX ||
+	    stat(root, &st) < 0 || !S_ISDIR(st.st_mode))
+		return -SENSORS_ERR_KERNEL;
+
+	strcpy(sensors_sysfs_mount, root);
+	if ((res = sensors_read_sysfs_bus()))
+		return res;
+	return sensors_read_sysfs_chips();
+}
+
+/* Parse the raw value read from an attribute file. buf must have room
+   for a trailing '\0' after len bytes. */
+static int sysfs_parse_raw(char *buf, ssize_t len, long long *value)
+{
+	char *end;
+
+	sensors_stats_add(sensors_stats_total.bytes_read, len);
+	buf[len] = '\0';
+
+	*value = strtoll(buf, &end, 10);
+	if (end == buf)
+		return -SENSORS_ERR_ACCESS_R;
+
+	return 0;
+}
+
+/* Read an attribute given its full path. This doesn't touch any library
+   data structure, so it is safe to call from a thread which may outlive
+   the caller's interest in the result. */
+static int sysfs_read(const char *path, long long *value)
+{
+	char buf[32];
+	ssize_t len;
+	int fd, err = 0;
+
+	sensors_stats_add(sensors_stats_total.opens, 1);
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -SENSORS_ERR_KERNEL;
+
+	len = read(fd, buf, sizeof(buf) - 1);
+	if (len < 0)
+		err = errno == EIO ? -SENSORS_ERR_IO : -SENSORS_ERR_ACCESS_R;
+	close(fd);
+	sensors_stats_add(sensors_stats_total.reads, 1);
+	if (err)
+		return err;
+
+	return sysfs_parse_raw(buf, len, value);
+}
+
+/* Same as above, through a file descriptor kept open in state, so that
+   subsequent reads of the same attribute only cost one pread(2). Once
+   half of the file descriptors the process may open are kept open, or
+   when it runs out of them, the attribute is read by its path instead. */
+static int sysfs_read_open(const char *path, sensors_subfeature_state *state,
+			   long long *value)
+{
+	char buf[32];
+	ssize_t len;
+	int err;
+
+	if (state->read_fd < 0) {
+		if (__atomic_load_n(&sysfs_read_fds, __ATOMIC_RELAXED) >=
+		    sysfs_read_fds_max)
+			return sysfs_read(path, value);
+		sensors_stats_add(sensors_stats_total.opens, 1);
+		state->read_fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (state->read_fd < 0 && (errno == EMFILE || errno == ENFILE))
+			return sysfs_read(path, value);
+		if (state->read_fd < 0)
+			return -SENSORS_ERR_KERNEL;
+		__atomic_add_fetch(&sysfs_read_fds, 1, __ATOMIC_RELAXED);
+	}
+
+	len = pread(state->read_fd, buf, sizeof(buf) - 1, 0);
+	sensors_stats_add(sensors_stats_total.reads, 1);
+	if (len < 0) {
+		err = errno == EIO ? -SENSORS_ERR_IO : -SENSORS_ERR_ACCESS_R;
+
+		/* Start over with a fresh file on the next attempt */
+		close(state->read_fd);
+		state->read_fd = -1;
+		__atomic_sub_fetch(&sysfs_read_fds, 1, __ATOMIC_RELAXED);
+		return err;
+	}
+
+	return sysfs_parse_raw(buf, len, value);
+}
+
+int sensors_read_sysfs_raw(const char *path, long long *raw)
+{
+	int err;
+
+	SENSORS_PROBE1(read__start, path);
+	err = sensors_current_backend->read(path, raw);
+	SENSORS_PROBE3(read__end, path, err ? 0 : *raw, err);
+
+	return err;
+}
+
+int sensors_read_sysfs_file(const char *path, sensors_subfeature_type type,
+			    double *value)
+{
+	long long raw;
+	int err;
+
+	err = sensors_read_sysfs_raw(path, &raw);
+	if (err)
+		return err;
+	*value = (double)raw / get_type_scaling(type);
+
+	return 0;
+}
+
+int sensors_read_sysfs_fd(const sensors_chip_name *name,
+			  const sensors_subfeature *subfeature, int fd,
+			  double *value)
+{
+	char buf[32];
+	ssize_t len;
+	long long raw = 0;
+	int err;
+
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	sensors_stats_add(sensors_stats_total.reads, 1);
+	if (len < 0)
+		err = errno == EIO ? -SENSORS_ERR_IO : -SENSORS_ERR_ACCESS_R;
+	else
+		err = sysfs_parse_raw(buf, len, &raw);
+	sensors_trace_read(name->path, subfeature->name, err, raw);
+	if (err)
+		return err;
+	*value = (double)raw / get_type_scaling(subfeature->type);
+
+	return 0;
+}
+
+void sensors_set_keep_open(int enable)
+{
+	struct rlimit limit;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) || limit.rlim_cur > INT_MAX)
+		sysfs_read_fds_max = INT_MAX;
+	else
+		sysfs_read_fds_max = limit.rlim_cur / 2;
+	sensors_keep_open = enable;
+}
+
 int sensors_read_sysfs_attr(const sensors_chip_name *name,
 			    const sensors_subfeature *subfeature,
-			    double *value)
+			    sensors_subfeature_state *state, double *value)
 {
 	char n[NAME_MAX];
-	FILE *f;
+	long long raw;
+	int err;
 
 	snprintf(n, NAME_MAX, "%s/%s", name->path, subfeature->name);
-	if ((f = fopen(n, "r"))) {
-		int res, err = 0;
-
-		errno = 0;
-		res = fscanf(f, "%lf", value);
-		if (res == EOF && errno == EIO)
-			err = -SENSORS_ERR_IO;
-		else if (res != 1)
-			err = -SENSORS_ERR_ACCESS_R;
-		res = fclose(f);
-		if (err)
-			return err;
-
-		if (res == EOF) {
-			if (errno == EIO)
-				return -SENSORS_ERR_IO;
-			else
-				return -SENSORS_ERR_ACCESS_R;
-		}
-		*value /= get_type_scaling(subfeature->type);
-	} else
-		return -SENSORS_ERR_KERNEL;
+	if (!sensors_keep_open || !sensors_current_backend->read_open)
+		return sensors_read_sysfs_file(n, subfeature->type, value);
+
+	SENSORS_PROBE1(read__start, n);
+	err = sensors_current_backend->read_open(n, state, &raw);
+	SENSORS_PROBE3(read__end, n, err ? 0 : raw, err);
+	if (err)
+		return err;
+	*value = (double)raw / get_type_scaling(subfeature->type);
 
 	return 0;
 }
 
+/* Format a raw value as a decimal string without going through stdio.
+   Returns the length of the string. */
+static int sysfs_format_raw(char *buf, long value)
+{
+	char digits[24];
+	unsigned long v;
+	int i = 0, len = 0;
+
+	v = value < 0 ? -(unsigned long)value : (unsigned long)value;
+	do {
+		digits[i++] = '0' + v % 10;
+		v /= 10;
+	} while (v);
+
+	if (value < 0)
+		buf[len++] = '-';
+	while (i)
+		buf[len++] = digits[--i];
+	buf[len] = '\0';
+
+	return len;
+}
+
+/* Close the file descriptors kept open for a subfeature, if any */
+void sensors_close_sysfs_attr(sensors_subfeature_state *state)
+{
+	if (state->read_fd >= 0) {
+		close(state->read_fd);
+		state->read_fd = -1;
+		__atomic_sub_fetch(&sysfs_read_fds, 1, __ATOMIC_RELAXED);
+	}
+	if (state->write_fd >= 0) {
+		close(state->write_fd);
+		state->write_fd = -1;
+	}
+	state->written = 0;
+}
+
+/*
+ * Write a raw value to a sysfs attribute file. The file is kept open so that
+ * subsequent writes to the same attribute only cost one write(2). Regular
+ * files, as found in a copy of sysfs, must also be truncated, as they don't
+ * start over with each write like sysfs attributes do.
+ */
+static int sysfs_write_attr(const char *dir, const char *attr,
+			    sensors_subfeature_state *state, long value,
+			    int truncate)
+{
+	char buf[24];
+	int len;
+	ssize_t res;
+
+	if (state->write_fd < 0) {
+		char n[NAME_MAX];
+
+		snprintf(n, NAME_MAX, "%s/%s", dir, attr);
+		sensors_stats_add(sensors_stats_total.opens, 1);
+		state->write_fd = open(n, O_WRONLY | O_CLOEXEC);
+		if (state->write_fd < 0)
+			return -SENSORS_ERR_KERNEL;
+	}
+
+	len = sysfs_format_raw(buf, value);
+	res = pwrite(state->write_fd, buf, len, 0);
+	sensors_stats_add(sensors_stats_total.writes, 1);
+	if (res == len && truncate && ftruncate(state->write_fd, len) < 0)
+		res = -1;
+	if (res != len) {
+		int err = (res < 0 && errno == EIO) ? -SENSORS_ERR_IO :
+						      -SENSORS_ERR_ACCESS_W;
+
+		/* Start over with a fresh file on the next attempt */
+		sensors_close_sysfs_attr(state);
+		return err;
+	}
+
+	return 0;
+}
+
+static int sysfs_write(const char *dir, const char *attr,
+		       sensors_subfeature_state *state, long value)
+{
+	return sysfs_write_attr(dir, attr, state, value, 0);
+}
+
+static int dir_write(const char *dir, const char *attr,
+		     sensors_subfeature_state *state, long value)
+{
+	return sysfs_write_attr(dir, attr, state, value, 1);
+}
+
+/*
+ * Write a value to an attribute through the current backend. Unless
+ * SENSORS_SET_FORCE is set in flags, nothing is written if the raw value
+ * is the one which was last written successfully.
+ */
 int sensors_write_sysfs_attr(const sensors_chip_name *name,
 			     const sensors_subfeature *subfeature,
-			     double value)
+			     sensors_subfeature_state *state,
+			     double value, unsigned int flags)
 {
-	char n[NAME_MAX];
-	FILE *f;
+	long raw;
+	int err;
 
-	snprintf(n, NAME_MAX, "%s/%s", name->path, subfeature->name);
-	if ((f = fopen(n, "w"))) {
-		int res, err = 0;
-
-		value *= get_type_scaling(subfeature->type);
-		res = fprintf(f, "%d", (int) value);
-		if (res == -EIO)
-			err = -SENSORS_ERR_IO;
-		else if (res < 0)
-			err = -SENSORS_ERR_ACCESS_W;
-		res = fclose(f);
-		if (err)
-			return err;
-
-		if (res == EOF) {
-			if (errno == EIO)
-				return -SENSORS_ERR_IO;
-			else
-				return -SENSORS_ERR_ACCESS_W;
-		}
-	} else
-		return -SENSORS_ERR_KERNEL;
+	value *= get_type_scaling(subfeature->type);
+	raw = (int) value;
+
+	if (!(flags & SENSORS_SET_FORCE) && state->written &&
+	    state->last_written == raw)
+		return 0;
+
+	SENSORS_PROBE3(write__start, name->path, subfeature->name, raw);
+	err = sensors_current_backend->write(name->path, subfeature->name,
+					     state, raw);
+	SENSORS_PROBE3(write__end, name->path, subfeature->name, err);
+	if (err)
+		return err;
+
+	state->last_written = raw;
+	state->written = 1;
 
 	return 0;
 }
+
+/* Read a text attribute, such as a label. The trailing newline is
+   stripped. */
+static char *sysfs_read_text(const char *dir, const char *attr)
+{
+	char buf[PATH_MAX];
+	FILE *f;
+	int len;
+	char *text;
+
+	snprintf(buf, PATH_MAX, "%s/%s", dir, attr);
+	sensors_stats_add(sensors_stats_total.opens, 1);
+	if (!(f = fopen(buf, "r")))
+		return NULL;
+	len = fread(buf, 1, sizeof(buf), f);
+	fclose(f);
+	sensors_stats_add(sensors_stats_total.reads, 1);
+	if (len <= 0)
+		return NULL;
+	sensors_stats_add(sensors_stats_total.bytes_read, len);
+
+	/* len - 1 to strip the '\n' at the end */
+	buf[len - 1] = '\0';
+	text = strdup(buf);
+	if (!text)
+		sensors_fatal_error(__func__, "Out of memory");
+	return text;
+}
+
+/* Live sysfs, mounted on /sys */
+const sensors_backend sensors_sysfs_backend = {
+	sysfs_discover,
+	sysfs_read,
+	sysfs_read_open,
+	sysfs_write,
+	sysfs_read_text,
+	NULL,
+	1,
+};
+
+/* A directory tree laid out like sysfs, rooted anywhere */
+const sensors_backend sensors_dir_backend = {
+	dir_discover,
+	sysfs_read,
+	sysfs_read_open,
+	dir_write,
+	sysfs_read_text,
+	NULL,
+	1,
+};
@@ -24,20 +24,63 @@
 
 extern char sensors_sysfs_mount[];
 
-int sensors_init_sysfs(void);
+/* Non-zero if attribute files are kept open after reading them, see
+   sensors_set_keep_open() */
+extern int sensors_keep_open;
 
 int sensors_read_sysfs_chips(void);
 
 int sensors_read_sysfs_bus(void);
 
-/* Read a value out of a sysfs attribute file */
+/* Power of ten and unit of the raw value of a subfeature */
+int sensors_get_type_exponent(sensors_subfeature_type type);
+sensors_unit sensors_get_type_unit(sensors_subfeature_type type);
+
+/* Attributes of a chip, as enumerated by a backend */
+typedef struct sensors_attr_list {
+	/* Name of the next attribute, NULL when there are no more */
+	const char *(*next)(void *data);
+	/* SENSORS_MODE_* flags of an attribute. Only called for the name
+	   next() just returned. */
+	int (*mode)(void *data, const char *name);
+	void *data;
+	/* Add the subfeatures derived from attributes, as enabled */
+	int derived;
+} sensors_attr_list;
+
+/* Fill in the features and subfeatures of a chip from its attributes */
+int sensors_build_chip_features(sensors_chip_features *chip,
+				const sensors_attr_list *attrs);
+
+/* Read a value out of an attribute, through the current backend. The
+   attribute file is kept open in state if sensors_keep_open is set. */
 int sensors_read_sysfs_attr(const sensors_chip_name *name,
 			    const sensors_subfeature *subfeature,
+			    sensors_subfeature_state *state, double *value);
+
+/* Same as above, but only needs the full path of the attribute */
+int sensors_read_sysfs_file(const char *path, sensors_subfeature_type type,
 			    double *value);
 
-/* Write a value to a sysfs attribute file */
+/* Same as above, from an attribute file which is already open. Reading
+   the file this way also acknowledges pending change notifications. The
+   read bypasses the backend, but is recorded if a trace is. */
+int sensors_read_sysfs_fd(const sensors_chip_name *name,
+			  const sensors_subfeature *subfeature, int fd,
+			  double *value);
+
+/* Read the raw, unscaled value of an attribute given its full path,
+   through the current backend */
+int sensors_read_sysfs_raw(const char *path, long long *raw);
+
+/* Write a value to an attribute, through the current backend */
 int sensors_write_sysfs_attr(const sensors_chip_name *name,
 			     const sensors_subfeature *subfeature,
-			     double value);
+			     sensors_subfeature_state *state,
+			     double value, unsigned int flags);
+
+/* Close the attribute files kept open by sensors_read_sysfs_attr() and
+   sensors_write_sysfs_attr() */
+void sensors_close_sysfs_attr(sensors_subfeature_state *state);
 
 #endif /* def LIB_SENSORS_SYSFS_H */
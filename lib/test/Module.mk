@@ -1,8 +1,8 @@
 LIB_DIR		:= lib
 LIB_TEST_DIR	:= lib/test
 
-LIB_TEST_TARGETS := $(LIB_TEST_DIR)/test-scanner
-LIB_TEST_SOURCES := $(LIB_TEST_DIR)/test-scanner.c
+LIB_TEST_TARGETS := $(LIB_TEST_DIR)/test-scanner $(LIB_TEST_DIR)/test-libsensors
+LIB_TEST_SOURCES := $(LIB_TEST_DIR)/test-scanner.c $(LIB_TEST_DIR)/test-libsensors.c
 
 LIB_TEST_SCANNER_OBJS := \
 	$(LIB_TEST_DIR)/test-scanner.ro \
@@ -18,7 +18,40 @@ user :: all-lib-test
 
 $(LIB_TEST_DIR)/test-scanner.ro: $(LIB_DIR)/data.h $(LIB_DIR)/conf.h $(LIB_DIR)/conf-parse.h $(LIB_DIR)/scanner.h
 
+# Behavior tests of the library. The library is built in, with its default
+# files looked up relative to the directory the tests run in.
+LIB_TEST_LIBSENSORS_SOURCES := $(LIB_TEST_DIR)/test-libsensors.c \
+	$(LIB_TEST_DIR)/hwmon-tree.c $(LIBCSOURCES) $(LIBOTHEROBJECTS:.o=.c)
+LIB_TEST_LIBSENSORS_PATHS := -DETCDIR="\"test-etc\"" -DDATADIR="\"test-data\"" \
+	-DDMI_DIR="\"test-dmi\""
+
+$(LIB_TEST_DIR)/test-libsensors: $(LIB_TEST_LIBSENSORS_SOURCES) $(LIB_DIR)/conf-parse.h \
+				 $(LIB_TEST_DIR)/hwmon-tree.h
+	$(CC) $(ALL_CPPFLAGS) $(LIB_TEST_LIBSENSORS_PATHS) -D_REENTRANT \
+	$(ALL_CFLAGS) $(FLEXNOWARN) $(YACCNOWARN) -o $@ \
+	$(LIB_TEST_LIBSENSORS_SOURCES) -lm -lpthread
+
+check: all-lib-test
+	$(LIB_TEST_DIR)/test-libsensors
+
+# Synthetic hwmon trees and benchmarks, not built by default
+LIB_BENCH_TARGETS := $(LIB_TEST_DIR)/gen-hwmon-tree $(LIB_TEST_DIR)/bench-libsensors
+
+$(LIB_TEST_DIR)/gen-hwmon-tree: $(LIB_TEST_DIR)/gen-hwmon-tree.ro $(LIB_TEST_DIR)/hwmon-tree.ro
+	$(CC) $(EXLDFLAGS) -o $@ $^
+
+$(LIB_TEST_DIR)/bench-libsensors: $(LIB_TEST_DIR)/bench-libsensors.ro $(LIB_TEST_DIR)/hwmon-tree.ro lib/$(LIBSHBASENAME)
+	$(CC) $(EXLDFLAGS) -o $@ $(LIB_TEST_DIR)/bench-libsensors.ro $(LIB_TEST_DIR)/hwmon-tree.ro -Llib -lsensors
+
+$(LIB_TEST_DIR)/gen-hwmon-tree.ro $(LIB_TEST_DIR)/hwmon-tree.ro: $(LIB_TEST_DIR)/hwmon-tree.h
+$(LIB_TEST_DIR)/bench-libsensors.ro: $(LIB_TEST_DIR)/hwmon-tree.h $(LIB_DIR)/sensors.h $(LIB_DIR)/error.h
+
+all-lib-bench: $(LIB_BENCH_TARGETS)
+
+bench: all-lib-bench
+	LD_LIBRARY_PATH=lib $(LIB_TEST_DIR)/bench-libsensors $(BENCHFLAGS)
+
 clean-lib-test:
 	$(RM) $(LIB_TEST_DIR)/*.rd $(LIB_TEST_DIR)/*.ro 
-	$(RM) $(LIB_TEST_TARGETS)
+	$(RM) $(LIB_TEST_TARGETS) $(LIB_BENCH_TARGETS)
 clean :: clean-lib-test
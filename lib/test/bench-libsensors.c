@@ -0,0 +1,353 @@
+/*
+    bench-libsensors.c - Benchmarks of the libsensors hot paths
+    Copyright (C) 2026  The lm-sensors developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* this define needed for mkdtemp() */
+#define _GNU_SOURCE
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "../sensors.h"
+#include "../error.h"
+#include "hwmon-tree.h"
+
+/*
+ * All results are printed as one JSON object on stdout. Each benchmark
+ * reports the distribution of its samples in nanoseconds.
+ */
+
+static int first_result = 1;
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+	long long x = *(const long long *)a, y = *(const long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Print the statistics of count samples, followed by extra JSON members
+   if not NULL */
+static void report(const char *name, long long *samples, int count,
+		   const char *extra)
+{
+	long long sum = 0;
+	int i;
+
+	qsort(samples, count, sizeof(long long), cmp_ll);
+	for (i = 0; i < count; i++)
+		sum += samples[i];
+
+	printf("%s\n    { \"name\": \"%s\", \"samples\": %d, "
+	       "\"min_ns\": %lld, \"median_ns\": %lld, \"p99_ns\": %lld, "
+	       "\"mean_ns\": %lld%s%s }",
+	       first_result ? "" : ",", name, count, samples[0],
+	       samples[count / 2], samples[(count * 99) / 100],
+	       sum / count, extra ? ", " : "", extra ? extra : "");
+	first_result = 0;
+}
+
+static void fail(const char *what, int err)
+{
+	fprintf(stderr, "%s: %s\n", what, err < 0 ? sensors_strerror(err) :
+		strerror(errno));
+	exit(1);
+}
+
+/* Collect all readable subfeatures */
+static sensors_value_request *get_requests(int *count)
+{
+	const sensors_chip_name *chip;
+	const sensors_feature *feature;
+	const sensors_subfeature *sub;
+	sensors_value_request *req = NULL;
+	int c = 0, f, s, n = 0, max = 0;
+
+	while ((chip = sensors_get_detected_chips(NULL, &c))) {
+		f = 0;
+		while ((feature = sensors_get_features(chip, &f))) {
+			s = 0;
+			while ((sub = sensors_get_all_subfeatures(chip, feature,
+								   &s))) {
+				if (!(sub->flags & SENSORS_MODE_R))
+					continue;
+				if (n == max) {
+					max = max ? max * 2 : 256;
+					req = realloc(req, max * sizeof(*req));
+					if (!req)
+						fail("realloc", 0);
+				}
+				req[n].name = chip;
+				req[n].subfeat_nr = sub->number;
+				n++;
+			}
+		}
+	}
+
+	*count = n;
+	return req;
+}
+
+static void bench_init(const char *root, int iterations)
+{
+	long long *init, *cleanup, t;
+	FILE *config;
+	int i, err;
+
+	init = malloc(iterations * sizeof(long long));
+	cleanup = malloc(iterations * sizeof(long long));
+	if (!init || !cleanup || !(config = tmpfile()))
+		fail("alloc", 0);
+
+	/* The first initialization allocates everything for the first time.
+	   The tree was just written and nothing drops the kernel caches, so
+	   this is not a cold cache measurement. */
+	sensors_set_backend(SENSORS_BACKEND_DIR, root);
+	t = now_ns();
+	if ((err = sensors_init(config)))
+		fail("sensors_init", err);
+	t = now_ns() - t;
+	report("init_first", &t, 1, NULL);
+	sensors_cleanup();
+
+	for (i = 0; i < iterations; i++) {
+		rewind(config);
+		t = now_ns();
+		if ((err = sensors_init(config)))
+			fail("sensors_init", err);
+		init[i] = now_ns() - t;
+
+		t = now_ns();
+		sensors_cleanup();
+		cleanup[i] = now_ns() - t;
+	}
+	report("init_warm", init, iterations, NULL);
+	report("cleanup", cleanup, iterations, NULL);
+
+	/* Leave the library initialized for the read benchmarks */
+	rewind(config);
+	if ((err = sensors_init(config)))
+		fail("sensors_init", err);
+	fclose(config);
+
+	free(init);
+	free(cleanup);
+}
+
+static void bench_read(int iterations)
+{
+	sensors_value_request *req;
+	long long *calls, *scans, *batches, t, u;
+	char extra[128];
+	int count, i, j, err;
+	double value;
+
+	req = get_requests(&count);
+	if (!count)
+		fail("no readable subfeature", -SENSORS_ERR_NO_ENTRY);
+	calls = malloc((long)count * iterations * sizeof(long long));
+	scans = malloc(iterations * sizeof(long long));
+	batches = malloc(iterations * sizeof(long long));
+	if (!calls || !scans || !batches)
+		fail("malloc", 0);
+
+	/* Latency of single reads, and throughput of a full scan made of
+	   them */
+	for (i = 0; i < iterations; i++) {
+		u = now_ns();
+		for (j = 0; j < count; j++) {
+			t = now_ns();
+			err = sensors_get_value(req[j].name, req[j].subfeat_nr,
+						&value);
+			calls[i * count + j] = now_ns() - t;
+			if (err)
+				fail("sensors_get_value", err);
+		}
+		scans[i] = now_ns() - u;
+	}
+	report("get_value", calls, count * iterations, NULL);
+	qsort(scans, iterations, sizeof(long long), cmp_ll);
+	snprintf(extra, sizeof(extra), "\"values\": %d, "
+		 "\"values_per_s\": %.0f", count,
+		 count * 1e9 / scans[iterations / 2]);
+	report("scan", scans, iterations, extra);
+
+	/* Same with the parallel batch interface */
+	for (i = 0; i < iterations; i++) {
+		t = now_ns();
+		err = sensors_get_values(req, count);
+		batches[i] = now_ns() - t;
+		if (err < 0)
+			fail("sensors_get_values", err);
+	}
+	qsort(batches, iterations, sizeof(long long), cmp_ll);
+	snprintf(extra, sizeof(extra), "\"values\": %d, "
+		 "\"values_per_s\": %.0f", count,
+		 count * 1e9 / batches[iterations / 2]);
+	report("scan_batch", batches, iterations, extra);
+
+	sensors_cleanup();
+	free(req);
+	free(calls);
+	free(scans);
+	free(batches);
+}
+
+/* Configuration parsing time, for growing configuration files. The
+   memory backend with no chip keeps discovery out of the picture. */
+static void bench_config(const char *dir, int channels, int iterations)
+{
+	static const int sizes[] = { 1, 16, 256, 4096 };
+	char empty[PATH_MAX], conf[PATH_MAX], name[32], extra[128];
+	long long *samples, t;
+	struct stat st;
+	FILE *f;
+	unsigned int s;
+	int i, n, err;
+
+	errno = ENAMETOOLONG;
+	if (snprintf(empty, sizeof(empty), "%s/empty", dir) >=
+	    (int)sizeof(empty) ||
+	    snprintf(conf, sizeof(conf), "%s/sensors.conf", dir) >=
+	    (int)sizeof(conf))
+		fail(dir, 0);
+	if (!(f = fopen(empty, "w")) || fclose(f))
+		fail(empty, 0);
+	samples = malloc(iterations * sizeof(long long));
+	if (!samples)
+		fail("malloc", 0);
+	sensors_set_backend(SENSORS_BACKEND_MEMORY, empty);
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		if (hwmon_tree_write_config(conf, sizes[s], channels) ||
+		    stat(conf, &st))
+			fail(conf, 0);
+
+		/* Keep the largest sizes from taking forever */
+		n = sizes[s] > 256 ? (iterations + 9) / 10 : iterations;
+		for (i = 0; i < n; i++) {
+			if (!(f = fopen(conf, "r")))
+				fail(conf, 0);
+			t = now_ns();
+			err = sensors_init(f);
+			samples[i] = now_ns() - t;
+			fclose(f);
+			if (err)
+				fail("sensors_init", err);
+			sensors_cleanup();
+		}
+
+		snprintf(name, sizeof(name), "config_parse_%d", sizes[s]);
+		snprintf(extra, sizeof(extra), "\"chips\": %d, \"bytes\": %lld",
+			 sizes[s], (long long)st.st_size);
+		report(name, samples, n, extra);
+	}
+
+	unlink(conf);
+	unlink(empty);
+	free(samples);
+}
+
+static void print_help(const char *name)
+{
+	printf("Usage: %s [OPTION]...\n", name);
+	puts("  -c CHIPS      Number of chips in the synthetic tree (64)\n"
+	     "  -m CHANNELS   Number of channels of each type per chip (8)\n"
+	     "  -n COUNT      Number of iterations of each benchmark (20)\n"
+	     "  -d DIR        Create the tree in DIR and keep it\n"
+	     "  -h            Display this help text");
+}
+
+int main(int argc, char *argv[])
+{
+	int chips = 64, channels = 8, iterations = 20, c;
+	char tmp[PATH_MAX], root[PATH_MAX + 8];
+	const char *dir = NULL, *base;
+
+	while ((c = getopt(argc, argv, "c:m:n:d:h")) != -1) {
+		switch (c) {
+		case 'c':
+			chips = atoi(optarg);
+			break;
+		case 'm':
+			channels = atoi(optarg);
+			break;
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+		case 'd':
+			dir = optarg;
+			break;
+		case 'h':
+			print_help(argv[0]);
+			return 0;
+		default:
+			print_help(argv[0]);
+			return 1;
+		}
+	}
+	if (chips < 1 || channels < 1 || iterations < 1) {
+		fprintf(stderr, "Invalid argument\n");
+		return 1;
+	}
+
+	if (dir) {
+		if (mkdir(dir, 0755) && errno != EEXIST)
+			fail(dir, 0);
+		snprintf(tmp, sizeof(tmp), "%s", dir);
+	} else {
+		base = getenv("TMPDIR");
+		snprintf(tmp, sizeof(tmp), "%s/bench-libsensors.XXXXXX",
+			 base ? base : "/tmp");
+		if (!mkdtemp(tmp))
+			fail(tmp, 0);
+	}
+	snprintf(root, sizeof(root), "%s/sys", tmp);
+	if (hwmon_tree_create(root, chips, channels))
+		fail(root, 0);
+
+	printf("{\n  \"library\": \"%s\",\n  \"chips\": %d,\n"
+	       "  \"channels\": %d,\n  \"iterations\": %d,\n"
+	       "  \"results\": [", libsensors_version, chips, channels,
+	       iterations);
+	bench_init(root, iterations);
+	bench_read(iterations);
+	bench_config(tmp, channels, iterations);
+	printf("\n  ]\n}\n");
+
+	if (!dir) {
+		hwmon_tree_remove(root);
+		rmdir(tmp);
+	}
+	return 0;
+}
@@ -0,0 +1,52 @@
+/*
+    gen-hwmon-tree.c - Create a synthetic hwmon tree laid out like sysfs
+    Copyright (C) 2026  The lm-sensors developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "hwmon-tree.h"
+
+int main(int argc, char *argv[])
+{
+	int chips, channels;
+
+	if (argc < 4 || argc > 5) {
+		fprintf(stderr, "Usage: %s ROOT CHIPS CHANNELS [CONFIG]\n",
+			argv[0]);
+		return 1;
+	}
+	chips = atoi(argv[2]);
+	channels = atoi(argv[3]);
+	if (chips < 0 || channels < 1) {
+		fprintf(stderr, "Invalid chip or channel count\n");
+		return 1;
+	}
+
+	if (hwmon_tree_create(argv[1], chips, channels)) {
+		fprintf(stderr, "%s: %s\n", argv[1], strerror(errno));
+		return 1;
+	}
+	if (argc == 5 && hwmon_tree_write_config(argv[4], chips, channels)) {
+		fprintf(stderr, "%s: %s\n", argv[4], strerror(errno));
+		return 1;
+	}
+
+	return 0;
+}
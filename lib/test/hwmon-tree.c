@@ -0,0 +1,299 @@
+/*
+    hwmon-tree.c - Synthetic hwmon trees for libsensors tests and benchmarks
+    Copyright (C) 2026  The lm-sensors developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* this define needed for nftw() */
+#define _XOPEN_SOURCE 500
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include "hwmon-tree.h"
+
+/*
+ * Chips come in turns of three kinds:
+ *   lm90 on I2C bus k / 300, address 0x10 + k / 3 % 100
+ *   nct6775 on the platform bus, device nct6775.k, with labels
+ *   k10temp on PCI device 0000:bb:ss.3
+ */
+#define CHIP_I2C	0
+#define CHIP_PLATFORM	1
+#define CHIP_PCI	2
+
+static int write_file(mode_t mode, const char *fmt_value, long value,
+		      const char *fmt_path, ...)
+{
+	char path[PATH_MAX];
+	va_list ap;
+	FILE *f;
+
+	va_start(ap, fmt_path);
+	vsnprintf(path, sizeof(path), fmt_path, ap);
+	va_end(ap);
+
+	if (!(f = fopen(path, "w")))
+		return -1;
+	fprintf(f, fmt_value, value);
+	if (fclose(f))
+		return -1;
+	return chmod(path, mode);
+}
+
+static int write_text(mode_t mode, const char *text, const char *fmt_path, ...)
+{
+	char path[PATH_MAX];
+	va_list ap;
+	FILE *f;
+
+	va_start(ap, fmt_path);
+	vsnprintf(path, sizeof(path), fmt_path, ap);
+	va_end(ap);
+
+	if (!(f = fopen(path, "w")))
+		return -1;
+	fputs(text, f);
+	if (fclose(f))
+		return -1;
+	return chmod(path, mode);
+}
+
+static int make_dirs(const char *path)
+{
+	char buf[PATH_MAX], *p;
+
+	snprintf(buf, sizeof(buf), "%s", path);
+	for (p = buf + 1; *p; p++) {
+		if (*p != '/')
+			continue;
+		*p = '\0';
+		if (mkdir(buf, 0755) && access(buf, F_OK))
+			return -1;
+		*p = '/';
+	}
+	if (mkdir(buf, 0755) && access(buf, F_OK))
+		return -1;
+	return 0;
+}
+
+static int make_link(const char *target, const char *fmt_path, ...)
+{
+	char path[PATH_MAX];
+	va_list ap;
+
+	va_start(ap, fmt_path);
+	vsnprintf(path, sizeof(path), fmt_path, ap);
+	va_end(ap);
+
+	return symlink(target, path);
+}
+
+static void chip_device(const char *root, int k, char *dev, size_t size,
+			const char **subsys)
+{
+	int j = k / 3;
+
+	switch (k % 3) {
+	case CHIP_I2C:
+		snprintf(dev, size, "%s/devices/pci0000:00/i2c-%d/%d-%04x",
+			 root, j / 100, j / 100, 0x10 + j % 100);
+		*subsys = "i2c";
+		break;
+	case CHIP_PLATFORM:
+		snprintf(dev, size, "%s/devices/platform/nct6775.%d", root, k);
+		*subsys = "platform";
+		break;
+	default:
+		snprintf(dev, size, "%s/devices/pci0000:00/0000:%02x:%02x.3",
+			 root, j / 32 % 256, j % 32);
+		*subsys = "pci";
+	}
+}
+
+static const char *chip_prefix(int k)
+{
+	static const char *const prefix[] = {
+		"lm90\n", "nct6775\n", "k10temp\n"
+	};
+
+	return prefix[k % 3];
+}
+
+static int create_adapter(const char *root, int nr)
+{
+	char dir[PATH_MAX];
+
+	snprintf(dir, sizeof(dir), "%s/devices/pci0000:00/i2c-%d", root, nr);
+	if (make_dirs(dir) ||
+	    write_file(0444, "SMBus adapter %ld\n", nr, "%s/name", dir) ||
+	    make_link(dir, "%s/device", dir) ||
+	    make_link(dir, "%s/class/i2c-adapter/i2c-%d", root, nr))
+		return -1;
+	return 0;
+}
+
+static int create_chip(const char *root, int k, int channels)
+{
+	char dev[PATH_MAX], hw[PATH_MAX], target[PATH_MAX];
+	const char *subsys;
+	int i, labels = k % 3 == CHIP_PLATFORM;
+
+	if (k % 3 == CHIP_I2C && k / 3 % 100 == 0 &&
+	    create_adapter(root, k / 300))
+		return -1;
+
+	chip_device(root, k, dev, sizeof(dev), &subsys);
+	errno = ENAMETOOLONG;
+	if (snprintf(hw, sizeof(hw), "%s/hwmon/hwmon%d", dev, k) >=
+	    (int)sizeof(hw) ||
+	    snprintf(target, sizeof(target), "%s/bus/%s", root, subsys) >=
+	    (int)sizeof(target))
+		return -1;
+	if (make_dirs(hw) ||
+	    make_link(target, "%s/subsystem", dev) ||
+	    write_text(0644, "", "%s/uevent", dev) ||
+	    make_link(dev, "%s/device", hw) ||
+	    make_link(hw, "%s/class/hwmon/hwmon%d", root, k) ||
+	    write_text(0444, chip_prefix(k), "%s/name", hw) ||
+	    write_text(0644, "", "%s/uevent", hw))
+		return -1;
+
+	for (i = 1; i <= channels; i++) {
+		if (write_file(0444, "%ld\n", 30000 + 250 * ((k + i) % 64),
+			       "%s/temp%d_input", hw, i) ||
+		    write_file(0644, "%ld\n", 80000, "%s/temp%d_max", hw, i) ||
+		    write_file(0644, "%ld\n", 75000,
+			       "%s/temp%d_max_hyst", hw, i) ||
+		    write_file(0644, "%ld\n", 100000,
+			       "%s/temp%d_crit", hw, i) ||
+		    write_file(0444, "%ld\n", 0, "%s/temp%d_alarm", hw, i) ||
+		    write_file(0444, "%ld\n", 0,
+			       "%s/temp%d_crit_alarm", hw, i) ||
+		    (labels && write_file(0444, "SYSTIN%ld\n", i,
+					  "%s/temp%d_label", hw, i)))
+			return -1;
+
+		if (write_file(0444, "%ld\n", 1000 + 10 * ((k + i) % 100),
+			       "%s/in%d_input", hw, i - 1) ||
+		    write_file(0644, "%ld\n", 800, "%s/in%d_min", hw, i - 1) ||
+		    write_file(0644, "%ld\n", 2000, "%s/in%d_max", hw, i - 1) ||
+		    write_file(0444, "%ld\n", 0, "%s/in%d_alarm", hw, i - 1) ||
+		    (labels && write_file(0444, "VIN%ld\n", i - 1,
+					  "%s/in%d_label", hw, i - 1)))
+			return -1;
+
+		if (write_file(0444, "%ld\n", 1200 + 7 * ((k * 31 + i) % 200),
+			       "%s/fan%d_input", hw, i) ||
+		    write_file(0644, "%ld\n", 600, "%s/fan%d_min", hw, i) ||
+		    write_file(0444, "%ld\n", 0, "%s/fan%d_alarm", hw, i))
+			return -1;
+	}
+
+	return 0;
+}
+
+int hwmon_tree_create(const char *root, int chips, int channels)
+{
+	static const char *const dirs[] = {
+		"bus/i2c", "bus/platform", "bus/pci", "class/hwmon",
+		"class/i2c-adapter", "devices/platform", "devices/pci0000:00",
+	};
+	char path[PATH_MAX];
+	unsigned int i;
+	int k;
+
+	if (mkdir(root, 0755))
+		return -1;
+	for (i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+		snprintf(path, sizeof(path), "%s/%s", root, dirs[i]);
+		if (make_dirs(path))
+			return -1;
+	}
+
+	for (k = 0; k < chips; k++)
+		if (create_chip(root, k, channels))
+			return -1;
+
+	return 0;
+}
+
+static void chip_name(int k, char *name, size_t size)
+{
+	int j = k / 3;
+
+	switch (k % 3) {
+	case CHIP_I2C:
+		snprintf(name, size, "lm90-i2c-%d-%02x", j / 100, 0x10 + j % 100);
+		break;
+	case CHIP_PLATFORM:
+		snprintf(name, size, "nct6775-isa-%04x", k);
+		break;
+	default:
+		snprintf(name, size, "k10temp-pci-%04x",
+			 (j / 32 % 256) << 8 | (j % 32) << 3 | 3);
+	}
+}
+
+int hwmon_tree_write_config(const char *path, int chips, int channels)
+{
+	char name[64];
+	FILE *f;
+	int k, i;
+
+	if (!(f = fopen(path, "w")))
+		return -1;
+
+	for (k = 0; k < chips; k++) {
+		/* Chip statements of I2C chips need their bus declared */
+		if (k % 3 == CHIP_I2C && k / 3 % 100 == 0)
+			fprintf(f, "bus \"i2c-%d\" \"SMBus adapter %d\"\n\n",
+				k / 300, k / 300);
+		chip_name(k, name, sizeof(name));
+		fprintf(f, "chip \"%s\"\n", name);
+		for (i = 1; i <= channels; i++) {
+			fprintf(f, "    label temp%d \"Zone %d\"\n", i, i);
+			fprintf(f, "    set temp%d_max %d\n", i, 70 + i % 20);
+			fprintf(f, "    compute in%d @*(1+%d/10), @/(1+%d/10)\n",
+				i - 1, i % 10, i % 10);
+		}
+		fprintf(f, "    ignore fan%d\n\n", channels);
+	}
+
+	return fclose(f);
+}
+
+static int remove_entry(const char *path, const struct stat *st, int flag,
+			struct FTW *ftw)
+{
+	(void)st; /* hide warnings */
+	(void)flag;
+	(void)ftw;
+
+	return remove(path);
+}
+
+int hwmon_tree_remove(const char *root)
+{
+	return nftw(root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
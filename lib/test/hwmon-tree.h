@@ -0,0 +1,40 @@
+/*
+    hwmon-tree.h - Synthetic hwmon trees for libsensors tests and benchmarks
+    Copyright (C) 2026  The lm-sensors developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_TEST_HWMON_TREE_H
+#define LIB_TEST_HWMON_TREE_H
+
+/* Create a tree laid out like sysfs under root, which must be an absolute
+   path as links point into the tree, and must not exist yet. It has chips
+   hwmon class devices of channels temperature, voltage and fan channels
+   each. Chips are spread over I2C, platform and PCI devices, with their
+   device and subsystem links. Returns 0 on success, -1 on error with
+   errno set. */
+int hwmon_tree_create(const char *root, int chips, int channels);
+
+/* Write a configuration file for such a tree, with a chip statement of
+   label, compute, set and ignore lines for each of the chips first chips,
+   and bus statements for their I2C adapters.
+   Returns 0 on success, -1 on error with errno set. */
+int hwmon_tree_write_config(const char *path, int chips, int channels);
+
+/* Remove a tree created by hwmon_tree_create() */
+int hwmon_tree_remove(const char *root);
+
+#endif /* def LIB_TEST_HWMON_TREE_H */
@@ -0,0 +1,1326 @@
+/*
+    test-libsensors.c - Behavior tests of libsensors
+    Copyright (C) 2026  The lm-sensors developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* this define needed for mkdtemp() */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "../sensors.h"
+#include "../error.h"
+#include "hwmon-tree.h"
+
+/*
+ * Each test prints a line in the TAP format, "ok N - description" or
+ * "not ok N - description", and the program exits with status 1 if any
+ * test failed.
+ *
+ * The tests run in a temporary directory, which is the current directory.
+ * The library is built in, with its default configuration files, board
+ * database and DMI attributes looked up under test-etc, test-data and
+ * test-dmi there, so that the tests don't depend on the system they run
+ * on. Each test function starts over with the chips and configuration it
+ * uses, whatever the tests before it did.
+ */
+
+/* Chips for the memory backend, used unless a test needs others */
+static const char chips_desc[] =
+	"bus i2c-1 Test adapter\n"
+	"chip lm75-i2c-1-48\n"
+	"temp1_input 42000 rw\n"
+	"temp1_max 80000 rw\n"
+	"temp1_label Ambient\n"
+	"temp2_input 30000 rw\n"
+	"chip lm75-i2c-1-49\n"
+	"temp1_input 50000\n"
+	"temp2_input broken\n"
+	"chip dead-isa-0290\n"
+	"temp1_input broken\n"
+	"temp2_input broken\n";
+
+static char tmp[PATH_MAX];
+static int tests, failures;
+
+static void check(int ok, const char *desc)
+{
+	tests++;
+	if (!ok)
+		failures++;
+	printf("%sok %d - %s\n", ok ? "" : "not ", tests, desc);
+}
+
+static void fail(const char *what, int err)
+{
+	fprintf(stderr, "%s: %s\n", what, err < 0 ? sensors_strerror(err) :
+		strerror(errno));
+	exit(1);
+}
+
+static void write_file(const char *path, const char *text)
+{
+	FILE *f;
+
+	if (!(f = fopen(path, "w")) || fputs(text, f) < 0 || fclose(f))
+		fail(path, 0);
+}
+
+static void sleep_ms(int ms)
+{
+	struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+
+	nanosleep(&ts, NULL);
+}
+
+static long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static FILE *config_file(const char *text)
+{
+	FILE *f;
+
+	if (!(f = tmpfile()) || fputs(text, f) < 0)
+		fail("tmpfile", 0);
+	rewind(f);
+	return f;
+}
+
+/* Start over with the chips found by backend in source, and the
+   configuration config, or the default configuration files if NULL */
+static void setup_backend(int backend, const char *source, const char *config)
+{
+	FILE *f = NULL;
+	int err;
+
+	sensors_cleanup();
+	sensors_set_keep_open(0);
+	sensors_set_fault_policy(0, 0, 0);
+	if ((err = sensors_set_backend(backend, source)))
+		fail("sensors_set_backend", err);
+	if (config)
+		f = config_file(config);
+	err = sensors_init(f);
+	if (f)
+		fclose(f);
+	if (err)
+		fail("sensors_init", err);
+}
+
+/* Same with the chips of description desc on the memory backend */
+static void setup(const char *desc, const char *config)
+{
+	write_file("chips", desc);
+	setup_backend(SENSORS_BACKEND_MEMORY, "chips", config);
+}
+
+/* Same with a synthetic hwmon tree of chips chips, under tree in the
+   temporary directory */
+static void setup_tree(int chips, const char *config)
+{
+	char root[PATH_MAX + 8];
+
+	snprintf(root, sizeof(root), "%s/tree", tmp);
+	hwmon_tree_remove(root);
+	if (hwmon_tree_create(root, chips, 2))
+		fail(root, 0);
+	setup_backend(SENSORS_BACKEND_DIR, root, config);
+}
+
+/* Look up a detected chip by its exact name */
+static const sensors_chip_name *chip(const char *name)
+{
+	const sensors_chip_name *found;
+	sensors_chip_name match;
+	int nr = 0;
+
+	if (sensors_parse_chip_name(name, &match))
+		fail(name, -SENSORS_ERR_CHIP_NAME);
+	found = sensors_get_detected_chips(&match, &nr);
+	sensors_free_chip_name(&match);
+	if (!found)
+		fail(name, -SENSORS_ERR_NO_ENTRY);
+	return found;
+}
+
+/* Look up a subfeature by its name, such as "temp1_input" */
+static int subfeat(const sensors_chip_name *name, const char *sub)
+{
+	const sensors_subfeature *subfeature;
+	const sensors_feature *feature;
+	int nr = 0, i;
+
+	while ((feature = sensors_get_features(name, &nr))) {
+		i = 0;
+		while ((subfeature = sensors_get_all_subfeatures(name, feature,
+								 &i)))
+			if (!strcmp(subfeature->name, sub))
+				return subfeature->number;
+	}
+	fail(sub, -SENSORS_ERR_NO_ENTRY);
+	return -1;
+}
+
+static double value(const char *name, const char *sub, int *err)
+{
+	const sensors_chip_name *c = chip(name);
+	double val = 0;
+
+	*err = sensors_get_value(c, subfeat(c, sub), &val);
+	return val;
+}
+
+static void set(const char *name, const char *sub, double val)
+{
+	const sensors_chip_name *c = chip(name);
+	int err;
+
+	if ((err = sensors_set_value(c, subfeat(c, sub), val)))
+		fail(sub, err);
+}
+
+/* Read or write the raw value of an attribute file of a chip directly */
+static long attr(const char *name, const char *sub)
+{
+	char path[PATH_MAX];
+	long raw = 0;
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/%s", chip(name)->path, sub);
+	if (!(f = fopen(path, "r")) || fscanf(f, "%ld", &raw) != 1 || fclose(f))
+		fail(path, 0);
+	return raw;
+}
+
+static void set_attr(const char *name, const char *sub, long raw)
+{
+	char path[PATH_MAX], text[24];
+
+	snprintf(path, sizeof(path), "%s/%s", chip(name)->path, sub);
+	snprintf(text, sizeof(text), "%ld\n", raw);
+	write_file(path, text);
+}
+
+static void request(sensors_value_request *req, const char *name,
+		    const char *sub)
+{
+	req->name = chip(name);
+	req->subfeat_nr = subfeat(req->name, sub);
+}
+
+static char *label(const char *name, const char *feat)
+{
+	const sensors_chip_name *c = chip(name);
+	const sensors_feature *feature;
+	int nr = 0;
+
+	while ((feature = sensors_get_features(c, &nr)))
+		if (!strcmp(feature->name, feat))
+			return sensors_get_label(c, feature);
+	return NULL;
+}
+
+static void test_set_value(void)
+{
+	const char *lm90 = "lm90-i2c-0-10";
+	const sensors_chip_name *c;
+	sensors_set_request req[3];
+	int err1, err2, err;
+
+	setup_tree(1, "");
+	c = chip(lm90);
+
+	err1 = sensors_set_value_flags(c, subfeat(c, "temp1_max"), 70, 0);
+	set_attr(lm90, "temp1_max", 1000);
+	err2 = sensors_set_value_flags(c, subfeat(c, "temp1_max"), 70, 0);
+	check(!err1 && !err2 && attr(lm90, "temp1_max") == 1000,
+	      "set-value: a value already written is not written again");
+	err = sensors_set_value_flags(c, subfeat(c, "temp1_max"), 70,
+				      SENSORS_SET_FORCE);
+	check(!err && attr(lm90, "temp1_max") == 70000,
+	      "set-value: unless forced");
+	err = sensors_set_value_flags(c, subfeat(c, "temp1_max"), 9.5, 0);
+	check(!err && attr(lm90, "temp1_max") == 9500,
+	      "set-value: shorter values replace longer ones");
+
+	req[0].subfeat_nr = subfeat(c, "temp1_input");
+	req[0].value = 20;
+	req[1].subfeat_nr = subfeat(c, "temp1_max");
+	req[1].value = 71;
+	req[2].subfeat_nr = subfeat(c, "temp2_max");
+	req[2].value = 72;
+	err = sensors_set_values(c, req, 3, 0);
+	check(err == -SENSORS_ERR_ACCESS_W &&
+	      attr(lm90, "temp1_max") == 71000 &&
+	      attr(lm90, "temp2_max") == 72000,
+	      "set-value: a failed value doesn't stop the others");
+}
+
+static void test_batch(void)
+{
+	const sensors_chip_name *name;
+	sensors_value_request req[9];
+	char text[64];
+	int err, nr, i;
+
+	/* Chips on one I2C bus, the ISA bus and the PCI bus */
+	setup_tree(9, "");
+	for (nr = 0, i = 0; (name = sensors_get_detected_chips(NULL, &nr));
+	     i++) {
+		req[i].name = name;
+		req[i].subfeat_nr = subfeat(name, "temp1_input");
+	}
+	err = sensors_get_values(req, 9);
+	for (i = 0; i < 9 && !req[i].err; i++) {
+		sensors_snprintf_chip_name(text, sizeof(text), req[i].name);
+		if (req[i].value != attr(text, "temp1_input") / 1000.)
+			break;
+	}
+	check(!err && i == 9, "batch: values are read from all buses");
+
+	setup(chips_desc, "");
+	request(&req[0], "lm75-i2c-1-48", "temp1_input");
+	request(&req[1], "lm75-i2c-1-49", "temp1_input");
+	request(&req[2], "lm75-i2c-1-49", "temp2_input");
+	req[3].name = req[0].name;
+	req[3].subfeat_nr = 1000;
+
+	err = sensors_get_values(req, 4);
+	check(req[0].err == 0 && req[0].value == 42 &&
+	      req[1].err == 0 && req[1].value == 50,
+	      "batch: values are read from several chips");
+	check(req[2].err == -SENSORS_ERR_ACCESS_R &&
+	      req[3].err == -SENSORS_ERR_NO_ENTRY && err != 0,
+	      "batch: failed values don't affect the others");
+	check(sensors_get_values(req, -1) == 0,
+	      "batch: a negative count reads nothing");
+}
+
+static void test_deadline(void)
+{
+	const char *lm90 = "lm90-i2c-0-10";
+	const sensors_chip_name *c;
+	sensors_value_request req[2];
+	char path[PATH_MAX];
+	int err1, err2, err, fd, i;
+	double val;
+
+	/* A FIFO blocks readers until a writer shows up */
+	setup_tree(2, "");
+	c = chip(lm90);
+	snprintf(path, sizeof(path), "%s/temp1_input", c->path);
+	if (unlink(path) || mkfifo(path, 0644))
+		fail(path, 0);
+
+	err1 = sensors_get_value_timeout(c, subfeat(c, "temp1_input"), 100,
+					 &val);
+	err2 = sensors_get_value_timeout(c, subfeat(c, "temp1_input"), 60000,
+					 &val);
+	check(err1 == -SENSORS_ERR_TIMEOUT && err2 == -SENSORS_ERR_TIMEOUT,
+	      "deadline: reads from a stuck chip give up");
+
+	request(&req[0], lm90, "temp1_input");
+	request(&req[1], "nct6775-isa-0001", "temp1_input");
+	sensors_get_values_timeout(req, 2, 60000);
+	check(req[0].err == -SENSORS_ERR_TIMEOUT && !req[1].err &&
+	      req[1].value == attr("nct6775-isa-0001", "temp1_input") / 1000.,
+	      "deadline: other chips are still read");
+
+	/* Let the pending read complete, then wait for the chip to be read
+	   again */
+	if ((fd = open(path, O_WRONLY | O_NONBLOCK)) < 0 || close(fd) ||
+	    unlink(path))
+		fail(path, 0);
+	set_attr(lm90, "temp1_input", 45000);
+	for (i = 0; i < 500; i++) {
+		err = sensors_get_value_timeout(c, subfeat(c, "temp1_input"),
+						100, &val);
+		if (err != -SENSORS_ERR_TIMEOUT)
+			break;
+		sleep_ms(10);
+	}
+	check(!err && val == 45, "deadline: the chip recovers");
+}
+
+static void test_breaker(void)
+{
+	const char *lm90 = "lm90-i2c-0-10";
+	const sensors_chip_name *c;
+	sensors_fault_state state;
+	int err1, err2, err3, err;
+	char path[PATH_MAX];
+
+	setup(chips_desc, "");
+	sensors_set_fault_policy(2, 60000, 60000);
+
+	/* One dead value on a chip with a good one, which was read */
+	value("lm75-i2c-1-49", "temp1_input", &err);
+	value("lm75-i2c-1-49", "temp2_input", &err1);
+	value("lm75-i2c-1-49", "temp2_input", &err2);
+	value("lm75-i2c-1-49", "temp2_input", &err3);
+	check(!err && err1 == -SENSORS_ERR_ACCESS_R &&
+	      err2 == -SENSORS_ERR_ACCESS_R && err3 == -SENSORS_ERR_UNAVAILABLE,
+	      "breaker: a value failing over and over is skipped");
+	value("lm75-i2c-1-49", "temp1_input", &err);
+	c = chip("lm75-i2c-1-49");
+	check(!err && !sensors_get_fault_state(c, -1, &state) &&
+	      state.backoff_ms == 0,
+	      "breaker: a dead value doesn't stop the chip");
+
+	/* All values of the chip dead */
+	value("dead-isa-0290", "temp1_input", &err1);
+	value("dead-isa-0290", "temp2_input", &err2);
+	value("dead-isa-0290", "temp2_input", &err3);
+	c = chip("dead-isa-0290");
+	check(err3 == -SENSORS_ERR_UNAVAILABLE &&
+	      !sensors_get_fault_state(c, -1, &state) &&
+	      state.backoff_ms == 60000,
+	      "breaker: a chip with only dead values is skipped");
+
+	/* A value which comes back */
+	setup_tree(1, "");
+	sensors_set_fault_policy(1, 200, 1000);
+	c = chip(lm90);
+	snprintf(path, sizeof(path), "%s/temp1_input", c->path);
+	unlink(path);
+	value(lm90, "temp1_input", &err1);
+	value(lm90, "temp1_input", &err2);
+	sleep_ms(250);
+	value(lm90, "temp1_input", &err3);
+	sensors_get_fault_state(c, subfeat(c, "temp1_input"), &state);
+	check(err1 && err2 == -SENSORS_ERR_UNAVAILABLE && err3 &&
+	      err3 != -SENSORS_ERR_UNAVAILABLE && state.failures == 2 &&
+	      state.backoff_ms == 400,
+	      "breaker: the delay doubles when the value still fails");
+	set_attr(lm90, "temp1_input", 45000);
+	sleep_ms(450);
+	value(lm90, "temp1_input", &err);
+	sensors_get_fault_state(c, subfeat(c, "temp1_input"), &state);
+	check(!err && state.failures == 0 && state.backoff_ms == 0,
+	      "breaker: a successful read resets everything");
+}
+
+static void test_timestamps(void)
+{
+	sensors_value_request req[3];
+	sensors_timestamp ts[3], span, one;
+	long long before, after;
+	int err1, err2;
+	double val;
+
+	setup(chips_desc, "");
+	request(&req[0], "lm75-i2c-1-48", "temp1_input");
+	request(&req[1], "lm75-i2c-1-49", "temp2_input");
+	request(&req[2], "lm75-i2c-1-49", "temp1_input");
+
+	before = now_ns();
+	err1 = sensors_get_value_ts(req[0].name, req[0].subfeat_nr, &val,
+				    &one);
+	after = now_ns();
+	check(!err1 && before <= one.start && one.start <= one.end &&
+	      one.end <= after,
+	      "timestamps: a value is read between its timestamps");
+	memset(&one, 0xff, sizeof(one));
+	err2 = sensors_get_value_ts(req[1].name, req[1].subfeat_nr, &val,
+				    &one);
+	check(err2 && !one.start && !one.end,
+	      "timestamps: a value which failed has none");
+
+	memset(ts, 0xff, sizeof(ts));
+	before = now_ns();
+	sensors_get_values_ts(req, 3, ts, &span);
+	after = now_ns();
+	check(!req[0].err && !req[2].err && before <= span.start &&
+	      span.start <= ts[0].start && ts[0].start <= ts[0].end &&
+	      span.start <= ts[2].start && ts[2].start <= ts[2].end &&
+	      ts[0].end <= span.end && ts[2].end <= span.end &&
+	      span.end <= after &&
+	      (span.start == ts[0].start || span.start == ts[2].start) &&
+	      (span.end == ts[0].end || span.end == ts[2].end),
+	      "timestamps: the span covers all values read");
+	check(req[1].err && !ts[1].start && !ts[1].end,
+	      "timestamps: values which failed in a batch have none");
+}
+
+static void test_watch(void)
+{
+	const char *lm90 = "lm90-i2c-0-10";
+	const sensors_chip_name *c;
+	sensors_value_request req[2];
+	sensors_watch *watch;
+	char path[PATH_MAX];
+	int err, err2, n1, n2, fd, nr;
+
+	setup(chips_desc, "");
+	c = chip("lm75-i2c-1-48");
+	if (!(watch = sensors_watch_new()))
+		fail("sensors_watch_new", 0);
+	err = sensors_watch_add(watch, c, subfeat(c, "temp1_input"));
+	sensors_watch_free(watch);
+	check(err == -SENSORS_ERR_KERNEL,
+	      "watch: attributes which can't be polled are refused");
+
+	/* Regular files can't be polled, but a FIFO can, and it hangs up
+	   when its last writer goes away */
+	setup_tree(1, "");
+	c = chip(lm90);
+	nr = subfeat(c, "temp1_alarm");
+	snprintf(path, sizeof(path), "%s/temp1_alarm", c->path);
+	if (unlink(path) || mkfifo(path, 0644) ||
+	    (fd = open(path, O_RDWR | O_NONBLOCK)) < 0)
+		fail(path, 0);
+	if (!(watch = sensors_watch_new()))
+		fail("sensors_watch_new", 0);
+	err2 = sensors_watch_add(watch, c, subfeat(c, "temp2_alarm"));
+	err = sensors_watch_add(watch, c, nr);
+	n1 = sensors_watch_wait(watch, 0, req, 2);
+	close(fd);
+	n2 = sensors_watch_wait(watch, 60000, req, 2);
+	check(err2 == -SENSORS_ERR_KERNEL && !err &&
+	      sensors_watch_fd(watch) >= 0 && n1 == 0 && n2 == 1 &&
+	      req[0].name == c && req[0].subfeat_nr == nr,
+	      "watch: changed attributes are reported");
+	sensors_watch_free(watch);
+}
+
+static void test_subscribe(void)
+{
+	const char *lm75 = "lm75-i2c-1-48";
+	const sensors_chip_name *c;
+	sensors_subscription *sub;
+	sensors_value_request req[2];
+	int n1, n2, n3, n4;
+
+	setup(chips_desc, "");
+	c = chip(lm75);
+	if (!(sub = sensors_subscription_new(0)) ||
+	    sensors_subscribe(sub, c, subfeat(c, "temp1_input"), 1, 0) ||
+	    sensors_subscribe(sub, c, subfeat(c, "temp2_input"), 0.1,
+			      SENSORS_DEADBAND_RELATIVE))
+		fail("sensors_subscribe", 0);
+
+	n1 = sensors_subscription_poll(sub, req, 2);
+	n2 = sensors_subscription_poll(sub, req, 2);
+	check(n1 == 2 && n2 == 0,
+	      "subscribe: values are reported the first time only");
+
+	set(lm75, "temp1_input", 42.5);
+	set(lm75, "temp2_input", 32);
+	n1 = sensors_subscription_poll(sub, req, 2);
+	set(lm75, "temp1_input", 43.5);
+	set(lm75, "temp2_input", 33.5);
+	n2 = sensors_subscription_poll(sub, req, 2);
+	check(n1 == 0 && n2 == 2 && req[0].value == 43.5 &&
+	      req[1].value == 33.5,
+	      "subscribe: values are reported when out of their deadband");
+
+	set(lm75, "temp1_input", 50);
+	set(lm75, "temp2_input", 50);
+	n1 = sensors_subscription_poll(sub, req, 1);
+	n2 = req[0].subfeat_nr;
+	n3 = sensors_subscription_poll(sub, req, 1);
+	n4 = sensors_subscription_poll(sub, req, 1);
+	check(n1 == 1 && n3 == 1 && req[0].subfeat_nr != n2 && n4 == 0,
+	      "subscribe: values which don't fit are reported next time");
+	sensors_subscription_free(sub);
+}
+
+static void test_raw_value(void)
+{
+	const sensors_chip_name *c;
+	sensors_value_request req[3];
+	sensors_raw_value raw, raws[3];
+	double val;
+	int err;
+
+	setup(chips_desc,
+	      "bus \"i2c-1\" \"Test adapter\"\n"
+	      "chip \"lm75-i2c-1-48\"\n"
+	      "    compute temp2 @*2+1.25, (@-1.25)/2\n"
+	      "    compute temp1 @/3, @*3\n");
+	c = chip("lm75-i2c-1-49");
+	err = sensors_get_raw_value(c, subfeat(c, "temp1_input"), &raw);
+	check(!err && raw.value == 50000 && raw.exponent == -3 &&
+	      raw.unit == SENSORS_UNIT_CELSIUS,
+	      "raw-value: values are read as the kernel reports them");
+
+	c = chip("lm75-i2c-1-48");
+	err = sensors_get_raw_value(c, subfeat(c, "temp2_input"), &raw);
+	check(!err && raw.value == 61250 && raw.exponent == -3,
+	      "raw-value: linear compute statements are applied exactly");
+	err = sensors_get_raw_value(c, subfeat(c, "temp1_input"), &raw);
+	sensors_get_value(c, subfeat(c, "temp1_input"), &val);
+	check(!err && raw.exponent == -3 && raw.value == 14000 && val == 14,
+	      "raw-value: other compute statements are rounded");
+
+	request(&req[0], "lm75-i2c-1-48", "temp2_input");
+	request(&req[1], "lm75-i2c-1-49", "temp2_input");
+	request(&req[2], "lm75-i2c-1-49", "temp1_input");
+	sensors_get_raw_values(req, 3, raws);
+	check(!req[0].err && raws[0].value == 61250 && req[1].err &&
+	      !req[2].err && raws[2].value == 50000,
+	      "raw-value: values are read in batches");
+}
+
+static void quiet_parse_error(const char *err, const char *filename,
+			      int lineno)
+{
+	(void)err;
+	(void)filename;
+	(void)lineno;
+}
+
+static void test_memory(void)
+{
+	void (*parse_error)(const char *, const char *, int);
+	char root[PATH_MAX + 256], *text;
+	int err1, err2;
+
+	setup("bus i2c-1 Test adapter\n"
+	      "chip lm75-i2c-1-48\n"
+	      "temp1_input 42000 # Comment\n"
+	      "temp1_max 80000 wo\n"
+	      "temp1_label Ambient air\n",
+	      "");
+	value("lm75-i2c-1-48", "temp1_max", &err1);
+	err2 = sensors_set_value(chip("lm75-i2c-1-48"),
+				 subfeat(chip("lm75-i2c-1-48"), "temp1_input"),
+				 40);
+	check(err1 == -SENSORS_ERR_ACCESS_R && err2 == -SENSORS_ERR_ACCESS_W,
+	      "memory: attributes have the given modes");
+	text = label("lm75-i2c-1-48", "temp1");
+	check(text && !strcmp(text, "Ambient air"),
+	      "memory: text attributes are read");
+	free(text);
+
+	/* Failed discoveries */
+	parse_error = sensors_parse_error_wfn;
+	sensors_parse_error_wfn = quiet_parse_error;
+	sensors_cleanup();
+	write_file("chips", "chip lm75-i2c-1-48\n"
+		   "temp1_input 42000\n"
+		   "temp1_input 43000\n");
+	sensors_set_backend(SENSORS_BACKEND_MEMORY, "chips");
+	err1 = sensors_init(NULL);
+	/* A root which exists, but is too long for attribute paths */
+	snprintf(root, sizeof(root), "%s/%0250d", tmp, 0);
+	if (mkdir(root, 0755))
+		fail(root, 0);
+	strcat(root, "/long");
+	if (mkdir(root, 0755))
+		fail(root, 0);
+	sensors_set_backend(SENSORS_BACKEND_DIR, root);
+	err2 = sensors_init(NULL);
+	*strrchr(root, '/') = '\0';
+	hwmon_tree_remove(root);
+	sensors_parse_error_wfn = parse_error;
+	check(err1 == -SENSORS_ERR_PARSE && err2 == -SENSORS_ERR_KERNEL,
+	      "memory: bad descriptions and roots are refused");
+}
+
+static void test_trace(void)
+{
+	const char *lm75 = "lm75-i2c-1-48";
+	const sensors_chip_name *c;
+	double v1, v2, v3, v4;
+	int err1, err2, err3, err4, err;
+	sensors_watch *watch;
+	char path[PATH_MAX];
+	int fd;
+
+	sensors_set_trace("trace");
+	setup(chips_desc, "");
+	v1 = value(lm75, "temp1_input", &err1);
+	set(lm75, "temp1_input", 43);
+	v2 = value(lm75, "temp1_input", &err2);
+	value("lm75-i2c-1-49", "temp2_input", &err3);
+	sensors_cleanup();
+	sensors_set_trace(NULL);
+	check(!err1 && !err2 && err3 && v1 == 42 && v2 == 43,
+	      "trace: reads are recorded");
+
+	sensors_set_replay_speed(0);
+	setup_backend(SENSORS_BACKEND_REPLAY, "trace", "");
+	v1 = value(lm75, "temp1_input", &err1);
+	v2 = value(lm75, "temp1_input", &err2);
+	v3 = value(lm75, "temp1_input", &err3);
+	v4 = value("lm75-i2c-1-49", "temp2_input", &err4);
+	check(!err1 && !err2 && !err3 && v1 == 42 && v2 == 43 && v3 == 43 &&
+	      err4 == -SENSORS_ERR_ACCESS_R && v4 == 0,
+	      "trace: reads are replayed in order");
+	unlink("trace");
+
+	/* Recording doesn't keep attributes from being polled */
+	sensors_set_trace("trace");
+	setup_tree(1, "");
+	c = chip("lm90-i2c-0-10");
+	snprintf(path, sizeof(path), "%s/temp1_alarm", c->path);
+	if (unlink(path) || mkfifo(path, 0644) ||
+	    (fd = open(path, O_RDWR | O_NONBLOCK)) < 0)
+		fail(path, 0);
+	if (!(watch = sensors_watch_new()))
+		fail("sensors_watch_new", 0);
+	err = sensors_watch_add(watch, c, subfeat(c, "temp1_alarm"));
+	sensors_watch_free(watch);
+	close(fd);
+	sensors_cleanup();
+	sensors_set_trace(NULL);
+	check(!err, "trace: recorded attributes can be watched");
+	unlink("trace");
+}
+
+static void test_hwmon_tree(void)
+{
+	const sensors_chip_name *name;
+	char root[PATH_MAX + 8], *text;
+	int nr = 0, chips = 0, bad = 0;
+	double val;
+
+	snprintf(root, sizeof(root), "%s/tree", tmp);
+	hwmon_tree_remove(root);
+	if (hwmon_tree_create(root, 6, 2) || mkdir("test-etc", 0755) ||
+	    hwmon_tree_write_config("test-etc/sensors3.conf", 6, 2))
+		fail(root, 0);
+	setup_backend(SENSORS_BACKEND_DIR, root, NULL);
+	while ((name = sensors_get_detected_chips(NULL, &nr))) {
+		chips++;
+		if (sensors_get_value(name, subfeat(name, "temp1_input"),
+				      &val) || val < 30 || val > 46)
+			bad++;
+	}
+	check(chips == 6 && !bad,
+	      "hwmon-tree: the chips of a generated tree are read");
+	text = label("nct6775-isa-0001", "temp2");
+	check(text && !strcmp(text, "Zone 2"),
+	      "hwmon-tree: the generated configuration applies");
+	free(text);
+
+	sensors_cleanup();
+	hwmon_tree_remove(root);
+	hwmon_tree_remove("test-etc");
+}
+
+static void test_stats(void)
+{
+	sensors_stats before, after, chip1, chip2;
+	unsigned long long latency;
+	int err, i;
+
+	setup(chips_desc,
+	      "bus \"i2c-1\" \"Test adapter\"\n"
+	      "chip \"lm75-i2c-1-48\"\n"
+	      "    compute temp1 @*2, @/2\n");
+	before.version = after.version = SENSORS_STATS_VERSION;
+	chip1.version = chip2.version = SENSORS_STATS_VERSION;
+	sensors_get_stats(NULL, &before);
+	value("lm75-i2c-1-48", "temp1_input", &err);
+	value("lm75-i2c-1-48", "temp1_input", &err);
+	value("lm75-i2c-1-49", "temp2_input", &err);
+	set("lm75-i2c-1-48", "temp1_max", 40);
+	sensors_get_stats(NULL, &after);
+	sensors_get_stats(chip("lm75-i2c-1-48"), &chip1);
+	sensors_get_stats(chip("lm75-i2c-1-49"), &chip2);
+
+	for (latency = 0, i = 0; i < SENSORS_STATS_LATENCY_BUCKETS; i++)
+		latency += chip1.read_latency[i];
+	check(chip1.values_read == 2 && latency == 2 &&
+	      chip1.values_written == 1 && chip1.evals == 3 &&
+	      chip2.values_read == 1 &&
+	      chip2.read_errors[SENSORS_ERR_ACCESS_R] == 1,
+	      "stats: reads and writes are counted per chip");
+	check(after.values_read - before.values_read == 3 &&
+	      after.values_written - before.values_written == 1 &&
+	      after.read_errors[SENSORS_ERR_ACCESS_R] -
+	      before.read_errors[SENSORS_ERR_ACCESS_R] == 1,
+	      "stats: and for the whole library");
+	check(chip1.discovery_ns > 0 && chip2.discovery_ns > 0 &&
+	      after.discovery_ns > 0 && after.config_ns > 0,
+	      "stats: discovery and configuration are timed");
+
+	before.version = 0;
+	after.version = SENSORS_STATS_VERSION + 1;
+	check(sensors_get_stats(NULL, &before) == -SENSORS_ERR_NO_ENTRY &&
+	      sensors_get_stats(NULL, &after) == -SENSORS_ERR_NO_ENTRY,
+	      "stats: unknown versions are refused");
+}
+
+static void test_budget(void)
+{
+	sensors_value_request req[2];
+	sensors_timestamp ts[2];
+
+	setup(chips_desc, "");
+	request(&req[0], "lm75-i2c-1-48", "temp1_input");
+	request(&req[1], "lm75-i2c-1-48", "temp2_input");
+
+	/* Values never read are always read */
+	sensors_get_values_budget(req, 2, 0, ts);
+	check(req[0].err == 0 && req[0].value == 42 &&
+	      req[1].err == 0 && req[1].value == 30,
+	      "budget: values never read are read");
+
+	/* With no budget, only the most urgent value is read */
+	set("lm75-i2c-1-48", "temp1_input", 43);
+	set("lm75-i2c-1-48", "temp2_input", 32);
+	sensors_set_read_priority(req[1].name, req[1].subfeat_nr, 100);
+	sensors_get_values_budget(req, 2, 0, ts);
+	check(req[0].value == 42 && req[1].value == 32 &&
+	      ts[0].end < ts[1].start,
+	      "budget: the others are served from the cache");
+
+	/* With enough budget, all values are read */
+	sensors_get_values_budget(req, 2, 1000000, ts);
+	check(req[0].value == 43 && req[1].value == 32,
+	      "budget: all values are read when the budget allows");
+
+	check(sensors_get_values_budget(req, -1, 0, ts) == 0,
+	      "budget: a negative count reads nothing");
+}
+
+static void test_discover(void)
+{
+	void (*parse_error)(const char *, const char *, int);
+	const sensors_chip_name *name;
+	char *text1, *text2;
+	FILE *config;
+	int err, nr = 0;
+
+	sensors_cleanup();
+	write_file("chips", chips_desc);
+	sensors_set_backend(SENSORS_BACKEND_MEMORY, "chips");
+	err = sensors_discover();
+	text1 = label("lm75-i2c-1-48", "temp2");
+	check(!err && text1 && !strcmp(text1, "temp2"),
+	      "discover: chips are detected without a configuration");
+	free(text1);
+
+	config = config_file("chip \"lm75-*\"\n"
+			     "    label temp2 \"First\"\n");
+	err = sensors_load_config(config);
+	fclose(config);
+	config = config_file("chip \"lm75-*\"\n"
+			     "    label temp1 \"Second\"\n");
+	err |= sensors_load_config(config);
+	fclose(config);
+	text1 = label("lm75-i2c-1-48", "temp1");
+	text2 = label("lm75-i2c-1-48", "temp2");
+	check(!err && text1 && !strcmp(text1, "Second") &&
+	      text2 && !strcmp(text2, "First"),
+	      "discover: configurations are loaded on top of each other");
+	free(text1);
+	free(text2);
+
+	err = sensors_discover();
+	text1 = label("lm75-i2c-1-48", "temp2");
+	check(!err && text1 && !strcmp(text1, "First"),
+	      "discover: the configuration applies to chips detected again");
+	free(text1);
+
+	parse_error = sensors_parse_error_wfn;
+	sensors_parse_error_wfn = quiet_parse_error;
+	write_file("chips", "temp1_input 42000\n");
+	err = sensors_discover();
+	sensors_parse_error_wfn = parse_error;
+	name = sensors_get_detected_chips(NULL, &nr);
+	check(err && !name, "discover: no chip is left after a failure");
+}
+
+/* Check the label of a feature */
+static int has_label(const char *name, const char *feat, const char *text)
+{
+	char *l = label(name, feat);
+	int ok = l && !strcmp(l, text);
+
+	free(l);
+	return ok;
+}
+
+/* Rewrite a file with text of the same size, and make it look the same */
+static void rewrite_same(const char *path, const char *text)
+{
+	struct timespec times[2];
+	struct stat st;
+
+	if (stat(path, &st))
+		fail(path, 0);
+	write_file(path, text);
+	times[0] = st.st_atim;
+	times[1] = st.st_mtim;
+	if (utimensat(AT_FDCWD, path, times, 0))
+		fail(path, 0);
+}
+
+static void test_reload(void)
+{
+	void (*parse_error)(const char *, const char *, int);
+	const char *lm75 = "lm75-i2c-1-48";
+	int err;
+
+	if (mkdir("test-etc", 0755) || mkdir("test-etc/sensors.d", 0755))
+		fail("test-etc", 0);
+	write_file("test-etc/sensors3.conf",
+		   "chip \"lm75-*\"\n    label temp1 \"Main\"\n");
+	write_file("test-etc/sensors.d/a",
+		   "chip \"lm75-*\"\n    label temp2 \"A1\"\n");
+	write_file("test-etc/sensors.d/b",
+		   "chip \"dead-*\"\n    label temp1 \"B1\"\n");
+	setup(chips_desc, NULL);
+	check(has_label(lm75, "temp1", "Main") &&
+	      has_label(lm75, "temp2", "A1") &&
+	      has_label("dead-isa-0290", "temp1", "B1"),
+	      "reload: the default configuration files are loaded");
+
+	/* A file which looks the same isn't parsed again */
+	rewrite_same("test-etc/sensors.d/a",
+		     "chip \"lm75-*\"\n    label temp2 \"A2\"\n");
+	write_file("test-etc/sensors.d/b",
+		   "chip \"dead-*\"\n    label temp1 \"B22\"\n");
+	err = sensors_reload_config(NULL);
+	check(!err && has_label(lm75, "temp1", "Main") &&
+	      has_label(lm75, "temp2", "A1") &&
+	      has_label("dead-isa-0290", "temp1", "B22"),
+	      "reload: only files which changed are parsed again");
+
+	/* A bus which isn't declared makes the new configuration fail */
+	parse_error = sensors_parse_error_wfn;
+	sensors_parse_error_wfn = quiet_parse_error;
+	write_file("test-etc/sensors.d/b",
+		   "chip \"lm75-i2c-7-*\"\n    label temp1 \"B3\"\n");
+	err = sensors_reload_config(NULL);
+	sensors_parse_error_wfn = parse_error;
+	check(err && has_label("dead-isa-0290", "temp1", "B22"),
+	      "reload: the configuration is kept when the new one fails");
+
+	sensors_cleanup();
+	hwmon_tree_remove("test-etc");
+}
+
+static void test_image(void)
+{
+	const char *lm75 = "lm75-i2c-1-48";
+	char magic[8];
+	FILE *f;
+	int err, ok;
+
+	if (mkdir("test-etc", 0755) || mkdir("test-etc/sensors.d", 0755))
+		fail("test-etc", 0);
+	write_file("test-etc/sensors3.conf",
+		   "chip \"lm75-*\"\n    label temp1 \"Main\"\n");
+	write_file("test-etc/sensors.d/a",
+		   "chip \"lm75-*\"\n    label temp2 \"A1\"\n");
+
+	setup(chips_desc, "chip \"lm75-*\"\n    label temp2 \"Before\"\n");
+	err = sensors_compile_config(NULL);
+	ok = (f = fopen("test-etc/sensors3.conf.bin", "r")) &&
+	     fread(magic, sizeof(magic), 1, f) == 1 && !fclose(f) &&
+	     !memcmp(magic, "SENSCONF", sizeof(magic));
+	check(!err && ok && has_label(lm75, "temp2", "Before"),
+	      "image: compiling leaves the loaded configuration alone");
+
+	/* The image is used as long as the files look the same */
+	rewrite_same("test-etc/sensors.d/a",
+		     "chip \"lm75-*\"\n    label temp2 \"A2\"\n");
+	setup(chips_desc, NULL);
+	check(has_label(lm75, "temp1", "Main") &&
+	      has_label(lm75, "temp2", "A1"),
+	      "image: the default configuration is loaded from the image");
+
+	write_file("test-etc/sensors.d/a",
+		   "chip \"lm75-*\"\n    label temp2 \"A33\"\n");
+	setup(chips_desc, NULL);
+	check(has_label(lm75, "temp1", "Main") &&
+	      has_label(lm75, "temp2", "A33"),
+	      "image: files which changed since are parsed instead");
+
+	sensors_cleanup();
+	hwmon_tree_remove("test-etc");
+}
+
+static void test_boards(void)
+{
+	const char *lm75 = "lm75-i2c-1-48";
+	int err;
+
+	if (mkdir("boards", 0755) || mkdir("boards/Acme", 0755) ||
+	    mkdir("test-data", 0755) || mkdir("test-data/lm-sensors", 0755) ||
+	    mkdir("test-etc", 0755) || mkdir("test-etc/sensors.d", 0755) ||
+	    mkdir("test-dmi", 0755))
+		fail("boards", 0);
+	write_file("boards/Acme/X100.conf",
+		   "chip \"lm75-*\"\n"
+		   "    label temp1 \"X100\"\n"
+		   "    label temp2 \"X100\"\n");
+	write_file("boards/other.conf",
+		   "# dmi: board_vendor: Other Inc.\n"
+		   "# dmi: board_name: Q7\n"
+		   "# dmi: board_name: Q8\n"
+		   "chip \"lm75-*\"\n"
+		   "    label temp1 \"Q7\"\n");
+	write_file("test-etc/sensors3.conf",
+		   "chip \"lm75-*\"\n    label temp1 \"Main\"\n");
+	write_file("test-etc/sensors.d/a",
+		   "chip \"lm75-*\"\n    label temp2 \"Local\"\n");
+	write_file("test-dmi/board_vendor", "ACME\n");
+	write_file("test-dmi/board_name", "X-100\n");
+
+	setup(chips_desc, "");
+	err = sensors_compile_boards("boards", NULL);
+	check(!err && !access("test-data/lm-sensors/boards.bin", R_OK),
+	      "boards: the database is compiled");
+
+	sensors_set_board_config(1, NULL);
+	setup(chips_desc, NULL);
+	check(has_label(lm75, "temp1", "X100") &&
+	      has_label(lm75, "temp2", "Local"),
+	      "boards: the board overrides the main file, not sensors.d");
+
+	write_file("test-dmi/board_vendor", "Other Inc.\n");
+	write_file("test-dmi/board_name", "Q8\n");
+	setup(chips_desc, NULL);
+	check(has_label(lm75, "temp1", "Q7"),
+	      "boards: boards can be named in the files");
+
+	write_file("test-dmi/board_name", "Q9\n");
+	setup(chips_desc, NULL);
+	check(has_label(lm75, "temp1", "Main"),
+	      "boards: unknown boards get the default configuration");
+
+	sensors_set_board_config(0, NULL);
+	sensors_cleanup();
+	hwmon_tree_remove("boards");
+	hwmon_tree_remove("test-data");
+	hwmon_tree_remove("test-etc");
+	hwmon_tree_remove("test-dmi");
+}
+
+/* A configuration of exactly size bytes, padded with comments, which ends
+   with a label statement without a newline */
+static char *padded_config(size_t size, const char *text)
+{
+	const char *tail = "chip \"lm75-*\"\n    label temp1 \"";
+	size_t len = strlen(tail) + strlen(text) + 1, i;
+	char *config;
+
+	if (!(config = malloc(size + 1)))
+		fail("malloc", 0);
+	memset(config, '#', size - len);
+	for (i = 79; i < size - len; i += 80)
+		config[i] = '\n';
+	config[size - len - 1] = '\n';
+	sprintf(config + size - len, "%s%s\"", tail, text);
+	return config;
+}
+
+static void test_scanner(void)
+{
+	const char *lm75 = "lm75-i2c-1-48";
+	static const size_t sizes[] = { 4096, 256 * 1024 - 1, 256 * 1024,
+					300 * 1024 };
+	char *config, text[16];
+	unsigned int i, ok = 0;
+
+	if (mkdir("test-etc", 0755))
+		fail("test-etc", 0);
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		snprintf(text, sizeof(text), "%u", (unsigned int)sizes[i]);
+		config = padded_config(sizes[i], text);
+		setup(chips_desc, config);
+		ok += has_label(lm75, "temp1", text);
+		write_file("test-etc/sensors3.conf", config);
+		setup(chips_desc, NULL);
+		ok += has_label(lm75, "temp1", text);
+		free(config);
+	}
+	check(ok == 2 * i,
+	      "scanner: small and large configurations are read to the end");
+
+	sensors_cleanup();
+	hwmon_tree_remove("test-etc");
+}
+
+static void test_parse_dir(void)
+{
+	const char *lm75 = "lm75-i2c-1-48";
+	char path[64], text[64];
+	int i, ok;
+
+	if (mkdir("test-etc", 0755) || mkdir("test-etc/sensors.d", 0755))
+		fail("test-etc", 0);
+	for (i = 0; i < 20; i++) {
+		snprintf(path, sizeof(path), "test-etc/sensors.d/%02d", i);
+		snprintf(text, sizeof(text),
+			 "chip \"lm75-*\"\n    label temp%d \"File %d\"\n",
+			 i % 2 + 1, i);
+		write_file(path, text);
+	}
+	setup(chips_desc, NULL);
+	ok = has_label(lm75, "temp1", "File 18") &&
+	     has_label(lm75, "temp2", "File 19");
+	check(ok, "parse-dir: files are applied in order");
+
+	sensors_cleanup();
+	hwmon_tree_remove("test-etc");
+}
+
+static void test_expressions(void)
+{
+	const char *lm75 = "lm75-i2c-1-48";
+	double in[5] = { -10, 0, 20, 50, 100 }, out[5], v1, v2, v3;
+	const sensors_chip_name *c;
+	int err1, err2, err3, err;
+
+	setup(chips_desc,
+	      "bus \"i2c-1\" \"Test adapter\"\n"
+	      "chip \"lm75-i2c-1-48\"\n"
+	      "    compute temp1 clamp(@, 0, 40), @\n"
+	      "    compute temp2 (@ < 35) * 100 + (@ != 30) +"
+	      " (@ >= 30) * 10, @\n"
+	      "chip \"lm75-i2c-1-49\"\n"
+	      "    compute temp1 @ > 45 ? max(abs(@ - 60), 3, 1) +"
+	      " poly(2, 1, 1, 1) : -1, @\n");
+	v1 = value(lm75, "temp1_input", &err1);
+	v2 = value(lm75, "temp2_input", &err2);
+	v3 = value("lm75-i2c-1-49", "temp1_input", &err3);
+	check(!err1 && !err2 && !err3 && v1 == 40 && v2 == 110 && v3 == 17,
+	      "expressions: functions, comparisons and conditionals");
+
+	c = chip(lm75);
+	err = sensors_compute_values(c, subfeat(c, "temp1_input"), in, out, 5);
+	check(!err && out[0] == 0 && out[1] == 0 && out[2] == 20 &&
+	      out[3] == 40 && out[4] == 40,
+	      "expressions: values are computed in batches");
+	err = sensors_compute_values(c, subfeat(c, "temp1_input"), in, in, 5);
+	check(!err && !memcmp(in, out, sizeof(out)),
+	      "expressions: values are computed in place");
+}
+
+static void test_virtual(void)
+{
+	const char *hot = "hot-virtual-0";
+	const sensors_chip_name *c;
+	sensors_watch *watch;
+	double v1, v2, v3;
+	int err1, err2, err3, err;
+
+	setup(chips_desc,
+	      "virtual hot\n"
+	      "    define temp1_input max(\"lm75-*:temp1_input\")\n"
+	      "    define temp2_input avg(\"lm75-*:temp1_input\")\n");
+	v1 = value(hot, "temp1_input", &err1);
+	v2 = value(hot, "temp2_input", &err2);
+	set("lm75-i2c-1-48", "temp1_input", 60);
+	v3 = value(hot, "temp1_input", &err3);
+	check(!err1 && !err2 && !err3 && v1 == 50 && v2 == 46 && v3 == 60,
+	      "virtual: values are computed from others");
+
+	/* Even on a backend whose attributes can be polled */
+	setup_tree(1, "virtual hot\n"
+		   "    define temp1_input max(\"lm90-*:temp1_input\")\n");
+	c = chip(hot);
+	if (!(watch = sensors_watch_new()))
+		fail("sensors_watch_new", 0);
+	err = sensors_watch_add(watch, c, subfeat(c, "temp1_input"));
+	sensors_watch_free(watch);
+	check(err == -SENSORS_ERR_KERNEL, "virtual: values can't be watched");
+}
+
+/* Check that power matches uj microjoules spent between two reads, the
+   first one made between t[0] and t[1], the second one between t[2] and
+   t[3] */
+static int power_ok(double power, long long uj, const long long *t)
+{
+	return power >= uj * 1e3 / (t[3] - t[0]) &&
+	       power <= uj * 1e3 / (t[2] - t[1]);
+}
+
+static void test_energy(void)
+{
+	const char *meter = "meter-isa-0300";
+	long long t[4];
+	double power1, power2;
+	int err1, err2, err3;
+
+	sensors_set_energy_power(1);
+	setup("chip meter-isa-0300\n"
+	      "energy1_input 1000000 rw\n"
+	      "chip wrap-isa-0310\n"
+	      "energy1_input 4294967000 rw\n"
+	      "chip reset-isa-0320\n"
+	      "energy1_input 5000000000 rw\n", "");
+
+	t[0] = now_ns();
+	value(meter, "energy1_power", &err1);
+	t[1] = now_ns();
+	sleep_ms(100);
+	set(meter, "energy1_input", 3);
+	t[2] = now_ns();
+	power1 = value(meter, "energy1_power", &err2);
+	t[3] = now_ns();
+	check(err1 == -SENSORS_ERR_UNAVAILABLE && !err2 &&
+	      power_ok(power1, 2000000, t),
+	      "energy: power is derived from the counter");
+
+	/* The counter went down, but fits in 32 bits */
+	t[0] = now_ns();
+	value("wrap-isa-0310", "energy1_power", &err1);
+	t[1] = now_ns();
+	sleep_ms(100);
+	set("wrap-isa-0310", "energy1_input", 0.000704);
+	t[2] = now_ns();
+	power2 = value("wrap-isa-0310", "energy1_power", &err2);
+	t[3] = now_ns();
+	check(err1 == -SENSORS_ERR_UNAVAILABLE && !err2 &&
+	      power_ok(power2, 1000, t),
+	      "energy: 32-bit counters wrap around");
+
+	/* The counter went down from beyond 32 bits */
+	value("reset-isa-0320", "energy1_power", &err1);
+	set("reset-isa-0320", "energy1_input", 1);
+	value("reset-isa-0320", "energy1_power", &err2);
+	set("reset-isa-0320", "energy1_input", 2);
+	value("reset-isa-0320", "energy1_power", &err3);
+	check(err1 == -SENSORS_ERR_UNAVAILABLE &&
+	      err2 == -SENSORS_ERR_UNAVAILABLE && !err3,
+	      "energy: other decreases are resets, left out");
+
+	sensors_set_energy_power(0);
+}
+
+/* Read all readable values of all chips, and return how many failed */
+static int read_all(int *count)
+{
+	const sensors_subfeature *sub;
+	const sensors_feature *feature;
+	const sensors_chip_name *name;
+	int nr = 0, i, j, bad = 0;
+	double val;
+
+	*count = 0;
+	while ((name = sensors_get_detected_chips(NULL, &nr))) {
+		i = 0;
+		while ((feature = sensors_get_features(name, &i))) {
+			j = 0;
+			while ((sub = sensors_get_all_subfeatures(name, feature,
+								  &j))) {
+				if (!(sub->flags & SENSORS_MODE_R))
+					continue;
+				(*count)++;
+				if (sensors_get_value(name, sub->number, &val))
+					bad++;
+			}
+		}
+	}
+	return bad;
+}
+
+static void test_keep_open(void)
+{
+	const char *lm90 = "lm90-i2c-0-10";
+	sensors_stats before, after;
+	struct rlimit limit, low;
+	int err1, err2, bad1, bad2, count;
+	double v1, v2;
+
+	setup_tree(1, "");
+	sensors_set_keep_open(1);
+	v1 = value(lm90, "temp1_input", &err1);
+	set_attr(lm90, "temp1_input", 31000);
+	v2 = value(lm90, "temp1_input", &err2);
+	check(!err1 && !err2 && v1 == 30.25 && v2 == 31,
+	      "keep-open: values read again are up to date");
+
+	/* More values than file descriptors */
+	if (getrlimit(RLIMIT_NOFILE, &limit))
+		fail("getrlimit", 0);
+	low = limit;
+	low.rlim_cur = 64;
+	if (setrlimit(RLIMIT_NOFILE, &low))
+		fail("setrlimit", 0);
+	setup_tree(6, "");
+	sensors_set_keep_open(1);
+	before.version = after.version = SENSORS_STATS_VERSION;
+	bad1 = read_all(&count);
+	sensors_get_stats(NULL, &before);
+	bad2 = read_all(&count);
+	sensors_get_stats(NULL, &after);
+	sensors_cleanup();
+	if (setrlimit(RLIMIT_NOFILE, &limit))
+		fail("setrlimit", 0);
+	check(count > 64 && !bad1 && !bad2 &&
+	      after.opens - before.opens < (unsigned int)count,
+	      "keep-open: values are read when files can't all stay open");
+}
+
+int main(void)
+{
+	const char *base;
+
+	base = getenv("TMPDIR");
+	snprintf(tmp, sizeof(tmp), "%s/test-libsensors.XXXXXX",
+		 base ? base : "/tmp");
+	if (!mkdtemp(tmp) || chdir(tmp))
+		fail(tmp, 0);
+
+	/* Leave out what the environment asks for */
+	sensors_set_trace(NULL);
+	sensors_set_board_config(0, NULL);
+	sensors_set_energy_power(0);
+
+	test_set_value();
+	test_batch();
+	test_deadline();
+	test_breaker();
+	test_timestamps();
+	test_watch();
+	test_subscribe();
+	test_raw_value();
+	test_memory();
+	test_trace();
+	test_hwmon_tree();
+	test_stats();
+	test_budget();
+	test_discover();
+	test_reload();
+	test_image();
+	test_boards();
+	test_scanner();
+	test_parse_dir();
+	test_expressions();
+	test_virtual();
+	test_energy();
+	test_keep_open();
+	printf("1..%d\n", tests);
+
+	sensors_cleanup();
+	if (chdir("..") || hwmon_tree_remove(tmp))
+		fail(tmp, 0);
+	return failures ? 1 : 0;
+}
@@ -19,26 +19,31 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../data.h"
 #include "../conf.h"
 #include "../conf-parse.h"
 #include "../scanner.h"
 
-YYSTYPE sensors_yylval;
+int sensors_yylex(YYSTYPE *lvalp, void *scanner);
 
 int main(void)
 {
+	sensors_parse_state state;
+	YYSTYPE sensors_yylval;
+	void *scanner;
 	int result;
 
 	/* init the scanner */
-	if ((result = sensors_scanner_init(stdin, NULL)))
+	memset(&state, 0, sizeof(state));
+	if ((result = sensors_scanner_init(&state, stdin, &scanner)))
 		return result;
 
 	do {
-		result = sensors_yylex();
+		result = sensors_yylex(&sensors_yylval, scanner);
 
-		printf("%d: ", sensors_yylineno);
+		printf("%d: ", state.lineno);
 
 		switch (result) {
 
@@ -77,6 +82,14 @@ int main(void)
 			case IGNORE:
 				printf("IGNORE\n");
 				break;
+
+			case VIRTUAL:
+				printf("VIRTUAL\n");
+				break;
+
+			case DEFINE:
+				printf("DEFINE\n");
+				break;
 	
 			case FLOAT:
 				printf("FLOAT: %f\n", sensors_yylval.value);
@@ -87,6 +100,22 @@ int main(void)
 				free(sensors_yylval.name);
 				break;
 	
+			case LE:
+				printf("<=\n");
+				break;
+
+			case GE:
+				printf(">=\n");
+				break;
+
+			case EQ:
+				printf("==\n");
+				break;
+
+			case NE:
+				printf("!=\n");
+				break;
+
 			case ERROR:
 				printf("ERROR\n");
 				break;
@@ -99,7 +128,7 @@ int main(void)
 	} while (result);
 
 	/* clean up the scanner */
-	sensors_scanner_exit();
+	sensors_scanner_exit(&state, scanner);
 
 	return 0;
 }
@@ -44,6 +44,12 @@ my @scenarios = (
 		desc => 'normal, quoted names' },
 	{ base => 'names-quoted-errors', status => 0,
 		desc => 'invalid, quoted names' },
+	{ base => 'names-quoted-fast', status => 0,
+		desc => 'quoted names copied at once' },
+	{ base => 'operators', status => 0,
+		desc => 'comparison operators and conditionals' },
+	{ base => 'virtual', status => 0,
+		desc => 'virtual chips and define statements' },
 );
 
 plan tests => ($#scenarios + 1) * 3;
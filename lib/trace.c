@@ -0,0 +1,783 @@
+/*
+    trace.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+/* this define needed for secure_getenv() */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "sysfs.h"
+#include "backend.h"
+#include "stats.h"
+
+/*
+ * Trace file format. A trace starts with the 8-byte magic "LMSTRACE" and
+ * a version byte, followed by records made of a tag byte and fields.
+ * Integers are LEB128 varints, signed ones zigzag-encoded first, and
+ * strings are a length followed by that many bytes.
+ *
+ *   'S' session: the chips found by a new sensors_init() follow
+ *   'B' bus:   bus type, bus nr (signed), adapter name
+ *   'C' chip:  prefix, bus type, bus nr (signed), address (signed), path,
+ *              number of attributes, then name and mode of each
+ *   'P' path:  attribute path, which gets the next path id from 0 on
+ *   'R' read:  ns since the previous read or write, path id, error
+ *              (signed), raw value (signed)
+ *   'W' write: same fields as a read
+ *   'T' text:  path id, 1 and the text, or 0 if there was none
+ *
+ * Each session starts with the discovery records, followed by reads,
+ * writes and texts in the order in which they completed. Sessions after
+ * the first one only add reads, writes and texts when replaying.
+ */
+
+#define TRACE_MAGIC	"LMSTRACE"
+#define TRACE_VERSION	1
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char *trace_filename;
+static double replay_speed;
+
+static long long trace_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Recording
+ */
+
+struct trace_path {
+	char *path;
+	int id;
+};
+
+static const sensors_backend *record_inner;
+static FILE *record_file;
+static char *record_filename;
+static struct trace_path *record_paths;	/* sorted by path */
+static int record_paths_count, record_paths_max;
+static long long record_last_ns;
+
+static void put_uvarint(unsigned long long v)
+{
+	while (v >= 0x80) {
+		putc((v & 0x7f) | 0x80, record_file);
+		v >>= 7;
+	}
+	putc(v, record_file);
+}
+
+static void put_varint(long long v)
+{
+	put_uvarint(((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63));
+}
+
+static void put_string(const char *s)
+{
+	size_t len = s ? strlen(s) : 0;
+
+	put_uvarint(len);
+	fwrite(s, 1, len, record_file);
+}
+
+/* Return the id of a path, defining it first if it is new. Must be
+   called with trace_lock held. */
+static int record_path_id(const char *path)
+{
+	struct trace_path p;
+	int lo = 0, hi = record_paths_count, mid, cmp;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		cmp = strcmp(path, record_paths[mid].path);
+		if (!cmp)
+			return record_paths[mid].id;
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	p.path = strdup(path);
+	if (!p.path)
+		sensors_fatal_error(__func__, "Out of memory");
+	p.id = record_paths_count;
+	sensors_add_array_el(&p, &record_paths, &record_paths_count,
+			     &record_paths_max, sizeof(struct trace_path));
+	memmove(record_paths + lo + 1, record_paths + lo,
+		(record_paths_count - 1 - lo) * sizeof(struct trace_path));
+	record_paths[lo] = p;
+
+	putc('P', record_file);
+	put_string(path);
+	return p.id;
+}
+
+static void record_access(int tag, const char *path, int err, long long value)
+{
+	long long now;
+	int id;
+
+	pthread_mutex_lock(&trace_lock);
+	/* A late read from an abandoned batch worker may come after
+	   sensors_cleanup() */
+	if (record_file) {
+		id = record_path_id(path);
+		now = trace_now_ns();
+		putc(tag, record_file);
+		put_uvarint(now - record_last_ns);
+		put_uvarint(id);
+		put_varint(err);
+		put_varint(value);
+		record_last_ns = now;
+	}
+	pthread_mutex_unlock(&trace_lock);
+}
+
+static void record_chip(const sensors_chip_features *chip)
+{
+	int i;
+
+	putc('C', record_file);
+	put_string(chip->chip.prefix);
+	put_uvarint(chip->chip.bus.type);
+	put_varint(chip->chip.bus.nr);
+	put_varint(chip->chip.addr);
+	put_string(chip->chip.path);
+	put_uvarint(chip->subfeature_count);
+	for (i = 0; i < chip->subfeature_count; i++) {
+		put_string(chip->subfeature[i].name);
+		put_uvarint(chip->subfeature[i].flags &
+			    (SENSORS_MODE_R | SENSORS_MODE_W));
+	}
+}
+
+/* Close the trace file. Must be called with trace_lock held. */
+static void record_close(void)
+{
+	int i;
+
+	fclose(record_file);
+	record_file = NULL;
+	free(record_filename);
+	record_filename = NULL;
+	for (i = 0; i < record_paths_count; i++)
+		free(record_paths[i].path);
+	free(record_paths);
+	record_paths = NULL;
+	record_paths_count = record_paths_max = 0;
+}
+
+/* Start a new session in the trace file. Must be called with trace_lock
+   held. */
+static int record_session(void)
+{
+	int i;
+
+	if (record_file && strcmp(record_filename, trace_filename))
+		record_close();
+
+	/* Later sessions, e.g. after a configuration reload, are appended
+	   to the same trace */
+	if (!record_file) {
+		if (!(record_file = fopen(trace_filename, "we")))
+			return -SENSORS_ERR_ACCESS_W;
+		if (!(record_filename = strdup(trace_filename)))
+			sensors_fatal_error(__func__, "Out of memory");
+		fwrite(TRACE_MAGIC, 1, 8, record_file);
+		putc(TRACE_VERSION, record_file);
+		record_last_ns = trace_now_ns();
+	}
+
+	putc('S', record_file);
+	for (i = 0; i < sensors_proc_bus_count; i++) {
+		putc('B', record_file);
+		put_uvarint(sensors_proc_bus[i].bus.type);
+		put_varint(sensors_proc_bus[i].bus.nr);
+		put_string(sensors_proc_bus[i].adapter);
+	}
+	for (i = 0; i < sensors_proc_chips_count; i++)
+		record_chip(&sensors_proc_chips[i]);
+	if (ferror(record_file))
+		return -SENSORS_ERR_ACCESS_W;
+
+	return 0;
+}
+
+static int record_discover(const char *source)
+{
+	int res;
+
+	if ((res = record_inner->discover(source)))
+		return res;
+
+	pthread_mutex_lock(&trace_lock);
+	res = record_session();
+	pthread_mutex_unlock(&trace_lock);
+
+	return res;
+}
+
+static int record_read(const char *path, long long *value)
+{
+	int err;
+
+	err = record_inner->read(path, value);
+	record_access('R', path, err, err ? 0 : *value);
+	return err;
+}
+
+static int record_write(const char *dir, const char *attr,
+			sensors_subfeature_state *state, long value)
+{
+	char n[NAME_MAX];
+	int err;
+
+	err = record_inner->write(dir, attr, state, value);
+	snprintf(n, NAME_MAX, "%s/%s", dir, attr);
+	record_access('W', n, err, value);
+	return err;
+}
+
+static char *record_read_text(const char *dir, const char *attr)
+{
+	char n[NAME_MAX];
+	char *text;
+
+	text = record_inner->read_text(dir, attr);
+	snprintf(n, NAME_MAX, "%s/%s", dir, attr);
+
+	pthread_mutex_lock(&trace_lock);
+	if (record_file) {
+		int id = record_path_id(n);
+
+		putc('T', record_file);
+		put_uvarint(id);
+		put_uvarint(text != NULL);
+		if (text)
+			put_string(text);
+	}
+	pthread_mutex_unlock(&trace_lock);
+
+	return text;
+}
+
+static void record_cleanup(void)
+{
+	if (record_inner->cleanup)
+		record_inner->cleanup();
+
+	/* The trace file stays open for the next session */
+	pthread_mutex_lock(&trace_lock);
+	if (record_file)
+		fflush(record_file);
+	pthread_mutex_unlock(&trace_lock);
+}
+
+/* Not const, as it can be polled if the inner backend can */
+static sensors_backend record_backend = {
+	record_discover,
+	record_read,
+	NULL,
+	record_write,
+	record_read_text,
+	record_cleanup,
+	0,
+};
+
+/*
+ * Replay
+ */
+
+struct replay_event {
+	long long ns;		/* since the start of the trace */
+	long long value;
+	int err;
+};
+
+struct replay_path {
+	char *path;
+	struct replay_event *events;
+	int events_count, events_max;
+	int next;		/* next event to serve, at speed 0 */
+	char *text;
+};
+
+static struct replay_path *replay_paths;	/* in id order */
+static int replay_paths_count, replay_paths_max;
+static int *replay_index;			/* ids sorted by path */
+static long long replay_start_ns;
+
+struct replay_buf {
+	const unsigned char *p, *end;
+	int err;
+};
+
+static unsigned long long get_uvarint(struct replay_buf *b)
+{
+	unsigned long long v = 0;
+	int shift = 0;
+
+	while (b->p < b->end && shift < 64) {
+		v |= (unsigned long long)(*b->p & 0x7f) << shift;
+		if (!(*b->p++ & 0x80))
+			return v;
+		shift += 7;
+	}
+	b->err = 1;
+	return 0;
+}
+
+static long long get_varint(struct replay_buf *b)
+{
+	unsigned long long v = get_uvarint(b);
+
+	return (long long)(v >> 1) ^ -(long long)(v & 1);
+}
+
+/* Returns a newly allocated string */
+static char *get_string(struct replay_buf *b)
+{
+	unsigned long long len = get_uvarint(b);
+	char *s;
+
+	if (b->err || len > (unsigned long long)(b->end - b->p)) {
+		b->err = 1;
+		return NULL;
+	}
+	s = strndup((const char *)b->p, len);
+	if (!s)
+		sensors_fatal_error(__func__, "Out of memory");
+	b->p += len;
+	return s;
+}
+
+static struct replay_path *replay_get_path(struct replay_buf *b)
+{
+	unsigned long long id = get_uvarint(b);
+
+	if (b->err || id >= (unsigned long long)replay_paths_count) {
+		b->err = 1;
+		return NULL;
+	}
+	return &replay_paths[id];
+}
+
+struct replay_chip_attrs {
+	char **names;
+	int *modes;
+	int next, count;
+};
+
+static const char *replay_next_attr(void *data)
+{
+	struct replay_chip_attrs *a = data;
+
+	if (a->next >= a->count)
+		return NULL;
+	return a->names[a->next++];
+}
+
+/* name is always the attribute replay_next_attr() just returned */
+static int replay_attr_mode(void *data, const char *name)
+{
+	struct replay_chip_attrs *a = data;
+	(void)name; /* hide warning */
+
+	return a->modes[a->next - 1];
+}
+
+static void replay_chip(struct replay_buf *b, int keep)
+{
+	sensors_chip_features entry;
+	struct replay_chip_attrs a;
+	sensors_attr_list attrs = { replay_next_attr, replay_attr_mode, &a,
+				    1 };
+	unsigned long long count;
+	long long start;
+	int i;
+
+	start = sensors_stats_now();
+	memset(&entry, 0, sizeof(entry));
+	entry.chip.prefix = get_string(b);
+	entry.chip.bus.type = get_uvarint(b);
+	entry.chip.bus.nr = get_varint(b);
+	entry.chip.addr = get_varint(b);
+	entry.chip.path = get_string(b);
+	count = get_uvarint(b);
+	if (b->err || count > (unsigned long long)(b->end - b->p)) {
+		b->err = 1;
+		free(entry.chip.prefix);
+		free(entry.chip.path);
+		return;
+	}
+
+	a.names = calloc(count + 1, sizeof(char *));
+	a.modes = calloc(count + 1, sizeof(int));
+	if (!a.names || !a.modes)
+		sensors_fatal_error(__func__, "Out of memory");
+	a.next = 0;
+	a.count = count;
+	for (i = 0; i < a.count && !b->err; i++) {
+		a.names[i] = get_string(b);
+		a.modes[i] = get_uvarint(b);
+	}
+
+	if (!b->err && keep)
+		sensors_build_chip_features(&entry, &attrs);
+	if (b->err || !keep || !entry.subfeature) {
+		free(entry.chip.prefix);
+		free(entry.chip.path);
+	} else {
+		entry.timeout_ms = 0;
+		memset(&entry.breaker, 0, sizeof(entry.breaker));
+		memset(&entry.stats, 0, sizeof(entry.stats));
+		entry.stats.discovery_ns = sensors_stats_now() - start;
+		sensors_add_proc_chips(&entry);
+	}
+
+	for (i = 0; i < a.count; i++)
+		free(a.names[i]);
+	free(a.names);
+	free(a.modes);
+}
+
+static int replay_parse(struct replay_buf *b)
+{
+	struct replay_path *path;
+	struct replay_event ev;
+	sensors_bus bus;
+	long long ns = 0;
+	int tag, sessions = 0;
+
+	while (b->p < b->end && !b->err) {
+		tag = *b->p++;
+		switch (tag) {
+		case 'S':
+			sessions++;
+			break;
+		case 'B':
+			memset(&bus, 0, sizeof(bus));
+			bus.bus.type = get_uvarint(b);
+			bus.bus.nr = get_varint(b);
+			bus.adapter = get_string(b);
+			if (!b->err && sessions == 1)
+				sensors_add_proc_bus(&bus);
+			else
+				free(bus.adapter);
+			break;
+		case 'C':
+			replay_chip(b, sessions == 1);
+			break;
+		case 'P':
+			{
+				struct replay_path p;
+
+				memset(&p, 0, sizeof(p));
+				p.path = get_string(b);
+				if (!b->err)
+					sensors_add_array_el(&p, &replay_paths,
+						&replay_paths_count,
+						&replay_paths_max,
+						sizeof(struct replay_path));
+			}
+			break;
+		case 'R':
+		case 'W':
+			ns += get_uvarint(b);
+			path = replay_get_path(b);
+			ev.ns = ns;
+			ev.err = get_varint(b);
+			ev.value = get_varint(b);
+			/* Writes only matter for the timing of later reads */
+			if (!b->err && tag == 'R')
+				sensors_add_array_el(&ev, &path->events,
+						     &path->events_count,
+						     &path->events_max,
+						     sizeof(struct replay_event));
+			break;
+		case 'T':
+			path = replay_get_path(b);
+			if (!b->err && get_uvarint(b) && !b->err) {
+				free(path->text);
+				path->text = get_string(b);
+			}
+			break;
+		default:
+			b->err = 1;
+		}
+	}
+
+	return b->err ? -SENSORS_ERR_PARSE : 0;
+}
+
+static int replay_index_cmp(const void *a, const void *b)
+{
+	return strcmp(replay_paths[*(const int *)a].path,
+		      replay_paths[*(const int *)b].path);
+}
+
+static struct replay_path *replay_find(const char *path)
+{
+	int lo = 0, hi = replay_paths_count, mid, cmp;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		cmp = strcmp(path, replay_paths[replay_index[mid]].path);
+		if (!cmp)
+			return &replay_paths[replay_index[mid]];
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return NULL;
+}
+
+static int replay_discover(const char *filename)
+{
+	struct replay_buf b;
+	unsigned char *data = NULL;
+	size_t size = 0, len;
+	FILE *f;
+	int i, res;
+
+	if (!(f = fopen(filename, "re")))
+		return -SENSORS_ERR_ACCESS_R;
+	do {
+		data = realloc(data, size + 65536);
+		if (!data)
+			sensors_fatal_error(__func__, "Out of memory");
+		len = fread(data + size, 1, 65536, f);
+		size += len;
+	} while (len == 65536);
+	res = ferror(f) ? -SENSORS_ERR_ACCESS_R : 0;
+	fclose(f);
+
+	if (!res && (size < 9 || memcmp(data, TRACE_MAGIC, 8) ||
+		     data[8] != TRACE_VERSION))
+		res = -SENSORS_ERR_PARSE;
+	if (!res) {
+		b.p = data + 9;
+		b.end = data + size;
+		b.err = 0;
+		res = replay_parse(&b);
+	}
+	free(data);
+	if (res) {
+		sensors_parse_error_wfn("Invalid trace file", filename, 0);
+		return res;
+	}
+
+	replay_index = malloc((replay_paths_count + 1) * sizeof(int));
+	if (!replay_index)
+		sensors_fatal_error(__func__, "Out of memory");
+	for (i = 0; i < replay_paths_count; i++)
+		replay_index[i] = i;
+	qsort(replay_index, replay_paths_count, sizeof(int), replay_index_cmp);
+
+	replay_start_ns = trace_now_ns();
+	return 0;
+}
+
+static int replay_read(const char *path, long long *value)
+{
+	struct replay_path *p;
+	const struct replay_event *ev;
+	int lo, hi, mid;
+	long long ns;
+
+	if (!(p = replay_find(path)))
+		return -SENSORS_ERR_KERNEL;
+	if (!p->events_count)
+		return -SENSORS_ERR_ACCESS_R;
+
+	if (replay_speed > 0) {
+		/* Serve the last value read at this point of the trace */
+		ns = (trace_now_ns() - replay_start_ns) * replay_speed;
+		lo = 0;
+		hi = p->events_count - 1;
+		while (lo < hi) {
+			mid = (lo + hi + 1) / 2;
+			if (p->events[mid].ns <= ns)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+		ev = &p->events[lo];
+	} else {
+		/* Serve the reads in order, then stick to the last one */
+		pthread_mutex_lock(&trace_lock);
+		ev = &p->events[p->next];
+		if (p->next < p->events_count - 1)
+			p->next++;
+		pthread_mutex_unlock(&trace_lock);
+	}
+
+	if (ev->err)
+		return ev->err;
+	*value = ev->value;
+	return 0;
+}
+
+static int replay_write(const char *dir, const char *attr,
+			sensors_subfeature_state *state, long value)
+{
+	(void)dir; /* hide warnings */
+	(void)attr;
+	(void)state;
+	(void)value;
+
+	return 0;
+}
+
+static char *replay_read_text(const char *dir, const char *attr)
+{
+	const struct replay_path *p;
+	char n[NAME_MAX], *text;
+
+	snprintf(n, NAME_MAX, "%s/%s", dir, attr);
+	if (!(p = replay_find(n)) || !p->text)
+		return NULL;
+
+	text = strdup(p->text);
+	if (!text)
+		sensors_fatal_error(__func__, "Out of memory");
+	return text;
+}
+
+static void replay_cleanup(void)
+{
+	int i;
+
+	for (i = 0; i < replay_paths_count; i++) {
+		free(replay_paths[i].path);
+		free(replay_paths[i].events);
+		free(replay_paths[i].text);
+	}
+	free(replay_paths);
+	replay_paths = NULL;
+	replay_paths_count = replay_paths_max = 0;
+	free(replay_index);
+	replay_index = NULL;
+}
+
+const sensors_backend sensors_replay_backend = {
+	replay_discover,
+	replay_read,
+	NULL,
+	replay_write,
+	replay_read_text,
+	replay_cleanup,
+	0,
+};
+
+/*
+ * Configuration
+ */
+
+/* Set once the application made its own choices, which the environment
+   doesn't override */
+static int trace_chosen, replay_speed_chosen;
+
+static void set_trace(const char *filename)
+{
+	char *s = NULL;
+
+	if (filename && !(s = strdup(filename)))
+		sensors_fatal_error(__func__, "Out of memory");
+	free(trace_filename);
+	trace_filename = s;
+
+	if (!filename) {
+		pthread_mutex_lock(&trace_lock);
+		if (record_file)
+			record_close();
+		pthread_mutex_unlock(&trace_lock);
+	}
+}
+
+void sensors_set_trace(const char *filename)
+{
+	set_trace(filename);
+	trace_chosen = 1;
+}
+
+static void set_replay_speed(double speed)
+{
+	replay_speed = speed > 0 ? speed : 0;
+}
+
+void sensors_set_replay_speed(double speed)
+{
+	set_replay_speed(speed);
+	replay_speed_chosen = 1;
+}
+
+/* Let programs which don't know about traces record or replay them */
+void sensors_trace_getenv(void)
+{
+	const char *s;
+
+	if ((s = secure_getenv("SENSORS_TRACE_REPLAY")) && *s)
+		sensors_set_backend_default(SENSORS_BACKEND_REPLAY, s);
+	if ((s = secure_getenv("SENSORS_TRACE_SPEED")) && *s &&
+	    !replay_speed_chosen)
+		set_replay_speed(strtod(s, NULL));
+	if ((s = secure_getenv("SENSORS_TRACE_RECORD")) && *s &&
+	    !trace_chosen)
+		set_trace(s);
+}
+
+void sensors_trace_read(const char *dir, const char *attr, int err,
+			long long value)
+{
+	char n[NAME_MAX];
+
+	if (sensors_current_backend != &record_backend)
+		return;
+	snprintf(n, NAME_MAX, "%s/%s", dir, attr);
+	record_access('R', n, err, err ? 0 : value);
+}
+
+/* The backend to use for a session over backend inner, which records all
+   accesses if a trace file was set */
+const sensors_backend *sensors_trace_backend(const sensors_backend *inner)
+{
+	if (!trace_filename)
+		return inner;
+
+	record_inner = inner;
+	record_backend.pollable = inner->pollable;
+	return &record_backend;
+}
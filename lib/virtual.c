@@ -0,0 +1,276 @@
+/*
+    virtual.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "sysfs.h"
+#include "virtual.h"
+
+/*
+ * A virtual chip is made of the subfeatures defined by all the virtual
+ * statements with its name. They have no attribute files, their values
+ * are computed from the define statements when they are read, see
+ * sensors_eval_define().
+ */
+
+struct virtual_names {
+	const char **names;
+	int count;
+	int max;
+	int next;
+};
+
+static const char *virtual_next_attr(void *data)
+{
+	struct virtual_names *names = data;
+
+	if (names->next >= names->count)
+		return NULL;
+	return names->names[names->next++];
+}
+
+static int virtual_attr_mode(void *data, const char *name)
+{
+	(void)data;
+	(void)name;
+	return SENSORS_MODE_R;
+}
+
+/* Virtual buses have no number, it is 0 in detected chips but any in the
+   configuration */
+static int same_chip_name(const sensors_chip_name *a,
+			  const sensors_chip_name *b)
+{
+	return !strcmp(a->prefix, b->prefix) &&
+	       a->bus.type == b->bus.type && a->addr == b->addr;
+}
+
+static void add_name(struct virtual_names *names, const char *name)
+{
+	int i;
+
+	for (i = 0; i < names->count; i++)
+		if (!strcmp(names->names[i], name))
+			return;
+	sensors_add_array_el(&name, &names->names, &names->count,
+			     &names->max, sizeof(const char *));
+}
+
+static const sensors_subfeature *
+find_subfeature(const sensors_chip_features *chip, const char *name)
+{
+	int i;
+
+	for (i = 0; i < chip->subfeature_count; i++)
+		if (!strcmp(chip->subfeature[i].name, name))
+			return &chip->subfeature[i];
+	return NULL;
+}
+
+/* Build the virtual chip of the virtual statement at index first, from
+   all virtual statements with the same name. Returns 0 on success, and
+   <0 if the chip has no valid subfeature. */
+static int build_virtual_chip(sensors_chip_features *entry, int first)
+{
+	const sensors_chip_name *name;
+	struct virtual_names names;
+	sensors_attr_list attrs = { virtual_next_attr, virtual_attr_mode,
+				    &names, 0 };
+	const sensors_chip *chip;
+	char buf[NAME_MAX];
+	int i, j;
+
+	name = &sensors_config_chips[first].chips.fits[0];
+	memset(&names, 0, sizeof(names));
+	for (i = first; i < sensors_config_chips_count; i++) {
+		chip = &sensors_config_chips[i];
+		if (!chip->defines_count ||
+		    !same_chip_name(&chip->chips.fits[0], name))
+			continue;
+		for (j = 0; j < chip->defines_count; j++)
+			add_name(&names, chip->defines[j].name);
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	entry->chip = *name;
+	entry->chip.bus.nr = 0;
+	entry->chip.prefix = strdup(name->prefix);
+	sensors_snprintf_chip_name(buf, sizeof(buf), name);
+	entry->chip.path = strdup(buf);
+	if (!entry->chip.prefix || !entry->chip.path)
+		sensors_fatal_error(__func__, "Out of memory");
+	sensors_build_chip_features(entry, &attrs);
+	free(names.names);
+
+	if (!entry->subfeature) {
+		free(entry->chip.prefix);
+		free(entry->chip.path);
+		return -SENSORS_ERR_NO_ENTRY;
+	}
+	return 0;
+}
+
+/* Check whether the virtual statement at index i is the first one with
+   its name */
+static int first_virtual_statement(int i)
+{
+	const sensors_chip_name *name;
+	int j;
+
+	if (!sensors_config_chips[i].defines_count)
+		return 0;
+	name = &sensors_config_chips[i].chips.fits[0];
+	for (j = 0; j < i; j++)
+		if (sensors_config_chips[j].defines_count &&
+		    same_chip_name(&sensors_config_chips[j].chips.fits[0],
+				   name))
+			return 0;
+	return 1;
+}
+
+static const sensors_chip_features *
+find_chip(const sensors_chip_features *chips, int count,
+	  const sensors_chip_name *name)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		if (same_chip_name(&chips[i].chip, name))
+			return &chips[i];
+	return NULL;
+}
+
+/* Report the define statements which were dropped when building the
+   virtual chips, because a detected chip has the same name, or because
+   their name doesn't stand for any known subfeature */
+static void report_dropped_defines(const sensors_chip_features *chips,
+				   int chips_count)
+{
+	const sensors_chip_features *entry;
+	const sensors_chip_name *name;
+	const sensors_chip *chip;
+	const sensors_define *define;
+	int i, j;
+
+	for (i = 0; i < sensors_config_chips_count; i++) {
+		chip = &sensors_config_chips[i];
+		if (!chip->defines_count)
+			continue;
+		name = &chip->chips.fits[0];
+		if (find_chip(sensors_proc_chips, sensors_proc_chips_count,
+			      name)) {
+			sensors_parse_error_wfn("Chip name already in use",
+						chip->line.filename,
+						chip->line.lineno);
+			continue;
+		}
+
+		entry = find_chip(chips, chips_count, name);
+		for (j = 0; j < chip->defines_count; j++) {
+			define = &chip->defines[j];
+			if (!entry || !find_subfeature(entry, define->name))
+				sensors_parse_error_wfn("Unknown subfeature name",
+							define->line.filename,
+							define->line.lineno);
+		}
+	}
+}
+
+static void free_virtual_chip(sensors_chip_features *chip)
+{
+	int i;
+
+	for (i = 0; i < chip->subfeature_count; i++)
+		free(chip->subfeature[i].name);
+	free(chip->subfeature);
+	free(chip->state);
+	for (i = 0; i < chip->feature_count; i++)
+		free(chip->feature[i].name);
+	free(chip->feature);
+	free(chip->chip.prefix);
+	free(chip->chip.path);
+}
+
+static int same_virtual_chip(const sensors_chip_features *a,
+			     const sensors_chip_features *b)
+{
+	int i;
+
+	if (!same_chip_name(&a->chip, &b->chip) ||
+	    a->subfeature_count != b->subfeature_count)
+		return 0;
+	for (i = 0; i < a->subfeature_count; i++)
+		if (strcmp(a->subfeature[i].name, b->subfeature[i].name))
+			return 0;
+	return 1;
+}
+
+void sensors_virtual_update(void)
+{
+	sensors_chip_features *chips = NULL, entry;
+	int chips_count = 0, chips_max = 0;
+	int i;
+
+	for (i = 0; i < sensors_config_chips_count; i++) {
+		if (!first_virtual_statement(i) ||
+		    find_chip(sensors_proc_chips, sensors_proc_chips_count,
+			      &sensors_config_chips[i].chips.fits[0]) ||
+		    build_virtual_chip(&entry, i))
+			continue;
+		sensors_add_array_el(&entry, &chips, &chips_count, &chips_max,
+				     sizeof(sensors_chip_features));
+	}
+	report_dropped_defines(chips, chips_count);
+
+	if (chips_count == sensors_virtual_chips_count) {
+		for (i = 0; i < chips_count; i++)
+			if (!same_virtual_chip(&chips[i],
+					       &sensors_virtual_chips[i]))
+				break;
+		if (i == chips_count) {
+			/* Nothing changed */
+			for (i = 0; i < chips_count; i++)
+				free_virtual_chip(&chips[i]);
+			free(chips);
+			return;
+		}
+	}
+
+	sensors_virtual_free();
+	sensors_virtual_chips = chips;
+	sensors_virtual_chips_count = chips_count;
+	sensors_virtual_chips_max = chips_max;
+}
+
+void sensors_virtual_free(void)
+{
+	int i;
+
+	for (i = 0; i < sensors_virtual_chips_count; i++)
+		free_virtual_chip(&sensors_virtual_chips[i]);
+	free(sensors_virtual_chips);
+	sensors_virtual_chips = NULL;
+	sensors_virtual_chips_count = sensors_virtual_chips_max = 0;
+}
@@ -0,0 +1,32 @@
+/*
+    virtual.h - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef LIB_SENSORS_VIRTUAL_H
+#define LIB_SENSORS_VIRTUAL_H
+
+/* Create the virtual chips defined by the configuration, once chips were
+   detected or the configuration was loaded. If the virtual chips didn't
+   change, they are kept as they are, so that their names stay valid. */
+void sensors_virtual_update(void);
+
+/* Free all virtual chips */
+void sensors_virtual_free(void);
+
+#endif /* def LIB_SENSORS_VIRTUAL_H */
@@ -0,0 +1,174 @@
+/*
+    watch.c - Part of libsensors, a Linux library for reading sensor data.
+    Copyright (C) 2026  The lm-sensors developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+#include "sensors.h"
+#include "data.h"
+#include "error.h"
+#include "general.h"
+#include "access.h"
+#include "sysfs.h"
+#include "backend.h"
+#include "stats.h"
+
+/* A watched attribute. The pointers refer to libsensors internal
+   structures, so a watch must not outlive sensors_cleanup(). */
+struct watch_entry {
+	const sensors_chip_features *chip;
+	const sensors_subfeature *subfeature;
+	int fd;
+};
+
+struct sensors_watch {
+	int epfd;
+	struct watch_entry *entries;
+	int entries_count;
+	int entries_max;
+};
+
+sensors_watch *sensors_watch_new(void)
+{
+	sensors_watch *watch;
+
+	watch = calloc(1, sizeof(sensors_watch));
+	if (!watch)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	watch->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (watch->epfd < 0) {
+		free(watch);
+		return NULL;
+	}
+
+	return watch;
+}
+
+void sensors_watch_free(sensors_watch *watch)
+{
+	int i;
+
+	if (!watch)
+		return;
+
+	for (i = 0; i < watch->entries_count; i++)
+		close(watch->entries[i].fd);
+	close(watch->epfd);
+	free(watch->entries);
+	free(watch);
+}
+
+int sensors_watch_fd(const sensors_watch *watch)
+{
+	return watch->epfd;
+}
+
+int sensors_watch_add(sensors_watch *watch, const sensors_chip_name *name,
+		      int subfeat_nr)
+{
+	struct watch_entry entry;
+	struct epoll_event ev;
+	char n[NAME_MAX];
+	double value;
+	int err;
+
+	if ((err = sensors_lookup_readable(name, subfeat_nr, &entry.chip,
+					   &entry.subfeature)))
+		return err;
+
+	/* Only files can be polled */
+	if (!sensors_current_backend->pollable ||
+	    sensors_chip_is_virtual(entry.chip) ||
+	    (entry.subfeature->flags & SENSORS_DERIVED))
+		return -SENSORS_ERR_KERNEL;
+
+	snprintf(n, NAME_MAX, "%s/%s", entry.chip->chip.path,
+		 entry.subfeature->name);
+	sensors_stats_add(sensors_stats_total.opens, 1);
+	entry.fd = open(n, O_RDONLY | O_CLOEXEC);
+	if (entry.fd < 0)
+		return -SENSORS_ERR_KERNEL;
+
+	/* sysfs only notifies of changes which happen after the attribute
+	   was last read */
+	sensors_read_sysfs_fd(&entry.chip->chip, entry.subfeature, entry.fd,
+			      &value);
+
+	ev.events = EPOLLPRI | EPOLLERR;
+	ev.data.u32 = watch->entries_count;
+	if (epoll_ctl(watch->epfd, EPOLL_CTL_ADD, entry.fd, &ev)) {
+		close(entry.fd);
+		return -SENSORS_ERR_KERNEL;
+	}
+
+	sensors_add_array_el(&entry, &watch->entries, &watch->entries_count,
+			     &watch->entries_max, sizeof(struct watch_entry));
+	return 0;
+}
+
+int sensors_watch_wait(sensors_watch *watch, int timeout_ms,
+		       sensors_value_request *req, int max)
+{
+	struct epoll_event *ev;
+	struct watch_entry *entry;
+	long long start;
+	double value;
+	int i, n;
+
+	if (max <= 0)
+		return 0;
+
+	ev = malloc(max * sizeof(struct epoll_event));
+	if (!ev)
+		sensors_fatal_error(__func__, "Out of memory");
+
+	n = epoll_wait(watch->epfd, ev, max, timeout_ms);
+	if (n < 0) {
+		n = errno == EINTR ? 0 : -SENSORS_ERR_KERNEL;
+		goto exit_free;
+	}
+
+	/* Reading the attributes again also rearms the notification */
+	for (i = 0; i < n; i++) {
+		entry = &watch->entries[ev[i].data.u32];
+		req[i].name = &entry->chip->chip;
+		req[i].subfeat_nr = entry->subfeature->number;
+		start = sensors_stats_now();
+		req[i].err = sensors_read_sysfs_fd(&entry->chip->chip,
+						   entry->subfeature,
+						   entry->fd, &value);
+		sensors_stats_read(entry->chip, req[i].err,
+				   sensors_stats_now() - start);
+		if (!req[i].err)
+			req[i].err = sensors_apply_compute(entry->chip,
+							   entry->subfeature,
+							   value,
+							   &req[i].value);
+	}
+
+exit_free:
+	free(ev);
+	return n;
+}
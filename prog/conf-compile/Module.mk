@@ -0,0 +1,59 @@
+#  Module.mk - Makefile for a Linux module for reading sensor data.
+#  Copyright (C) 2026  The lm-sensors developers
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+#  MA 02110-1301 USA.
+
+# Note that MODULE_DIR (the directory in which this file resides) is a
+# 'simply expanded variable'. That means that its value is substituted
+# verbatim in the rules, until it is redefined. 
+MODULE_DIR := prog/conf-compile
+PROGCONFCOMPILEDIR := $(MODULE_DIR)
+
+PROGCONFCOMPILEMAN8DIR := $(MANDIR)/man8
+PROGCONFCOMPILEMAN8FILES := $(MODULE_DIR)/sensors-conf-compile.8
+
+# Regrettably, even 'simply expanded variables' will not put their currently
+# defined value verbatim into the command-list of rules...
+PROGCONFCOMPILETARGETS := $(MODULE_DIR)/sensors-conf-compile
+PROGCONFCOMPILESOURCES := $(MODULE_DIR)/sensors-conf-compile.c
+
+# Include all dependency files. We use '.rd' to indicate this will create
+# executables.
+INCLUDEFILES += $(PROGCONFCOMPILESOURCES:.c=.rd)
+
+REMOVECONFCOMPILEBIN := $(patsubst $(MODULE_DIR)/%,$(DESTDIR)$(SBINDIR)/%,$(PROGCONFCOMPILETARGETS))
+REMOVECONFCOMPILEMAN := $(patsubst $(MODULE_DIR)/%,$(DESTDIR)$(PROGCONFCOMPILEMAN8DIR)/%,$(PROGCONFCOMPILEMAN8FILES))
+
+$(PROGCONFCOMPILETARGETS): $(PROGCONFCOMPILESOURCES:.c=.ro) lib/$(LIBSHBASENAME)
+	$(CC) $(EXLDFLAGS) -o $@ $(PROGCONFCOMPILESOURCES:.c=.ro) -Llib -lsensors
+
+all-prog-conf-compile: $(PROGCONFCOMPILETARGETS)
+user :: all-prog-conf-compile
+
+install-prog-conf-compile: all-prog-conf-compile
+	$(MKDIR) $(DESTDIR)$(SBINDIR) $(DESTDIR)$(PROGCONFCOMPILEMAN8DIR)
+	$(INSTALL) -m 755 $(PROGCONFCOMPILETARGETS) $(DESTDIR)$(SBINDIR)
+	$(INSTALL) -m 644 $(PROGCONFCOMPILEMAN8FILES) $(DESTDIR)$(PROGCONFCOMPILEMAN8DIR)
+user_install :: install-prog-conf-compile
+
+user_uninstall::
+	$(RM) $(REMOVECONFCOMPILEBIN)
+	$(RM) $(REMOVECONFCOMPILEMAN)
+
+clean-prog-conf-compile:
+	$(RM) $(PROGCONFCOMPILEDIR)/*.rd $(PROGCONFCOMPILEDIR)/*.ro 
+	$(RM) $(PROGCONFCOMPILETARGETS)
+clean :: clean-prog-conf-compile
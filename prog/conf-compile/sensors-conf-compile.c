@@ -0,0 +1,117 @@
+/*
+    sensors-conf-compile.c - Part of lm_sensors, Linux kernel modules for
+                             hardware monitoring
+    Copyright (C) 2026  The lm-sensors developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include "lib/sensors.h"
+#include "lib/error.h"
+#include "version.h"
+
+#define PROGRAM			"sensors-conf-compile"
+#define VERSION			LM_VERSION
+
+static void print_short_help(void)
+{
+	printf("Try `%s -h' for more information\n", PROGRAM);
+}
+
+static void print_long_help(void)
+{
+	printf("Usage: %s [OPTION]...\n", PROGRAM);
+	puts("Compile the default libsensors configuration files into a binary image\n"
+	     "  -b, --boards DIR       Compile the configuration files under DIR into a\n"
+	     "                         board database instead\n"
+	     "  -o, --output FILE      Write to FILE instead of the default location\n"
+	     "  -h, --help             Display this help text\n"
+	     "  -v, --version          Display the program version\n");
+}
+
+static void print_version(void)
+{
+	printf("%s version %s with libsensors version %s\n", PROGRAM,
+	       VERSION, libsensors_version);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *output = NULL, *boards = NULL;
+	int c, err;
+	struct option long_opts[] =  {
+		{ "help", no_argument, NULL, 'h' },
+		{ "version", no_argument, NULL, 'v'},
+		{ "boards", required_argument, NULL, 'b' },
+		{ "output", required_argument, NULL, 'o' },
+		{ 0, 0, 0, 0 }
+	};
+
+	while (1) {
+		c = getopt_long(argc, argv, "hvb:o:", long_opts, NULL);
+		if (c == EOF)
+			break;
+		switch(c) {
+		case ':':
+		case '?':
+			print_short_help();
+			exit(1);
+		case 'h':
+			print_long_help();
+			exit(0);
+		case 'v':
+			print_version();
+			exit(0);
+		case 'b':
+			boards = optarg;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			fprintf(stderr,
+				"Internal error while parsing options!\n");
+			exit(1);
+		}
+	}
+
+	if (optind < argc) {
+		print_short_help();
+		exit(1);
+	}
+
+	if (boards) {
+		err = sensors_compile_boards(boards, output);
+		if (err) {
+			fprintf(stderr, "Failed to compile board database: %s\n",
+				sensors_strerror(err));
+			exit(1);
+		}
+	} else {
+		err = sensors_compile_config(output);
+		if (err) {
+			fprintf(stderr, "Failed to compile configuration: %s\n",
+				sensors_strerror(err));
+			exit(1);
+		}
+	}
+
+	return 0;
+}
@@ -38,14 +38,14 @@ static int loadConfig(const char *cfgPath, int reload)
 	int ret;
  	FILE *fp;
 
+	/* On reload, chips are not detected again, and the old
+	   configuration is kept if the new one fails to load */
+	if (reload)
+		sensorLog(LOG_INFO, "configuration reloading");
+
  	/* Load default configuration. */
  	if (!cfgPath) {
- 		if (reload) {
-			sensorLog(LOG_INFO, "configuration reloading");
-			sensors_cleanup();
-		}
-
- 		ret = sensors_init(NULL);
+ 		ret = reload ? sensors_reload_config(NULL) : sensors_init(NULL);
  		if (ret) {
  			sensorLog(LOG_ERR, "Error loading default"
  				  " configuration file: %s",
@@ -62,11 +62,7 @@ static int loadConfig(const char *cfgPath, int reload)
  		return -1;
  	}
 
-	if (reload) {
-		sensorLog(LOG_INFO, "configuration reloading");
-		sensors_cleanup();
-	}
- 	ret = sensors_init(fp);
+ 	ret = reload ? sensors_reload_config(fp) : sensors_init(fp);
  	if (ret) {
  		sensorLog(LOG_ERR, "Error loading sensors configuration file"
 			  " %s: %s", cfgPath, sensors_strerror(ret));
@@ -81,24 +77,31 @@ static int loadConfig(const char *cfgPath, int reload)
 int loadLib(const char *cfgPath)
 {
 	int ret;
+	sensors_set_fault_policy(FAULT_THRESHOLD, FAULT_MIN_MS, FAULT_MAX_MS);
 	ret = loadConfig(cfgPath, 0);
 	if (!ret)
 		ret = initKnownChips();
+	if (!ret)
+		watchAlarms();
 	return ret;
 }
 
 int reloadLib(const char *cfgPath)
 {
-	int ret;
+	int ret, err;
+	unwatchAlarms();
 	freeKnownChips();
+	/* If loading fails, the old configuration is still there */
 	ret = loadConfig(cfgPath, 1);
-	if (!ret)
-		ret = initKnownChips();
-	return ret;
+	err = initKnownChips();
+	if (!err)
+		watchAlarms();
+	return ret ? ret : err;
 }
 
 int unloadLib(void)
 {
+	unwatchAlarms();
 	freeKnownChips();
 	sensors_cleanup();
 	return 0;
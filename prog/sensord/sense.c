@@ -25,6 +25,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "args.h"
 #include "sensord.h"
@@ -66,6 +68,38 @@ static int idChip(const sensors_chip_name *chip)
 	return 0;
 }
 
+/* Report a read error. Attributes which keep failing are only reported
+   the first time, and when libsensors stops reading them. */
+static void read_error(const sensors_chip_name *chip, int num, int ret)
+{
+	sensors_fault_state state;
+
+	if (ret == -SENSORS_ERR_UNAVAILABLE)
+		return;
+
+	if (!sensors_get_fault_state(chip, num, &state) &&
+	    state.failures > 1) {
+		if (state.failures == FAULT_THRESHOLD)
+			sensorLog(LOG_WARNING, "Sensor data keeps failing: "
+				  "%s/#%d: %s, retrying in %d seconds",
+				  chip->prefix, num, sensors_strerror(ret),
+				  state.backoff_ms / 1000);
+		return;
+	}
+
+	sensorLog(LOG_ERR, "Error getting sensor data: %s/#%d: %s",
+		  chip->prefix, num, sensors_strerror(ret));
+}
+
+/* Skip a feature which could not be read, keeping the RRD columns
+   aligned */
+static int skip_feature(const FeatureDescriptor *feature, int action)
+{
+	if (action == DO_RRD && feature->rrd)
+		strcat(rrdBuff, ":U");
+	return 0;
+}
+
 static int get_flag(const sensors_chip_name *chip, int num)
 {
 	double val;
@@ -75,9 +109,10 @@ static int get_flag(const sensors_chip_name *chip, int num)
 		return 0;
 
 	ret = sensors_get_value(chip, num, &val);
+	if (ret == -SENSORS_ERR_UNAVAILABLE)
+		return 0;
 	if (ret) {
-		sensorLog(LOG_ERR, "Error getting sensor data: %s/#%d: %s",
-			  chip->prefix, num, sensors_strerror(ret));
+		read_error(chip, num, ret);
 		return -1;
 	}
 
@@ -95,19 +130,20 @@ static int do_features(const sensors_chip_name *chip,
 	/* If only scanning, take a quick exit if alarm is off */
 	alrm = get_flag(chip, feature->alarmNumber);
 	if (alrm == -1)
-		return -1;
+		return skip_feature(feature, action);
 	if (action == DO_SCAN && !alrm)
 		return 0;
 
 	for (i = 0; feature->dataNumbers[i] >= 0; i++) {
 		ret = sensors_get_value(chip, feature->dataNumbers[i],
 					val + i);
+		if (ret == -SENSORS_ERR_UNAVAILABLE) {
+			/* Already reported, skip this feature quietly */
+			return skip_feature(feature, action);
+		}
 		if (ret) {
-			sensorLog(LOG_ERR,
-				  "Error getting sensor data: %s/#%d: %s",
-				  chip->prefix, feature->dataNumbers[i],
-				  sensors_strerror(ret));
-			return -1;
+			read_error(chip, feature->dataNumbers[i], ret);
+			return skip_feature(feature, action);
 		}
 	}
 
@@ -126,7 +162,7 @@ static int do_features(const sensors_chip_name *chip,
 	/* For scanning and logging, we need extra information */
 	beep = get_flag(chip, feature->beepNumber);
 	if (beep == -1)
-		return -1;
+		return 0;
 
 	formatted = feature->format(val, alrm, beep);
 	if (!formatted) {
@@ -173,11 +209,10 @@ static int doKnownChip(const sensors_chip_name *chip,
 			return ret;
 	}
 
-	for (i = 0; features[i].format; i++) {
-		ret = do_features(chip, features + i, action);
-		if (ret == -1)
-			break;
-	}
+	/* Go on with the other features if one fails */
+	for (i = 0; features[i].format; i++)
+		if (do_features(chip, features + i, action))
+			ret = -1;
 
 	return ret;
 }
@@ -276,6 +311,60 @@ int setChips(void)
 	return ret;
 }
 
+static sensors_watch *alarmWatch;
+
+/* Watch the alarm subfeatures of all known chips, so that alarms can be
+   reported as soon as the driver notifies us */
+void watchAlarms(void)
+{
+	const FeatureDescriptor *features;
+	int i, j;
+
+	unwatchAlarms();
+	if (!sensord_args.scanTime)
+		return;
+
+	alarmWatch = sensors_watch_new();
+	if (!alarmWatch) {
+		sensorLog(LOG_NOTICE, "Error watching alarms, polling only");
+		return;
+	}
+
+	for (i = 0; knownChips[i].features; i++) {
+		features = knownChips[i].features;
+		for (j = 0; features[j].format; j++) {
+			/* Not all attributes support notifications */
+			if (features[j].alarmNumber >= 0)
+				sensors_watch_add(alarmWatch,
+						  knownChips[i].name,
+						  features[j].alarmNumber);
+		}
+	}
+}
+
+void unwatchAlarms(void)
+{
+	sensors_watch_free(alarmWatch);
+	alarmWatch = NULL;
+}
+
+/* Sleep for the given number of milliseconds, or until a watched alarm
+   changes. Returns 1 if an alarm changed, 0 otherwise. */
+int waitAlarms(int ms)
+{
+	sensors_value_request req[16];
+	struct timespec ts;
+
+	if (!alarmWatch) {
+		ts.tv_sec = ms / 1000;
+		ts.tv_nsec = (ms % 1000) * 1000000L;
+		nanosleep(&ts, NULL);
+		return 0;
+	}
+
+	return sensors_watch_wait(alarmWatch, ms, req, ARRAY_SIZE(req)) > 0;
+}
+
 /* TODO: loadavg entry */
 
 int rrdChips(void)
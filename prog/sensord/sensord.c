@@ -75,16 +75,27 @@ static void signalHandler(int sig)
 	}
 }
 
+/* Current time in milliseconds, which doesn't jump when the system clock
+   is set */
+static long long now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
 static int sensord(void)
 {
 	int ret = 0;
-	int scanValue = 0, logValue = 0;
+	/* Milliseconds until each task is due */
+	long long scanValue = 0, logValue = 0;
 	/*
 	 * First RRD update at next RRD timeslot to prevent failures due
 	 * one timeslot updated twice on restart for example.
 	 */
-	int rrdValue = sensord_args.rrdTime - time(NULL) %
-		sensord_args.rrdTime;
+	long long rrdValue = (sensord_args.rrdTime - time(NULL) %
+			      sensord_args.rrdTime) * 1000LL;
 
 	sensorLog(LOG_INFO, "sensord started");
 
@@ -100,13 +111,13 @@ static int sensord(void)
 			if ((ret = scanChips()))
 				sensorLog(LOG_NOTICE,
 					  "sensor scan error (%d)", ret);
-			scanValue += sensord_args.scanTime;
+			scanValue += sensord_args.scanTime * 1000LL;
 		}
 		if (sensord_args.logTime && (logValue <= 0)) {
 			if ((ret = readChips()))
 				sensorLog(LOG_NOTICE,
 					  "sensor read error (%d)", ret);
-			logValue += sensord_args.logTime;
+			logValue += sensord_args.logTime * 1000LL;
 		}
 		if (sensord_args.rrdTime && sensord_args.rrdFile &&
 		    (rrdValue <= 0)) {
@@ -118,17 +129,26 @@ static int sensord(void)
 			 * same method as in RRD instead of simply adding the
 			 * interval.
 			 */
-			rrdValue = sensord_args.rrdTime - time(NULL) %
-				sensord_args.rrdTime;
+			rrdValue = (sensord_args.rrdTime - time(NULL) %
+				    sensord_args.rrdTime) * 1000LL;
 		}
 		if (!done) {
-			int a = sensord_args.logTime ? logValue : INT_MAX;
-			int b = sensord_args.scanTime ? scanValue : INT_MAX;
-			int c = (sensord_args.rrdTime && sensord_args.rrdFile)
-				? rrdValue : INT_MAX;
-			int sleepTime = (a < b) ? ((a < c) ? a : c) :
+			long long a = sensord_args.logTime ? logValue : INT_MAX;
+			long long b = sensord_args.scanTime ? scanValue : INT_MAX;
+			long long c = (sensord_args.rrdTime &&
+				       sensord_args.rrdFile) ? rrdValue : INT_MAX;
+			long long sleepTime = (a < b) ? ((a < c) ? a : c) :
 				((b < c) ? b : c);
-			sleep(sleepTime);
+			long long start = now_ms();
+
+			if (sleepTime > INT_MAX)
+				sleepTime = INT_MAX;
+			if (sleepTime < 0)
+				sleepTime = 0;
+			/* Scan right away if an alarm goes off meanwhile */
+			if (waitAlarms(sleepTime))
+				scanValue = 0;
+			sleepTime = now_ms() - start;
 			scanValue -= sleepTime;
 			logValue -= sleepTime;
 			rrdValue -= sleepTime;
@@ -35,6 +35,13 @@ extern void freeChips(void);
 
 /* from lib.c */
 
+/* Stop reading attributes which failed this many times in a row, for
+   10 seconds at first and then twice as long after each failed retry,
+   up to 30 minutes */
+#define FAULT_THRESHOLD 3
+#define FAULT_MIN_MS 10000
+#define FAULT_MAX_MS (30 * 60 * 1000)
+
 extern int loadLib(const char *cfgPath);
 extern int reloadLib(const char *cfgPath);
 extern int unloadLib(void);
@@ -45,6 +52,9 @@ extern int readChips(void);
 extern int scanChips(void);
 extern int setChips(void);
 extern int rrdChips(void);
+extern void watchAlarms(void);
+extern void unwatchAlarms(void);
+extern int waitAlarms(int ms);
 
 /* from rrd.c */
 
@@ -39,6 +39,182 @@ static inline double deg_ctof(double cel)
 	return cel * (9.0F / 5.0F) + 32.0F;
 }
 
+/*
+ * In watch mode, the labels, and the limits unless asked otherwise, are
+ * only read for the first frame and printed from this cache afterwards.
+ * Inputs, alarms and faults, and the lowest, highest and average values,
+ * are read again for every frame.
+ */
+struct cached_value {
+	int read;		/* Non-zero once err and value are set */
+	int err;
+	double value;
+};
+
+struct chip_cache {
+	const sensors_chip_name *name;
+	int feature_count;
+	char **labels;		/* Indexed by feature number */
+	int subfeature_count;
+	struct cached_value *limits;	/* Indexed by subfeature number */
+};
+
+static struct chip_cache *chip_caches;
+static int chip_caches_count, cache_labels, cache_limits;
+
+void start_chip_cache(int limits)
+{
+	cache_labels = 1;
+	cache_limits = limits;
+}
+
+void free_chip_cache(void)
+{
+	int i, j;
+
+	for (i = 0; i < chip_caches_count; i++) {
+		for (j = 0; j < chip_caches[i].feature_count; j++)
+			free(chip_caches[i].labels[j]);
+		free(chip_caches[i].labels);
+		free(chip_caches[i].limits);
+	}
+	free(chip_caches);
+	chip_caches = NULL;
+	chip_caches_count = cache_labels = cache_limits = 0;
+}
+
+static void *zalloc(int count, size_t size)
+{
+	void *p;
+
+	p = calloc(count ? count : 1, size);
+	if (!p) {
+		perror("calloc");
+		exit(1);
+	}
+	return p;
+}
+
+static struct chip_cache *get_chip_cache(const sensors_chip_name *name)
+{
+	const sensors_feature *feature;
+	const sensors_subfeature *sub;
+	struct chip_cache *cache;
+	int i, a, b;
+
+	if (!cache_labels)
+		return NULL;
+
+	for (i = 0; i < chip_caches_count; i++)
+		if (chip_caches[i].name == name)
+			return &chip_caches[i];
+
+	chip_caches = realloc(chip_caches,
+			      (chip_caches_count + 1) * sizeof(*chip_caches));
+	if (!chip_caches) {
+		perror("realloc");
+		exit(1);
+	}
+	cache = &chip_caches[chip_caches_count++];
+	cache->name = name;
+	cache->feature_count = cache->subfeature_count = 0;
+
+	a = 0;
+	while ((feature = sensors_get_features(name, &a))) {
+		if (feature->number >= cache->feature_count)
+			cache->feature_count = feature->number + 1;
+		b = 0;
+		while ((sub = sensors_get_all_subfeatures(name, feature, &b)))
+			if (sub->number >= cache->subfeature_count)
+				cache->subfeature_count = sub->number + 1;
+	}
+	cache->labels = zalloc(cache->feature_count, sizeof(char *));
+	cache->limits = zalloc(cache->subfeature_count,
+			       sizeof(struct cached_value));
+
+	return cache;
+}
+
+/* Return the label of a feature, to be freed by the caller */
+static char *get_label(const sensors_chip_name *name,
+		       const sensors_feature *feature)
+{
+	struct chip_cache *cache;
+	char **label;
+
+	cache = get_chip_cache(name);
+	if (!cache)
+		return sensors_get_label(name, feature);
+
+	label = &cache->labels[feature->number];
+	if (!*label)
+		*label = sensors_get_label(name, feature);
+	return *label ? strdup(*label) : NULL;
+}
+
+static int is_limit(const sensors_subfeature *sub)
+{
+	switch (sub->type) {
+	case SENSORS_SUBFEATURE_IN_MIN:
+	case SENSORS_SUBFEATURE_IN_MAX:
+	case SENSORS_SUBFEATURE_IN_LCRIT:
+	case SENSORS_SUBFEATURE_IN_CRIT:
+	case SENSORS_SUBFEATURE_FAN_MIN:
+	case SENSORS_SUBFEATURE_FAN_MAX:
+	case SENSORS_SUBFEATURE_FAN_DIV:
+	case SENSORS_SUBFEATURE_FAN_PULSES:
+	case SENSORS_SUBFEATURE_TEMP_MAX:
+	case SENSORS_SUBFEATURE_TEMP_MAX_HYST:
+	case SENSORS_SUBFEATURE_TEMP_MIN:
+	case SENSORS_SUBFEATURE_TEMP_MIN_HYST:
+	case SENSORS_SUBFEATURE_TEMP_CRIT:
+	case SENSORS_SUBFEATURE_TEMP_CRIT_HYST:
+	case SENSORS_SUBFEATURE_TEMP_LCRIT:
+	case SENSORS_SUBFEATURE_TEMP_LCRIT_HYST:
+	case SENSORS_SUBFEATURE_TEMP_EMERGENCY:
+	case SENSORS_SUBFEATURE_TEMP_EMERGENCY_HYST:
+	case SENSORS_SUBFEATURE_TEMP_TYPE:
+	case SENSORS_SUBFEATURE_TEMP_OFFSET:
+	case SENSORS_SUBFEATURE_POWER_CAP:
+	case SENSORS_SUBFEATURE_POWER_CAP_HYST:
+	case SENSORS_SUBFEATURE_POWER_MAX:
+	case SENSORS_SUBFEATURE_POWER_CRIT:
+	case SENSORS_SUBFEATURE_POWER_MIN:
+	case SENSORS_SUBFEATURE_POWER_LCRIT:
+	case SENSORS_SUBFEATURE_POWER_AVERAGE_INTERVAL:
+	case SENSORS_SUBFEATURE_CURR_MIN:
+	case SENSORS_SUBFEATURE_CURR_MAX:
+	case SENSORS_SUBFEATURE_CURR_LCRIT:
+	case SENSORS_SUBFEATURE_CURR_CRIT:
+	case SENSORS_SUBFEATURE_BEEP_ENABLE:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* Read the value of a subfeature, or get it from the cache if it is a
+   limit which was read already. Returns 0 on success, and <0 on error. */
+static int read_value(const sensors_chip_name *name,
+		      const sensors_subfeature *sub, double *val)
+{
+	struct chip_cache *cache;
+	struct cached_value *limit;
+
+	cache = get_chip_cache(name);
+	if (!cache || !cache_limits || !is_limit(sub))
+		return sensors_get_value(name, sub->number, val);
+
+	limit = &cache->limits[sub->number];
+	if (!limit->read) {
+		limit->err = sensors_get_value(name, sub->number,
+					       &limit->value);
+		limit->read = 1;
+	}
+	*val = limit->value;
+	return limit->err;
+}
+
 void print_chip_raw(const sensors_chip_name *name)
 {
 	int a, b, err;
@@ -49,7 +225,7 @@ void print_chip_raw(const sensors_chip_name *name)
 
 	a = 0;
 	while ((feature = sensors_get_features(name, &a))) {
-		if (!(label = sensors_get_label(name, feature))) {
+		if (!(label = get_label(name, feature))) {
 			fprintf(stderr, "ERROR: Can't get label of feature "
 				"%s!\n", feature->name);
 			continue;
@@ -59,8 +235,7 @@ void print_chip_raw(const sensors_chip_name *name)
 		b = 0;
 		while ((sub = sensors_get_all_subfeatures(name, feature, &b))) {
 			if (sub->flags & SENSORS_MODE_R) {
-				if ((err = sensors_get_value(name, sub->number,
-							     &val)))
+				if ((err = read_value(name, sub, &val)))
 					fprintf(stderr, "ERROR: Can't get "
 						"value of subfeature %s: %s\n",
 						sub->name,
@@ -88,7 +263,7 @@ void print_chip_json(const sensors_chip_name *name)
 	a = 0;
 	cnt = 0;
 	while ((feature = sensors_get_features(name, &a))) {
-		if (!(label = sensors_get_label(name, feature))) {
+		if (!(label = get_label(name, feature))) {
 			fprintf(stderr, "ERROR: Can't get label of feature "
 				"%s!\n", feature->name);
 			continue;
@@ -101,8 +276,7 @@ void print_chip_json(const sensors_chip_name *name)
 		subCnt = 0;
 		while ((sub = sensors_get_all_subfeatures(name, feature, &b))) {
 			if (sub->flags & SENSORS_MODE_R) {
-				if ((err = sensors_get_value(name, sub->number,
-							     &val))) {
+				if ((err = read_value(name, sub, &val))) {
 					fprintf(stderr, "ERROR: Can't get "
 						"value of subfeature %s: %s\n",
 						sub->name,
@@ -143,7 +317,7 @@ static double get_value(const sensors_chip_name *name,
 	double val;
 	int err;
 
-	err = sensors_get_value(name, sub->number, &val);
+	err = read_value(name, sub, &val);
 	if (err) {
 		fprintf(stderr, "ERROR: Can't get value of subfeature %s: %s\n",
 			sub->name, sensors_strerror(err));
@@ -159,7 +333,7 @@ static int get_input_value(const sensors_chip_name *name,
 {
 	int err;
 
-	err = sensors_get_value(name, sub->number, val);
+	err = read_value(name, sub, val);
 	if (err && err != -SENSORS_ERR_ACCESS_R) {
 		fprintf(stderr, "ERROR: Can't get value of subfeature %s: %s\n",
 			sub->name, sensors_strerror(err));
@@ -176,7 +350,7 @@ static int get_label_size(const sensors_chip_name *name)
 
 	i = 0;
 	while ((iter = sensors_get_features(name, &i))) {
-		if ((label = sensors_get_label(name, iter)) &&
+		if ((label = get_label(name, iter)) &&
 		    strlen(label) > max_size)
 			max_size = strlen(label);
 		free(label);
@@ -357,7 +531,7 @@ static void print_chip_temp(const sensors_chip_name *name,
 	char *label;
 	int i;
 
-	if (!(label = sensors_get_label(name, feature))) {
+	if (!(label = get_label(name, feature))) {
 		fprintf(stderr, "ERROR: Can't get label of feature %s!\n",
 			feature->name);
 		return;
@@ -446,7 +620,7 @@ static void print_chip_in(const sensors_chip_name *name,
 	int sensor_count, alarm_count;
 	double val;
 
-	if (!(label = sensors_get_label(name, feature))) {
+	if (!(label = get_label(name, feature))) {
 		fprintf(stderr, "ERROR: Can't get label of feature %s!\n",
 			feature->name);
 		return;
@@ -481,7 +655,7 @@ static void print_chip_fan(const sensors_chip_name *name,
 	double val;
 	char *label;
 
-	if (!(label = sensors_get_label(name, feature))) {
+	if (!(label = get_label(name, feature))) {
 		fprintf(stderr, "ERROR: Can't get label of feature %s!\n",
 			feature->name);
 		return;
@@ -624,7 +798,7 @@ static void print_chip_power(const sensors_chip_name *name,
 	const char *unit;
 	int i;
 
-	if (!(label = sensors_get_label(name, feature))) {
+	if (!(label = get_label(name, feature))) {
 		fprintf(stderr, "ERROR: Can't get label of feature %s!\n",
 			feature->name);
 		return;
@@ -692,7 +866,7 @@ static void print_chip_energy(const sensors_chip_name *name,
 	char *label;
 	const char *unit;
 
-	if (!(label = sensors_get_label(name, feature))) {
+	if (!(label = get_label(name, feature))) {
 		fprintf(stderr, "ERROR: Can't get label of feature %s!\n",
 			feature->name);
 		return;
@@ -725,8 +899,8 @@ static void print_chip_vid(const sensors_chip_name *name,
 	if (!subfeature)
 		return;
 
-	if ((label = sensors_get_label(name, feature))
-	 && !sensors_get_value(name, subfeature->number, &vid)) {
+	if ((label = get_label(name, feature))
+	 && !read_value(name, subfeature, &vid)) {
 		print_label(label, label_size);
 		printf("%+6.3f V\n", vid);
 	}
@@ -746,8 +920,8 @@ static void print_chip_humidity(const sensors_chip_name *name,
 	if (!subfeature)
 		return;
 
-	if ((label = sensors_get_label(name, feature))
-	 && !sensors_get_value(name, subfeature->number, &humidity)) {
+	if ((label = get_label(name, feature))
+	 && !read_value(name, subfeature, &humidity)) {
 		print_label(label, label_size);
 		printf("%6.1f %%RH\n", humidity);
 	}
@@ -767,8 +941,8 @@ static void print_chip_beep_enable(const sensors_chip_name *name,
 	if (!subfeature)
 		return;
 
-	if ((label = sensors_get_label(name, feature))
-	 && !sensors_get_value(name, subfeature->number, &beep_enable)) {
+	if ((label = get_label(name, feature))
+	 && !read_value(name, subfeature, &beep_enable)) {
 		print_label(label, label_size);
 		printf("%s\n", beep_enable ? "enabled" : "disabled");
 	}
@@ -806,7 +980,7 @@ static void print_chip_curr(const sensors_chip_name *name,
 	struct sensor_subfeature_data alarms[NUM_CURR_ALARMS];
 	int sensor_count, alarm_count;
 
-	if (!(label = sensors_get_label(name, feature))) {
+	if (!(label = get_label(name, feature))) {
 		fprintf(stderr, "ERROR: Can't get label of feature %s!\n",
 			feature->name);
 		return;
@@ -846,8 +1020,8 @@ static void print_chip_intrusion(const sensors_chip_name *name,
 	if (!subfeature)
 		return;
 
-	if ((label = sensors_get_label(name, feature))
-	 && !sensors_get_value(name, subfeature->number, &alarm)) {
+	if ((label = get_label(name, feature))
+	 && !read_value(name, subfeature, &alarm)) {
 		print_label(label, label_size);
 		printf("%s\n", alarm ? "ALARM" : "OK");
 	}
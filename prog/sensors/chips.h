@@ -47,6 +47,11 @@ struct sensor_subfeature_list {
 	const char *name;	/* subfeature name to be printed */
 };
 
+/* Only read the labels, and the limits if limits is set, the first time
+   each chip is printed */
+void start_chip_cache(int limits);
+void free_chip_cache(void);
+
 void print_chip_raw(const sensors_chip_name *name);
 void print_chip_json(const sensors_chip_name *name);
 void print_chip(const sensors_chip_name *name);
@@ -24,8 +24,12 @@
 #include <getopt.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <locale.h>
 #include <langinfo.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
 
 #ifndef __UCLIBC__
 #include <iconv.h>
@@ -36,12 +40,16 @@
 #include "lib/error.h"
 #include "main.h"
 #include "chips.h"
+#include "profile.h"
 #include "version.h"
 
 #define PROGRAM			"sensors"
 #define VERSION			LM_VERSION
 
-static int do_sets, do_raw, do_json, hide_adapter;
+static int do_sets, do_raw, do_json, hide_adapter, do_stats, do_profile;
+static int watch_limits;
+static double watch_interval;	/* In seconds, 0 if not watching */
+static volatile sig_atomic_t watch_stop;
 
 int fahrenheit;
 char degstr[5]; /* store the correct string to print degrees */
@@ -64,6 +72,13 @@ static void print_long_help(void)
 	     "  -j                     Json output\n"
 	     "  -v, --version          Display the program version\n"
 	     "  -n, --allow-no-sensors Do not fail if no sensors found\n"
+	     "      --stats            Print libsensors statistics at exit\n"
+	     "      --profile[=N]      Read all values N times (default 10) and\n"
+	     "                         report the slowest ones\n"
+	     "      --watch[=N]        Print the values again every N seconds\n"
+	     "                         (default 2) until interrupted\n"
+	     "      --watch-limits     Read the limits again for every --watch\n"
+	     "                         refresh\n"
 	     "\n"
 	     "Use `-' after `-c' to read the config file from stdin.\n"
 	     "If no chips are specified, all chip info will be printed.\n"
@@ -224,7 +239,9 @@ static int do_the_real_work(const sensors_chip_name *match, int *err)
 		printf("{\n");
 	chip_nr = 0;
 	while ((chip = sensors_get_detected_chips(match, &chip_nr))) {
-		if (do_sets) {
+		if (do_profile) {
+			profile_chip(chip);
+		} else if (do_sets) {
 			if (do_a_set(chip))
 				*err = 1;
 		} else {
@@ -269,10 +286,186 @@ static void print_bus_list(void)
 	}
 }
 
+/* Print a duration in nanoseconds with a readable unit */
+static void print_ns(FILE *f, unsigned long long ns)
+{
+	if (ns >= 10000000ULL)
+		fprintf(f, "%llu ms", ns / 1000000);
+	else if (ns >= 10000ULL)
+		fprintf(f, "%llu us", ns / 1000);
+	else
+		fprintf(f, "%llu ns", ns);
+}
+
+static void print_stats_values(FILE *f, const sensors_stats *stats)
+{
+	unsigned long long errors = 0;
+	int i;
+
+	for (i = 0; i < SENSORS_STATS_ERRORS; i++)
+		errors += stats->read_errors[i];
+	fprintf(f, "%llu read (%llu failed), %llu written, "
+		"%llu expressions\n", stats->values_read, errors,
+		stats->values_written, stats->evals);
+}
+
+/* Print the library statistics to stderr, so that they don't get in the
+   way of the regular or JSON output */
+static void print_stats(void)
+{
+	const sensors_chip_name *chip;
+	sensors_stats stats;
+	int i, chip_nr;
+
+	stats.version = SENSORS_STATS_VERSION;
+	if (sensors_get_stats(NULL, &stats))
+		return;
+
+	fprintf(stderr, "libsensors statistics:\n  Discovery:      ");
+	print_ns(stderr, stats.discovery_ns);
+	fprintf(stderr, "\n  Configuration:  ");
+	print_ns(stderr, stats.config_ns);
+	fprintf(stderr, "\n  Config lookups: %llu\n"
+		"  Files:          %llu opened, %llu read, %llu written, "
+		"%llu bytes read\n  Values:         ",
+		stats.config_lookups, stats.opens, stats.reads,
+		stats.writes, stats.bytes_read);
+	print_stats_values(stderr, &stats);
+
+	for (i = 0; i < SENSORS_STATS_ERRORS; i++)
+		if (stats.read_errors[i])
+			fprintf(stderr, "  Read errors:    %llu %s\n",
+				stats.read_errors[i],
+				i ? sensors_strerror(-i) : "other");
+
+	for (i = 0; i < SENSORS_STATS_LATENCY_BUCKETS; i++) {
+		if (!stats.read_latency[i])
+			continue;
+		if (i == SENSORS_STATS_LATENCY_BUCKETS - 1) {
+			fprintf(stderr, "  Read latency:   ");
+			print_ns(stderr, 1ULL << i);
+			fprintf(stderr, " or more");
+		} else {
+			fprintf(stderr, "  Read latency:   under ");
+			print_ns(stderr, 2ULL << i);
+		}
+		fprintf(stderr, ": %llu\n", stats.read_latency[i]);
+	}
+
+	chip_nr = 0;
+	while ((chip = sensors_get_detected_chips(NULL, &chip_nr))) {
+		if (sensors_get_stats(chip, &stats))
+			continue;
+		fprintf(stderr, "  %s: discovered in ", sprintf_chip_name(chip));
+		print_ns(stderr, stats.discovery_ns);
+		fprintf(stderr, ", ");
+		print_stats_values(stderr, &stats);
+	}
+}
+
+/* Print the chips matching the given names, or all chips if there are no
+   names. Returns 0 on success, and an exit error code otherwise. */
+static int print_chips(const sensors_chip_name *chips, int chips_count,
+		       int allow_no_sensors)
+{
+	int i, cnt = 0, err = 0;
+
+	if (!chips_count) { /* No chip name on command line */
+		if (!do_the_real_work(NULL, &err)) {
+			fprintf(stderr,
+				"No sensors found!\n"
+				"Make sure you loaded all the kernel drivers you need.\n"
+				"Try sensors-detect to find out which these are.\n");
+			if (!allow_no_sensors) {
+				err = 1;
+			}
+		}
+	} else {
+		for (i = 0; i < chips_count; i++)
+			cnt += do_the_real_work(&chips[i], &err);
+
+		if (!cnt) {
+			fprintf(stderr, "Specified sensor(s) not found!\n");
+			err = 1;
+		}
+	}
+
+	return err;
+}
+
+static long long now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void stop_watching(int sig)
+{
+	(void)sig;
+	watch_stop = 1;
+}
+
+/* Print the chips every watch_interval seconds until interrupted. The
+   library is only initialized once and keeps the attribute files open, and
+   labels and limits are only read once, so that each refresh is cheap. On
+   a terminal, each refresh is drawn over the previous one, otherwise they
+   follow each other. Returns 0 on success, and an exit error code
+   otherwise. */
+static int watch_chips(const sensors_chip_name *chips, int chips_count,
+		       int allow_no_sensors)
+{
+	struct sigaction sa;
+	struct timespec ts;
+	long long next, now, interval_ns;
+	int tty, err = 0;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = stop_watching;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	/* Write each refresh at once, so that it doesn't flicker */
+	setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+	tty = isatty(STDOUT_FILENO);
+	sensors_set_keep_open(1);
+	start_chip_cache(!watch_limits);
+
+	interval_ns = watch_interval * 1e9;
+	next = now_ns();
+	while (!watch_stop) {
+		if (tty)	/* Cursor home, clear screen */
+			fputs("\033[H\033[J", stdout);
+		err = print_chips(chips, chips_count, allow_no_sensors);
+		if (fflush(stdout) == EOF) {
+			perror("stdout");
+			err = 1;
+		}
+		if (err)
+			break;
+
+		/* Don't try to catch up after falling behind */
+		next += interval_ns;
+		now = now_ns();
+		if (next < now)
+			next = now;
+		ts.tv_sec = next / 1000000000;
+		ts.tv_nsec = next % 1000000000;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+	}
+
+	free_chip_cache();
+	return err;
+}
+
 int main(int argc, char *argv[])
 {
-	int c, i, err, do_bus_list, allow_no_sensors;
+	int c, i, err, do_bus_list, allow_no_sensors, chips_count;
 	const char *config_file_name = NULL;
+	sensors_chip_name *chips = NULL;
+	char *end;
+	long count;
 
 	struct option long_opts[] =  {
 		{ "help", no_argument, NULL, 'h' },
@@ -283,6 +476,10 @@ int main(int argc, char *argv[])
 		{ "config-file", required_argument, NULL, 'c' },
 		{ "bus-list", no_argument, NULL, 'B' },
 		{ "allow-no-sensors", no_argument, NULL, 'n' },
+		{ "stats", no_argument, NULL, 'S' },
+		{ "profile", optional_argument, NULL, 'P' },
+		{ "watch", optional_argument, NULL, 'W' },
+		{ "watch-limits", no_argument, NULL, 'L' },
 		{ 0, 0, 0, 0 }
 	};
 
@@ -333,6 +530,32 @@ int main(int argc, char *argv[])
 		case 'n':
 			allow_no_sensors = 1;
 			break;
+		case 'S':
+			do_stats = 1;
+			break;
+		case 'P':
+			count = optarg ? strtol(optarg, &end, 10) : 10;
+			if (optarg && (end == optarg || *end || count < 1 ||
+				       count > INT_MAX)) {
+				fprintf(stderr, "Invalid profile count `%s'\n",
+					optarg);
+				exit(1);
+			}
+			do_profile = count;
+			do_json = 0;
+			break;
+		case 'W':
+			watch_interval = optarg ? strtod(optarg, &end) : 2;
+			if (optarg && (end == optarg || *end ||
+				       !(watch_interval >= 0.1))) {
+				fprintf(stderr, "Invalid watch interval `%s'\n",
+					optarg);
+				exit(1);
+			}
+			break;
+		case 'L':
+			watch_limits = 1;
+			break;
 		default:
 			fprintf(stderr,
 				"Internal error while parsing options!\n");
@@ -340,6 +563,12 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (watch_interval && (do_sets || do_bus_list || do_profile)) {
+		fprintf(stderr, "Option --watch can't be used with -s, "
+			"--bus-list or --profile\n");
+		exit(1);
+	}
+
 	err = read_config_file(config_file_name);
 	if (err)
 		exit(err);
@@ -349,40 +578,44 @@ int main(int argc, char *argv[])
 
 	if (do_bus_list) {
 		print_bus_list();
-	} else if (optind == argc) { /* No chip name on command line */
-		if (!do_the_real_work(NULL, &err)) {
-			fprintf(stderr,
-				"No sensors found!\n"
-				"Make sure you loaded all the kernel drivers you need.\n"
-				"Try sensors-detect to find out which these are.\n");
-			if (!allow_no_sensors) {
-				err = 1;
-			}
-		}
-	} else {
-		int cnt = 0;
-		sensors_chip_name chip;
-
-		for (i = optind; i < argc; i++) {
-			if (sensors_parse_chip_name(argv[i], &chip)) {
-				fprintf(stderr,
-					"Parse error in chip name `%s'\n",
-					argv[i]);
-				print_short_help();
-				err = 1;
-				goto exit;
-			}
-			cnt += do_the_real_work(&chip, &err);
-			sensors_free_chip_name(&chip);
-		}
+		goto exit;
+	}
 
-		if (!cnt) {
-			fprintf(stderr, "Specified sensor(s) not found!\n");
+	chips_count = argc - optind;
+	if (chips_count) {
+		chips = malloc(chips_count * sizeof(sensors_chip_name));
+		if (!chips) {
+			perror("malloc");
+			err = 1;
+			goto exit;
+		}
+	}
+	for (i = 0; i < chips_count; i++) {
+		if (sensors_parse_chip_name(argv[optind + i], &chips[i])) {
+			fprintf(stderr, "Parse error in chip name `%s'\n",
+				argv[optind + i]);
+			print_short_help();
+			chips_count = i;
 			err = 1;
+			goto free_chips;
 		}
 	}
 
+	if (watch_interval)
+		err = watch_chips(chips, chips_count, allow_no_sensors);
+	else
+		err = print_chips(chips, chips_count, allow_no_sensors);
+
+	if (do_profile && !err)
+		print_profile(do_profile);
+
+free_chips:
+	for (i = 0; i < chips_count; i++)
+		sensors_free_chip_name(&chips[i]);
+	free(chips);
 exit:
+	if (do_stats)
+		print_stats();
 	sensors_cleanup();
 	exit(err);
 }
@@ -0,0 +1,322 @@
+/*
+    profile.c - Part of sensors, a user-space program for hardware monitoring
+    Copyright (C) 2026  The lm-sensors developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "profile.h"
+#include "lib/sensors.h"
+#include "lib/error.h"
+
+/* Number of slowest attributes listed in the report */
+#define REPORT_ATTRS		20
+
+/* Attributes slower than this should be read less often, and attributes
+   slower than that should rather not be read at all, in nanoseconds */
+#define SLOW_NS			10000000LL
+#define VERY_SLOW_NS		100000000LL
+
+/* Read times of a single attribute */
+struct profile_attr {
+	const sensors_chip_name *chip;
+	int chip_index;		/* In chips */
+	const char *feature;
+	const char *name;
+	int number;		/* Subfeature number */
+	int errors;		/* Number of failed reads */
+	int err;		/* Last error */
+	long long *ns;		/* Time of each read */
+	long long first;	/* Time of the first read, which drivers
+				   can't have cached */
+	long long median, p90, max;
+};
+
+/* Read times of a chip, sums over its attributes */
+struct profile_chip {
+	const sensors_chip_name *chip;
+	int attrs;
+	long long first;	/* Of the first reads */
+	long long total;	/* Of the medians */
+};
+
+static struct profile_attr *attrs;
+static int attrs_count, attrs_max;
+static struct profile_chip *chips;
+static int chips_count, chips_max;
+
+static void *grow(void *array, int count, int *max, size_t size)
+{
+	if (count < *max)
+		return array;
+	*max = *max ? *max * 2 : 16;
+	array = realloc(array, *max * size);
+	if (!array) {
+		perror("realloc");
+		exit(1);
+	}
+	return array;
+}
+
+static long long now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static int cmp_ll(const void *a, const void *b)
+{
+	long long x = *(const long long *)a, y = *(const long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int cmp_attr(const void *a, const void *b)
+{
+	const struct profile_attr *x = a, *y = b;
+
+	return x->median < y->median ? 1 : x->median > y->median ? -1 : 0;
+}
+
+static int cmp_chip(const void *a, const void *b)
+{
+	const struct profile_chip *x = a, *y = b;
+
+	return x->total < y->total ? 1 : x->total > y->total ? -1 : 0;
+}
+
+static const char *chip_name(const sensors_chip_name *name)
+{
+	static char buf[200];
+
+	if (sensors_snprintf_chip_name(buf, sizeof(buf), name) < 0)
+		return "unknown";
+	return buf;
+}
+
+/* Print a duration in nanoseconds with 3 significant digits or so */
+static void print_duration(long long ns)
+{
+	if (ns >= 1000000000)
+		printf("%8.2f s ", ns / 1e9);
+	else if (ns >= 1000000)
+		printf("%8.2f ms", ns / 1e6);
+	else
+		printf("%8.2f us", ns / 1e3);
+}
+
+void profile_chip(const sensors_chip_name *name)
+{
+	const sensors_feature *feature;
+	const sensors_subfeature *sub;
+	struct profile_attr *attr;
+	struct profile_chip *chip;
+	int a, b;
+
+	chips = grow(chips, chips_count, &chips_max, sizeof(*chips));
+	chip = &chips[chips_count++];
+	memset(chip, 0, sizeof(*chip));
+	chip->chip = name;
+
+	a = 0;
+	while ((feature = sensors_get_features(name, &a))) {
+		b = 0;
+		while ((sub = sensors_get_all_subfeatures(name, feature, &b))) {
+			if (!(sub->flags & SENSORS_MODE_R))
+				continue;
+
+			attrs = grow(attrs, attrs_count, &attrs_max,
+				     sizeof(*attrs));
+			attr = &attrs[attrs_count++];
+			memset(attr, 0, sizeof(*attr));
+			attr->chip = name;
+			attr->chip_index = chips_count - 1;
+			attr->feature = feature->name;
+			attr->name = sub->name;
+			attr->number = sub->number;
+			chip->attrs++;
+		}
+	}
+}
+
+/* Read all attributes once per round, rather than each attribute count
+   times in a row, so that values which drivers cache for a while are
+   not mostly read back from the cache */
+static void profile_rounds(int count)
+{
+	struct profile_attr *attr;
+	long long start;
+	double val;
+	int i, j, err;
+
+	for (j = 0; j < attrs_count; j++) {
+		attrs[j].ns = malloc(count * sizeof(long long));
+		if (!attrs[j].ns) {
+			perror("malloc");
+			exit(1);
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < attrs_count; j++) {
+			attr = &attrs[j];
+			start = now_ns();
+			err = sensors_get_value(attr->chip, attr->number, &val);
+			attr->ns[i] = now_ns() - start;
+			if (err) {
+				attr->errors++;
+				attr->err = err;
+			}
+		}
+	}
+
+	for (j = 0; j < attrs_count; j++) {
+		attr = &attrs[j];
+		attr->first = attr->ns[0];
+		qsort(attr->ns, count, sizeof(long long), cmp_ll);
+		attr->median = attr->ns[count / 2];
+		attr->p90 = attr->ns[(count * 9) / 10];
+		attr->max = attr->ns[count - 1];
+		free(attr->ns);
+		attr->ns = NULL;
+
+		chips[attr->chip_index].first += attr->first;
+		chips[attr->chip_index].total += attr->median;
+	}
+}
+
+static int should_ignore(const struct profile_attr *attr, int count)
+{
+	return attr->errors == count || attr->median >= VERY_SLOW_NS;
+}
+
+/* Check whether the feature of attribute i is already ignored because of
+   a previous attribute */
+static int ignored_before(int i, int count)
+{
+	int j;
+
+	for (j = 0; j < i; j++)
+		if (attrs[j].chip == attrs[i].chip &&
+		    !strcmp(attrs[j].feature, attrs[i].feature) &&
+		    should_ignore(&attrs[j], count))
+			return 1;
+	return 0;
+}
+
+/* Print a configuration file fragment which ignores the features with an
+   attribute which is very slow or never works, and points at the ones
+   which should be read less often. Attributes are sorted by decreasing
+   median read time. */
+static void print_suggested_config(int count)
+{
+	const sensors_chip_name *chip;
+	const struct profile_attr *attr;
+	int c, i, header, any = 0;
+
+	for (c = 0; c < chips_count; c++) {
+		chip = chips[c].chip;
+		header = 0;
+		for (i = 0; i < attrs_count; i++) {
+			attr = &attrs[i];
+			if (attr->chip != chip)
+				continue;
+			if (attr->median < SLOW_NS && attr->errors < count)
+				continue;
+
+			if (should_ignore(attr, count) &&
+			    ignored_before(i, count))
+				continue;
+
+			if (!header) {
+				printf("chip \"%s\"\n", chip_name(chip));
+				header = any = 1;
+			}
+			if (attr->errors == count) {
+				printf("    # %s never reads: %s\n",
+				       attr->name, sensors_strerror(attr->err));
+				printf("    ignore %s\n", attr->feature);
+			} else if (attr->median >= VERY_SLOW_NS) {
+				printf("    # %s takes %lld ms to read\n",
+				       attr->name, attr->median / 1000000);
+				printf("    ignore %s\n", attr->feature);
+			} else {
+				printf("    # %s takes %lld ms to read, "
+				       "poll it less often\n", attr->name,
+				       attr->median / 1000000);
+			}
+		}
+		if (header)
+			printf("\n");
+	}
+	if (!any)
+		printf("# All attributes are fast enough\n");
+}
+
+void print_profile(int count)
+{
+	const struct profile_attr *attr;
+	int i;
+
+	profile_rounds(count);
+	qsort(chips, chips_count, sizeof(*chips), cmp_chip);
+	qsort(attrs, attrs_count, sizeof(*attrs), cmp_attr);
+
+	printf("Chips by time to read all attributes once (%d reads each, "
+	       "median and first):\n", count);
+	for (i = 0; i < chips_count; i++) {
+		printf("  ");
+		print_duration(chips[i].total);
+		printf(" ");
+		print_duration(chips[i].first);
+		printf("  %-32s %d attributes\n", chip_name(chips[i].chip),
+		       chips[i].attrs);
+	}
+
+	printf("\nSlowest attributes:\n"
+	       "  %-32s %-20s %11s %11s %11s %11s %s\n",
+	       "Chip", "Attribute", "First", "Median", "90%", "Max", "Errors");
+	for (i = 0; i < attrs_count && i < REPORT_ATTRS; i++) {
+		attr = &attrs[i];
+		printf("  %-32s %-20s ", chip_name(attr->chip), attr->name);
+		print_duration(attr->first);
+		printf(" ");
+		print_duration(attr->median);
+		printf(" ");
+		print_duration(attr->p90);
+		printf(" ");
+		print_duration(attr->max);
+		printf(" %d\n", attr->errors);
+	}
+	if (attrs_count > REPORT_ATTRS)
+		printf("  (%d more)\n", attrs_count - REPORT_ATTRS);
+
+	printf("\n# Suggested configuration\n");
+	print_suggested_config(count);
+
+	free(attrs);
+	free(chips);
+	attrs = NULL;
+	chips = NULL;
+	attrs_count = attrs_max = chips_count = chips_max = 0;
+}
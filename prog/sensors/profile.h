@@ -0,0 +1,34 @@
+/*
+    profile.h - Part of sensors, a user-space program for hardware monitoring
+    Copyright (C) 2026  The lm-sensors developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+    MA 02110-1301 USA.
+*/
+
+#ifndef PROG_SENSORS_PROFILE_H
+#define PROG_SENSORS_PROFILE_H
+
+#include "lib/sensors.h"
+
+/* Add every readable subfeature of a chip to the ones to profile */
+void profile_chip(const sensors_chip_name *name);
+
+/* Read the subfeatures added so far count times, and print the chips and
+   attributes slowest first, and a suggested configuration for the
+   slowest ones */
+void print_profile(int count);
+
+#endif /* def PROG_SENSORS_PROFILE_H */